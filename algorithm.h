@@ -1,72 +1,606 @@
 #pragma once
 #include "heap.h"
+#include "loser_tree.h"
+#include "mapped_file.h"
+#include "parallel.h"
+#include "simd_sort.h"
+#include <cstddef>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
 
 namespace cym {
 
     template <typename T>
     void swap(T& t1, T& t2) {
-        T tmp = t1;
-        t1 = t2;
-        t2 = tmp;
+        T tmp = std::move(t1);
+        t1 = std::move(t2);
+        t2 = std::move(tmp);
     }
 
+    struct less {
+        template <typename A, typename B>
+        bool operator()(const A& a, const B& b) const {
+            return a < b;
+        }
+    };
+
+    struct greater {
+        template <typename A, typename B>
+        bool operator()(const A& a, const B& b) const {
+            return b < a;
+        }
+    };
+
     class sort {
-      public:
-        template <typename T>
-        static void quick_sort(T arr[], const int first, const int last) {
-            swap(arr[first], arr[(first + last) / 2]);
-            int lb = first + 1;
-            int hb = last;
+      private:
+        using diff_t = std::ptrdiff_t;
+
+        static constexpr diff_t insertion_sort_threshold = 24;
+        static constexpr diff_t ninther_threshold = 128;
+        static constexpr diff_t partial_insertion_sort_limit = 8;
+        static constexpr diff_t block_size = 64;
+        static constexpr diff_t cacheline_size = 64;
+
+        template <typename Iter>
+        struct partition_result {
+            Iter pivot;
+            bool already_partitioned;
+        };
+
+        static int _log2(diff_t n) {
+            int log = 0;
+            while (n >>= 1) {
+                ++log;
+            }
+            return log;
+        }
+
+        template <typename Iter>
+        static void _reverse(Iter first, Iter last) {
+            while (first < last) {
+                cym::swap(*first++, *--last);
+            }
+        }
+
+        template <typename Iter, typename Compare>
+        static void _insertion_sort(Iter begin, Iter end, Compare comp) {
+            if (begin == end) {
+                return;
+            }
+            for (Iter cur = begin + 1; cur != end; ++cur) {
+                Iter sift = cur;
+                Iter sift_1 = cur - 1;
+                if (comp(*sift, *sift_1)) {
+                    auto tmp = std::move(*sift);
+                    do {
+                        *sift-- = std::move(*sift_1);
+                    } while (sift != begin && comp(tmp, *--sift_1));
+                    *sift = std::move(tmp);
+                }
+            }
+        }
+
+        /**
+         * 要求`begin - 1`处存在一个不大于区间内任何元素的元素作为哨兵，
+         * 因此内层循环不需要检查边界。
+         */
+        template <typename Iter, typename Compare>
+        static void _unguarded_insertion_sort(Iter begin, Iter end,
+                                              Compare comp) {
+            if (begin == end) {
+                return;
+            }
+            for (Iter cur = begin + 1; cur != end; ++cur) {
+                Iter sift = cur;
+                Iter sift_1 = cur - 1;
+                if (comp(*sift, *sift_1)) {
+                    auto tmp = std::move(*sift);
+                    do {
+                        *sift-- = std::move(*sift_1);
+                    } while (comp(tmp, *--sift_1));
+                    *sift = std::move(tmp);
+                }
+            }
+        }
+
+        /**
+         * 尝试用插入排序完成排序，移动次数超过`partial_insertion_sort_limit`时放弃。
+         * @return 区间已经有序时返回true
+         */
+        template <typename Iter, typename Compare>
+        static bool _partial_insertion_sort(Iter begin, Iter end,
+                                            Compare comp) {
+            if (begin == end) {
+                return true;
+            }
+            diff_t limit = 0;
+            for (Iter cur = begin + 1; cur != end; ++cur) {
+                Iter sift = cur;
+                Iter sift_1 = cur - 1;
+                if (comp(*sift, *sift_1)) {
+                    auto tmp = std::move(*sift);
+                    do {
+                        *sift-- = std::move(*sift_1);
+                    } while (sift != begin && comp(tmp, *--sift_1));
+                    *sift = std::move(tmp);
+                    limit += cur - sift;
+                }
+                if (limit > partial_insertion_sort_limit) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        template <typename Iter, typename Compare>
+        static void _sift_down(Iter begin, diff_t hole, const diff_t size,
+                               Compare comp) {
+            auto item = std::move(*(begin + hole));
+            for (diff_t child = hole * 2 + 1; child < size;
+                 child = hole * 2 + 1) {
+                if (child + 1 < size &&
+                    comp(*(begin + child), *(begin + child + 1))) {
+                    child++;
+                }
+                if (!comp(item, *(begin + child))) {
+                    break;
+                }
+                *(begin + hole) = std::move(*(begin + child));
+                hole = child;
+            }
+            *(begin + hole) = std::move(item);
+        }
+
+        template <typename Iter, typename Compare>
+        static void _make_heap(Iter begin, Iter end, Compare comp) {
+            const diff_t size = end - begin;
+            for (diff_t i = size / 2 - 1; i >= 0; --i) {
+                _sift_down(begin, i, size, comp);
+            }
+        }
+
+        /**
+         * 原地堆排序，`_pdqsort_loop()`中坏划分过多时的兜底算法，保证最坏O(nlogn)。
+         */
+        template <typename Iter, typename Compare>
+        static void _heap_sort(Iter begin, Iter end, Compare comp) {
+            _make_heap(begin, end, comp);
+            for (diff_t size = end - begin; size > 1; --size) {
+                cym::swap(*begin, *(begin + size - 1));
+                _sift_down(begin, 0, size - 1, comp);
+            }
+        }
+
+        template <typename Iter, typename Compare>
+        static void _sort2(Iter a, Iter b, Compare comp) {
+            if (comp(*b, *a)) {
+                cym::swap(*a, *b);
+            }
+        }
+
+        template <typename Iter, typename Compare>
+        static void _sort3(Iter a, Iter b, Iter c, Compare comp) {
+            _sort2(a, b, comp);
+            _sort2(b, c, comp);
+            _sort2(a, b, comp);
+        }
+
+        template <typename Iter>
+        static void _swap_offsets(Iter first, Iter last,
+                                  const unsigned char* offsets_l,
+                                  const unsigned char* offsets_r,
+                                  const diff_t num, const bool use_swaps) {
+            if (use_swaps) {
+                // 两侧数量相同时必须逐对交换，否则环形移动会出错。
+                for (diff_t i = 0; i < num; ++i) {
+                    cym::swap(*(first + offsets_l[i]), *(last - offsets_r[i]));
+                }
+            } else if (num > 0) {
+                Iter l = first + offsets_l[0];
+                Iter r = last - offsets_r[0];
+                auto tmp = std::move(*l);
+                *l = std::move(*r);
+                for (diff_t i = 1; i < num; ++i) {
+                    l = first + offsets_l[i];
+                    *r = std::move(*l);
+                    r = last - offsets_r[i];
+                    *l = std::move(*r);
+                }
+                *r = std::move(tmp);
+            }
+        }
+
+        static unsigned char* _align_cacheline(unsigned char* p) {
+            const auto ip = reinterpret_cast<std::uintptr_t>(p);
+            return reinterpret_cast<unsigned char*>(
+                (ip + cacheline_size - 1) & ~(cacheline_size - 1));
+        }
+
+        /**
+         * 以`*begin`为枢轴划分区间，与枢轴相等的元素放在右侧。
+         * 先按块记录需要交换的元素偏移，再统一交换，比较结果只用于累加计数，
+         * 从而消除分支预测失败（BlockQuicksort）。
+         */
+        template <typename Iter, typename Compare>
+        static partition_result<Iter>
+        _partition_right_branchless(Iter begin, Iter end, Compare comp) {
+            auto pivot = std::move(*begin);
+            Iter first = begin;
+            Iter last = end;
+
+            while (comp(*++first, pivot)) {
+            }
+            if (first - 1 == begin) {
+                while (first < last && !comp(*--last, pivot)) {
+                }
+            } else {
+                while (!comp(*--last, pivot)) {
+                }
+            }
+
+            const bool already_partitioned = first >= last;
+            if (!already_partitioned) {
+                cym::swap(*first, *last);
+                ++first;
+
+                unsigned char offsets_l_storage[block_size + cacheline_size];
+                unsigned char offsets_r_storage[block_size + cacheline_size];
+                unsigned char* offsets_l = _align_cacheline(offsets_l_storage);
+                unsigned char* offsets_r = _align_cacheline(offsets_r_storage);
+
+                Iter offsets_l_base = first;
+                Iter offsets_r_base = last;
+                diff_t num_l = 0, num_r = 0, start_l = 0, start_r = 0;
+
+                while (first < last) {
+                    const diff_t num_unknown = last - first;
+                    const diff_t left_split =
+                        num_l == 0 ? (num_r == 0 ? num_unknown / 2 : num_unknown)
+                                   : 0;
+                    const diff_t right_split =
+                        num_r == 0 ? (num_unknown - left_split) : 0;
+
+                    const diff_t left_count =
+                        left_split < block_size ? left_split : block_size;
+                    for (diff_t i = 0; i < left_count;) {
+                        offsets_l[num_l] = static_cast<unsigned char>(i++);
+                        num_l += !comp(*first, pivot);
+                        ++first;
+                    }
+                    const diff_t right_count =
+                        right_split < block_size ? right_split : block_size;
+                    for (diff_t i = 0; i < right_count;) {
+                        offsets_r[num_r] = static_cast<unsigned char>(++i);
+                        num_r += comp(*--last, pivot);
+                    }
+
+                    const diff_t num = num_l < num_r ? num_l : num_r;
+                    _swap_offsets(offsets_l_base, offsets_r_base,
+                                  offsets_l + start_l, offsets_r + start_r, num,
+                                  num_l == num_r);
+                    num_l -= num;
+                    num_r -= num;
+                    start_l += num;
+                    start_r += num;
+                    if (num_l == 0) {
+                        start_l = 0;
+                        offsets_l_base = first;
+                    }
+                    if (num_r == 0) {
+                        start_r = 0;
+                        offsets_r_base = last;
+                    }
+                }
+
+                // 处理某一侧剩余的元素
+                if (num_l) {
+                    offsets_l += start_l;
+                    while (num_l--) {
+                        cym::swap(*(offsets_l_base + offsets_l[num_l]), *--last);
+                    }
+                    first = last;
+                }
+                if (num_r) {
+                    offsets_r += start_r;
+                    while (num_r--) {
+                        cym::swap(*(offsets_r_base - offsets_r[num_r]), *first);
+                        ++first;
+                    }
+                    last = first;
+                }
+            }
+
+            Iter pivot_pos = first - 1;
+            *begin = std::move(*pivot_pos);
+            *pivot_pos = std::move(pivot);
+            return {pivot_pos, already_partitioned};
+        }
+
+        /**
+         * 与`_partition_right_branchless()`相同，用于比较开销较大的类型。
+         */
+        template <typename Iter, typename Compare>
+        static partition_result<Iter> _partition_right(Iter begin, Iter end,
+                                                       Compare comp) {
+            auto pivot = std::move(*begin);
+            Iter first = begin;
+            Iter last = end;
+
+            while (comp(*++first, pivot)) {
+            }
+            if (first - 1 == begin) {
+                while (first < last && !comp(*--last, pivot)) {
+                }
+            } else {
+                while (!comp(*--last, pivot)) {
+                }
+            }
+
+            const bool already_partitioned = first >= last;
+            while (first < last) {
+                cym::swap(*first, *last);
+                while (comp(*++first, pivot)) {
+                }
+                while (!comp(*--last, pivot)) {
+                }
+            }
+
+            Iter pivot_pos = first - 1;
+            *begin = std::move(*pivot_pos);
+            *pivot_pos = std::move(pivot);
+            return {pivot_pos, already_partitioned};
+        }
+
+        /**
+         * 把与枢轴相等的元素放在左侧。当枢轴等于区间左侧的元素时使用，
+         * 相等元素在这一步之后不再参与递归，重复元素多时退化为线性时间。
+         */
+        template <typename Iter, typename Compare>
+        static Iter _partition_left(Iter begin, Iter end, Compare comp) {
+            auto pivot = std::move(*begin);
+            Iter first = begin;
+            Iter last = end;
+
+            while (comp(pivot, *--last)) {
+            }
+            if (last + 1 == end) {
+                while (first < last && !comp(pivot, *++first)) {
+                }
+            } else {
+                while (!comp(pivot, *++first)) {
+                }
+            }
+
+            while (first < last) {
+                cym::swap(*first, *last);
+                while (comp(pivot, *--last)) {
+                }
+                while (!comp(pivot, *++first)) {
+                }
+            }
+
+            Iter pivot_pos = last;
+            *begin = std::move(*pivot_pos);
+            *pivot_pos = std::move(pivot);
+            return pivot_pos;
+        }
 
-            T pivot = arr[first];
+        /**
+         * 对指针区间、32/64位算术类型、使用`less`或`greater`比较且规模不超过
+         * `simd_sort_threshold`的情况使用`simd_sort()`。
+         * @return 已经完成排序时返回true
+         */
+        template <typename Iter, typename Compare>
+        static bool _try_simd_sort(Iter begin, Iter end, Compare) {
+            using value_t = typename std::decay<decltype(*begin)>::type;
+            if constexpr (std::is_pointer<Iter>::value &&
+                          simd_sort_threshold<value_t>::value > 0 &&
+                          (std::is_same<Compare, less>::value ||
+                           std::is_same<Compare, greater>::value)) {
+                const size_t size = end - begin;
+                if (size > simd_sort_threshold<value_t>::value ||
+                    !simd_sort(begin, size)) {
+                    return false;
+                }
+                if (std::is_same<Compare, greater>::value) {
+                    _reverse(begin, end);
+                }
+                return true;
+            } else {
+                (void)begin;
+                (void)end;
+                return false;
+            }
+        }
 
-            while (lb <= hb) {
-                while (arr[lb] < pivot) {
-                    lb++;
+        template <bool branchless, typename Iter, typename Compare>
+        static void _pdqsort_loop(Iter begin, Iter end, Compare comp,
+                                  int bad_allowed, bool leftmost) {
+            for (;;) {
+                const diff_t size = end - begin;
+                if (_try_simd_sort(begin, end, comp)) {
+                    return;
                 }
-                while (pivot < arr[hb]) {
-                    hb--;
+                if (size < insertion_sort_threshold) {
+                    if (leftmost) {
+                        _insertion_sort(begin, end, comp);
+                    } else {
+                        _unguarded_insertion_sort(begin, end, comp);
+                    }
+                    return;
                 }
-                if (lb < hb) {
-                    swap(arr[lb], arr[hb]);
-                    lb++;
-                    hb--;
+
+                // 小区间取三数中值，大区间取ninther（三组三数中值的中值）
+                const diff_t s2 = size / 2;
+                if (size > ninther_threshold) {
+                    _sort3(begin, begin + s2, end - 1, comp);
+                    _sort3(begin + 1, begin + (s2 - 1), end - 2, comp);
+                    _sort3(begin + 2, begin + (s2 + 1), end - 3, comp);
+                    _sort3(begin + (s2 - 1), begin + s2, begin + (s2 + 1),
+                           comp);
+                    cym::swap(*begin, *(begin + s2));
                 } else {
-                    lb++;
+                    _sort3(begin + s2, begin, end - 1, comp);
+                }
+
+                if (!leftmost && !comp(*(begin - 1), *begin)) {
+                    begin = _partition_left(begin, end, comp) + 1;
+                    continue;
+                }
+
+                const partition_result<Iter> part =
+                    branchless ? _partition_right_branchless(begin, end, comp)
+                               : _partition_right(begin, end, comp);
+                const Iter pivot_pos = part.pivot;
+
+                const diff_t l_size = pivot_pos - begin;
+                const diff_t r_size = end - (pivot_pos + 1);
+                const bool highly_unbalanced =
+                    l_size < size / 8 || r_size < size / 8;
+
+                if (highly_unbalanced) {
+                    if (--bad_allowed == 0) {
+                        _heap_sort(begin, end, comp);
+                        return;
+                    }
+                    // 打乱部分元素，破坏导致坏划分的输入模式
+                    if (l_size >= insertion_sort_threshold) {
+                        cym::swap(*begin, *(begin + l_size / 4));
+                        cym::swap(*(pivot_pos - 1), *(pivot_pos - l_size / 4));
+                        if (l_size > ninther_threshold) {
+                            cym::swap(*(begin + 1), *(begin + (l_size / 4 + 1)));
+                            cym::swap(*(begin + 2), *(begin + (l_size / 4 + 2)));
+                            cym::swap(*(pivot_pos - 2),
+                                 *(pivot_pos - (l_size / 4 + 1)));
+                            cym::swap(*(pivot_pos - 3),
+                                 *(pivot_pos - (l_size / 4 + 2)));
+                        }
+                    }
+                    if (r_size >= insertion_sort_threshold) {
+                        cym::swap(*(pivot_pos + 1), *(pivot_pos + (1 + r_size / 4)));
+                        cym::swap(*(end - 1), *(end - r_size / 4));
+                        if (r_size > ninther_threshold) {
+                            cym::swap(*(pivot_pos + 2),
+                                 *(pivot_pos + (2 + r_size / 4)));
+                            cym::swap(*(pivot_pos + 3),
+                                 *(pivot_pos + (3 + r_size / 4)));
+                            cym::swap(*(end - 2), *(end - (1 + r_size / 4)));
+                            cym::swap(*(end - 3), *(end - (2 + r_size / 4)));
+                        }
+                    }
+                } else if (part.already_partitioned &&
+                           _partial_insertion_sort(begin, pivot_pos, comp) &&
+                           _partial_insertion_sort(pivot_pos + 1, end, comp)) {
+                    return;
                 }
+
+                // 只递归左半部分，右半部分通过循环处理
+                _pdqsort_loop<branchless>(begin, pivot_pos, comp, bad_allowed,
+                                          leftmost);
+                begin = pivot_pos + 1;
+                leftmost = false;
             }
-            swap(arr[first], arr[hb]);
-            if (1 < hb - first) {
-                quick_sort(arr, first, hb - 1);
+        }
+
+        /**
+         * 检测整个区间是否已经有序或逆序，逆序时原地翻转。
+         * @return 区间已经排好序时返回true
+         */
+        template <typename Iter, typename Compare>
+        static bool _sorted_or_reversed(Iter first, Iter last, Compare comp) {
+            Iter i = first + 2;
+            if (comp(*(first + 1), *first)) {
+                while (i != last && !comp(*(i - 1), *i)) {
+                    ++i;
+                }
+                if (i != last) {
+                    return false;
+                }
+                _reverse(first, last);
+                return true;
             }
-            if (1 < last - hb) {
-                quick_sort(arr, hb + 1, last);
+            while (i != last && !comp(*i, *(i - 1))) {
+                ++i;
             }
+            return i == last;
         }
 
-        template <typename T>
-        static void quick_sort_s(T arr[], const size_t size,
-                                 const bool inverse = false) {
-            int max = 0;
-            if (size < 2) {
-                return;
+        /**
+         * 把NaN移到区间末尾，返回第一个NaN的位置；没有NaN时不移动任何元素。
+         */
+        template <typename Iter>
+        static Iter _partition_nan(Iter first, Iter last) {
+            Iter mid = first;
+            while (mid != last && *mid == *mid) {
+                ++mid;
             }
-            for (int i = 1; i < size; ++i) {
-                if (arr[max] < arr[i]) {
-                    max = i;
+            for (Iter it = mid; it != last; ++it) {
+                if (*it == *it) {
+                    cym::swap(*it, *mid);
+                    ++mid;
                 }
             }
-            if (size - max != 1) {
-                swap(arr[max], arr[size - 1]);
+            return mid;
+        }
+
+      public:
+        /**
+         * 模式消除快速排序（pdqsort），不稳定，最坏时间复杂度O(nlogn)。
+         *
+         * 对算术类型配合`less`/`greater`使用无分支的块划分；坏划分次数超过
+         * log2(n)时转为堆排序；有序、逆序和大量重复元素的输入都是线性时间。
+         * 对指针区间中的32/64位数值，规模较小的区间交给`simd_sort()`。
+         * 浮点数配合`less`/`greater`时，NaN不满足严格弱序，先被移到末尾，
+         * 只对其余元素排序。
+         *
+         * @param first 指向第一个元素的随机访问迭代器
+         * @param last 指向最后一个元素之后的位置
+         * @param comp 严格弱序比较函数，comp(a, b)为true时a排在b之前
+         */
+        template <typename Iter, typename Compare>
+        static void pdq_sort(Iter first, Iter last, Compare comp) {
+            using value_t = typename std::decay<decltype(*first)>::type;
+            if constexpr (std::is_floating_point<value_t>::value &&
+                          (std::is_same<Compare, less>::value ||
+                           std::is_same<Compare, greater>::value)) {
+                last = _partition_nan(first, last);
             }
-            quick_sort(arr, 0, size - 2);
-            if (!inverse) {
+            if (last - first < 2 || _sorted_or_reversed(first, last, comp)) {
                 return;
             }
-            for (int i = 0; i <= size / 2; ++i) {
-                if (2 * i != size - 1) {
-                    swap(arr[i], arr[size - i - 1]);
-                }
+            constexpr bool branchless =
+                std::is_arithmetic<value_t>::value &&
+                (std::is_same<Compare, less>::value ||
+                 std::is_same<Compare, greater>::value);
+            _pdqsort_loop<branchless>(first, last, comp, _log2(last - first),
+                                      true);
+        }
+
+        template <typename Iter>
+        static void pdq_sort(Iter first, Iter last) {
+            pdq_sort(first, last, less());
+        }
+
+        /**
+         * 对闭区间[first, last]排序，等价于`pdq_sort(arr + first, arr + last + 1)`。
+         */
+        template <typename T>
+        static void quick_sort(T arr[], const int first, const int last) {
+            pdq_sort(arr + first, arr + last + 1, less());
+        }
+
+        template <typename T>
+        static void quick_sort_s(T arr[], const size_t size,
+                                 const bool inverse = false) {
+            if (inverse) {
+                pdq_sort(arr, arr + size, greater());
+            } else {
+                pdq_sort(arr, arr + size, less());
             }
         }
 
@@ -85,127 +619,1591 @@ namespace cym {
         }
 
       private:
-        template <typename T>
-        struct element_wrapper {
-            size_t val;
-            int next;
+        static constexpr diff_t floyd_rivest_threshold = 600;
 
-            int get_nth_bit(const size_t bit, const size_t radix) const {
-                size_t tmp = val;
-                size_t counter = 0;
-                while (tmp != 0) {
-                    if (counter == bit - 1) {
-                        break;
+        /**
+         * Floyd-Rivest选择算法。区间较大时先从样本中递归选出两个离第k个元素很近的
+         * 元素作为边界，使划分后剩余的区间很小，平均比较次数约为n+min(k, n-k)。
+         * 循环次数超过`bad_allowed`时认为遇到了坏输入，直接对剩余区间排序，
+         * 保证最坏O(nlogn)。
+         */
+        template <typename T, typename Compare>
+        static void _floyd_rivest_select(T arr[], diff_t left, diff_t right,
+                                         const diff_t k, Compare comp,
+                                         int bad_allowed) {
+            while (right > left) {
+                if (--bad_allowed < 0) {
+                    pdq_sort(arr + left, arr + right + 1, comp);
+                    return;
+                }
+                if (right - left > floyd_rivest_threshold) {
+                    const double n = static_cast<double>(right - left + 1);
+                    const double i = static_cast<double>(k - left + 1);
+                    const double z = log(n);
+                    const double s = 0.5 * exp(2 * z / 3);
+                    const double sd = 0.5 * sqrt(z * s * (n - s) / n) *
+                                      (i < n / 2 ? -1 : 1);
+                    const diff_t new_left = static_cast<diff_t>(
+                        fmax(static_cast<double>(left), k - i * s / n + sd));
+                    const diff_t new_right = static_cast<diff_t>(
+                        fmin(static_cast<double>(right),
+                             k + (n - i) * s / n + sd));
+                    _floyd_rivest_select(arr, new_left, new_right, k, comp,
+                                         bad_allowed);
+                }
+
+                const T pivot = arr[k];
+                diff_t i = left;
+                diff_t j = right;
+                cym::swap(arr[left], arr[k]);
+                if (comp(pivot, arr[right])) {
+                    cym::swap(arr[right], arr[left]);
+                }
+                while (i < j) {
+                    cym::swap(arr[i], arr[j]);
+                    i++;
+                    j--;
+                    while (comp(arr[i], pivot)) {
+                        i++;
+                    }
+                    while (comp(pivot, arr[j])) {
+                        j--;
                     }
-                    tmp /= radix;
-                    counter++;
                 }
-                return static_cast<int>(tmp % radix);
+                if (!comp(arr[left], pivot) && !comp(pivot, arr[left])) {
+                    cym::swap(arr[left], arr[j]);
+                } else {
+                    j++;
+                    cym::swap(arr[j], arr[right]);
+                }
+                if (j <= k) {
+                    left = j + 1;
+                }
+                if (k <= j) {
+                    right = j - 1;
+                }
             }
-        };
+        }
 
-        struct radix_sort_helper_queue {
-            int head = -1;
-            int tail = -1;
-        };
+      public:
+        /**
+         * 选择算法，平均O(n)。完成后`arr[k]`是排序后应该位于第k位的元素，
+         * 它前面的元素都不大于它，后面的元素都不小于它。
+         *
+         * @param arr 数组
+         * @param size 数组长度
+         * @param k 要选择的位置，从0开始
+         * @param comp 严格弱序比较函数
+         */
+        template <typename T, typename Compare>
+        static void select(T arr[], const size_t size, const size_t k,
+                           Compare comp) {
+            if (k >= size) {
+                return;
+            }
+            _floyd_rivest_select(arr, 0, static_cast<diff_t>(size) - 1,
+                                 static_cast<diff_t>(k), comp,
+                                 4 * _log2(static_cast<diff_t>(size)) + 16);
+        }
+
+        template <typename T>
+        static void select(T arr[], const size_t size, const size_t k) {
+            select(arr, size, k, less());
+        }
+
+        /**
+         * 部分排序，完成后前k个元素是最小的k个元素且有序，其余元素顺序不定。
+         * 先用`select()`找出前k个元素再排序，时间复杂度O(n + klogk)。
+         */
+        template <typename T, typename Compare>
+        static void partial_sort(T arr[], const size_t size, size_t k,
+                                 Compare comp) {
+            k = k < size ? k : size;
+            if (k == 0) {
+                return;
+            }
+            if (k < size) {
+                select(arr, size, k - 1, comp);
+            }
+            pdq_sort(arr, arr + k, comp);
+        }
 
         template <typename T>
-        static void _wrapper_radix_sort(element_wrapper<T> arr[],
-                                        const size_t size, const size_t radix,
-                                        size_t max_bit) {
-            radix_sort_helper_queue* queue = new radix_sort_helper_queue[radix];
-            int first = 0;
-            for (size_t i = 0; i < max_bit; ++i) {
-                int current = first;
-                for (int j = 0; j < radix; ++j) {
-                    queue[j].head = -1;
-                }
-                while (current != -1) {
-                    const int queue_index =
-                        arr[current].get_nth_bit(i + 1, radix);
-                    if (queue[queue_index].head == -1) {
-                        queue[queue_index].head = current;
+        static void partial_sort(T arr[], const size_t size, const size_t k) {
+            partial_sort(arr, size, k, less());
+        }
+
+      private:
+        static constexpr size_t min_gallop = 7;
+        static constexpr size_t max_run_stack = 85;
+
+        /**
+         * 在有序区间中查找第一个不小于`key`的位置。从`from_right`指定的一端开始
+         * 按1、2、4……的步长试探，再在最后一步的范围内二分，目标靠近端点时只需
+         * O(log d)次比较，d为目标到端点的距离。
+         */
+        template <typename T, typename Compare>
+        static size_t _gallop_left(const T& key, const T* a, const size_t n,
+                                   const bool from_right, Compare comp) {
+            return _gallop(a, n, from_right,
+                           [&](const T& x) { return comp(x, key); });
+        }
+
+        /**
+         * 在有序区间中查找第一个大于`key`的位置，相等元素位于返回位置之前。
+         */
+        template <typename T, typename Compare>
+        static size_t _gallop_right(const T& key, const T* a, const size_t n,
+                                    const bool from_right, Compare comp) {
+            return _gallop(a, n, from_right,
+                           [&](const T& x) { return !comp(key, x); });
+        }
+
+        /**
+         * 返回第一个使`before(a[i])`为false的位置，要求`before`在区间上先真后假。
+         */
+        template <typename T, typename Predicate>
+        static size_t _gallop(const T* a, const size_t n, const bool from_right,
+                              Predicate before) {
+            size_t lo = 0;
+            size_t hi = n;
+            size_t step = 1;
+            if (from_right) {
+                while (step <= hi && !before(a[hi - step])) {
+                    hi -= step;
+                    step *= 2;
+                }
+                lo = step <= hi ? hi - step + 1 : 0;
+            } else {
+                while (lo + step <= n && before(a[lo + step - 1])) {
+                    lo += step;
+                    step *= 2;
+                }
+                hi = lo + step - 1 < n ? lo + step - 1 : n;
+            }
+            while (lo < hi) {
+                const size_t mid = lo + (hi - lo) / 2;
+                if (before(a[mid])) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            return lo;
+        }
+
+        /**
+         * TimSort的状态：有序段栈、临时缓冲区以及自适应的galloping阈值。
+         */
+        template <typename T, typename Compare>
+        struct tim_sort_state {
+            T* base;
+            T* buffer;
+            Compare comp;
+            size_t gallop_threshold = min_gallop;
+            size_t run_count = 0;
+            size_t run_base[max_run_stack] = {};
+            size_t run_len[max_run_stack] = {};
+        };
+
+        /**
+         * A较短时把A复制到缓冲区，从前往后归并。
+         */
+        template <typename T, typename Compare>
+        static void _merge_lo(tim_sort_state<T, Compare>& st, T* a,
+                              size_t len_a, T* b, size_t len_b) {
+            Compare& comp = st.comp;
+            for (size_t i = 0; i < len_a; ++i) {
+                st.buffer[i] = std::move(a[i]);
+            }
+            T* cursor_a = st.buffer;
+            T* cursor_b = b;
+            T* dest = a;
+            while (len_a > 0 && len_b > 0) {
+                size_t count_a = 0;
+                size_t count_b = 0;
+                // 逐个比较，直到某一侧连续胜出足够多次
+                while (len_a > 0 && len_b > 0 &&
+                       count_a < st.gallop_threshold &&
+                       count_b < st.gallop_threshold) {
+                    if (comp(*cursor_b, *cursor_a)) {
+                        *dest++ = std::move(*cursor_b++);
+                        len_b--;
+                        count_b++;
+                        count_a = 0;
                     } else {
-                        arr[queue[queue_index].tail].next = current;
+                        *dest++ = std::move(*cursor_a++);
+                        len_a--;
+                        count_a++;
+                        count_b = 0;
+                    }
+                }
+                // galloping：成段复制，直到两侧都不再连续胜出
+                while (len_a > 0 && len_b > 0) {
+                    count_a = _gallop_right(*cursor_b, cursor_a, len_a, false,
+                                            comp);
+                    for (size_t i = 0; i < count_a; ++i) {
+                        *dest++ = std::move(*cursor_a++);
+                    }
+                    len_a -= count_a;
+                    if (len_a == 0) {
+                        break;
+                    }
+                    *dest++ = std::move(*cursor_b++);
+                    if (--len_b == 0) {
+                        break;
+                    }
+                    count_b = _gallop_left(*cursor_a, cursor_b, len_b, false,
+                                           comp);
+                    for (size_t i = 0; i < count_b; ++i) {
+                        *dest++ = std::move(*cursor_b++);
+                    }
+                    len_b -= count_b;
+                    if (len_b == 0) {
+                        break;
+                    }
+                    *dest++ = std::move(*cursor_a++);
+                    if (--len_a == 0) {
+                        break;
+                    }
+                    if (st.gallop_threshold > 1) {
+                        st.gallop_threshold--;
+                    }
+                    if (count_a < min_gallop && count_b < min_gallop) {
+                        st.gallop_threshold += 2;
+                        break;
                     }
-                    queue[queue_index].tail = current;
-                    current = arr[current].next;
                 }
+            }
+            while (len_a > 0) {
+                *dest++ = std::move(*cursor_a++);
+                len_a--;
+            }
+        }
 
-                size_t k = 0;
-                while (queue[k].head == -1) {
-                    k++;
+        /**
+         * B较短时把B复制到缓冲区，从后往前归并。
+         */
+        template <typename T, typename Compare>
+        static void _merge_hi(tim_sort_state<T, Compare>& st, T* a,
+                              size_t len_a, T* b, size_t len_b) {
+            Compare& comp = st.comp;
+            for (size_t i = 0; i < len_b; ++i) {
+                st.buffer[i] = std::move(b[i]);
+            }
+            // 指针指向下一个要处理的元素之后的位置
+            T* cursor_a = a + len_a;
+            T* cursor_b = st.buffer + len_b;
+            T* dest = b + len_b;
+            while (len_a > 0 && len_b > 0) {
+                size_t count_a = 0;
+                size_t count_b = 0;
+                while (len_a > 0 && len_b > 0 &&
+                       count_a < st.gallop_threshold &&
+                       count_b < st.gallop_threshold) {
+                    if (comp(*(cursor_b - 1), *(cursor_a - 1))) {
+                        *--dest = std::move(*--cursor_a);
+                        len_a--;
+                        count_a++;
+                        count_b = 0;
+                    } else {
+                        *--dest = std::move(*--cursor_b);
+                        len_b--;
+                        count_b++;
+                        count_a = 0;
+                    }
                 }
-                first = queue[k].head;
-                int last = queue[k].tail;
-                while (k < radix - 1) {
-                    k++;
-                    while (k < radix - 1 && queue[k].head == -1) {
-                        k++;
+                while (len_a > 0 && len_b > 0) {
+                    count_a = len_a - _gallop_right(*(cursor_b - 1), a, len_a,
+                                                    true, comp);
+                    for (size_t i = 0; i < count_a; ++i) {
+                        *--dest = std::move(*--cursor_a);
+                    }
+                    len_a -= count_a;
+                    if (len_a == 0) {
+                        break;
+                    }
+                    *--dest = std::move(*--cursor_b);
+                    if (--len_b == 0) {
+                        break;
+                    }
+                    count_b = len_b - _gallop_left(*(cursor_a - 1), st.buffer,
+                                                   len_b, true, comp);
+                    for (size_t i = 0; i < count_b; ++i) {
+                        *--dest = std::move(*--cursor_b);
+                    }
+                    len_b -= count_b;
+                    if (len_b == 0) {
+                        break;
+                    }
+                    *--dest = std::move(*--cursor_a);
+                    if (--len_a == 0) {
+                        break;
+                    }
+                    if (st.gallop_threshold > 1) {
+                        st.gallop_threshold--;
                     }
-                    if (queue[k].head != -1) {
-                        arr[last].next = queue[k].head;
-                        last = queue[k].tail;
+                    if (count_a < min_gallop && count_b < min_gallop) {
+                        st.gallop_threshold += 2;
+                        break;
                     }
                 }
-                arr[last].next = -1;
             }
+            while (len_b > 0) {
+                *--dest = std::move(*--cursor_b);
+                len_b--;
+            }
+        }
 
-            int j = first;
+        /**
+         * 合并栈中第i和第i+1个有序段。A中不大于B[0]的前缀和B中不小于A末尾的
+         * 后缀已经在正确的位置上，只归并中间的部分。
+         */
+        template <typename T, typename Compare>
+        static void _merge_at(tim_sort_state<T, Compare>& st, const size_t i) {
+            T* a = st.base + st.run_base[i];
+            size_t len_a = st.run_len[i];
+            T* b = st.base + st.run_base[i + 1];
+            size_t len_b = st.run_len[i + 1];
+            st.run_len[i] = len_a + len_b;
+            for (size_t j = i + 1; j + 1 < st.run_count; ++j) {
+                st.run_base[j] = st.run_base[j + 1];
+                st.run_len[j] = st.run_len[j + 1];
+            }
+            st.run_count--;
 
-            for (int i = 0; i < size; ++i) {
-                element_wrapper<T> tmp = arr[j];
-                arr[j] = arr[i];
-                arr[i] = tmp;
-                arr[i].next = j;
-                j = tmp.next;
-                while (j <= i) {
-                    j = arr[j].next;
-                }
+            const size_t skip = _gallop_right(*b, a, len_a, false, st.comp);
+            a += skip;
+            len_a -= skip;
+            if (len_a == 0) {
+                return;
+            }
+            len_b = _gallop_left(a[len_a - 1], b, len_b, true, st.comp);
+            if (len_b == 0) {
+                return;
+            }
+            if (len_a <= len_b) {
+                _merge_lo(st, a, len_a, b, len_b);
+            } else {
+                _merge_hi(st, a, len_a, b, len_b);
             }
-            delete[] queue;
         }
 
-      public:
-        template <typename T>
-        static void radix_sort(T arr[], const size_t size, const size_t radix,
-                               const bool inverse = false) {
-            size_t max_index = 0;
-            for (size_t i = 1; i < size; ++i) {
-                if (arr[max_index] < arr[i]) {
-                    max_index = i;
+        /**
+         * 维持栈中有序段长度的不变式（从栈顶起每段都长于后两段之和），
+         * 保证归并是平衡的。
+         */
+        template <typename T, typename Compare>
+        static void _merge_collapse(tim_sort_state<T, Compare>& st) {
+            while (st.run_count > 1) {
+                size_t n = st.run_count - 2;
+                const size_t* len = st.run_len;
+                if ((n >= 1 && len[n - 1] <= len[n] + len[n + 1]) ||
+                    (n >= 2 && len[n - 2] <= len[n - 1] + len[n])) {
+                    if (len[n - 1] < len[n + 1]) {
+                        n--;
+                    }
+                } else if (len[n] > len[n + 1]) {
+                    break;
                 }
+                _merge_at(st, n);
             }
-            size_t tmp = static_cast<size_t>(arr[max_index]);
-            size_t max_bit = 0;
-            while (tmp != 0) {
-                tmp /= radix;
-                max_bit++;
-            }
+        }
 
-            if (max_index != size - 1) {
-                swap(arr[max_index], arr[size - 1]);
+        static size_t _min_run_length(size_t n) {
+            size_t r = 0;
+            while (n >= 64) {
+                r |= n & 1;
+                n >>= 1;
             }
-            element_wrapper<T>* wrappers = new element_wrapper<T>[size - 1];
+            return n + r;
+        }
 
-            for (size_t i = 0; i < size - 1; ++i) {
-                wrappers[i].val = static_cast<size_t>(arr[i]);
-                wrappers[i].next = i + 1;
+        /**
+         * 二分插入排序，[begin, sorted)已经有序。
+         */
+        template <typename T, typename Compare>
+        static void _binary_insertion_sort(T* begin, T* sorted, T* end,
+                                           Compare comp) {
+            for (; sorted < end; ++sorted) {
+                const size_t pos = _gallop_right(*sorted, begin,
+                                                 sorted - begin, true, comp);
+                T pivot = std::move(*sorted);
+                for (T* p = sorted; p > begin + pos; --p) {
+                    *p = std::move(*(p - 1));
+                }
+                begin[pos] = std::move(pivot);
             }
-            wrappers[size - 1].next = -1;
-            _wrapper_radix_sort(wrappers, size - 1, radix, max_bit);
+        }
 
-            for (size_t i = 0; i < size - 1; ++i) {
-                arr[i] = static_cast<T>(wrappers[i].val);
+      public:
+        /**
+         * 稳定排序，TimSort。
+         *
+         * 识别输入中已有的升序段和严格降序段（翻转），短段用二分插入排序补足到
+         * minrun；有序段入栈后按TimSort的不变式归并，归并时先跳过已经就位的前缀
+         * 和后缀，某一侧连续胜出时切换为galloping成段复制。部分有序的输入接近
+         * 线性时间，最坏O(nlogn)，需要额外n/2个元素的缓冲区。
+         */
+        template <typename T, typename Compare>
+        static void stable_sort(T arr[], const size_t size, Compare comp) {
+            if (size < 2) {
+                return;
             }
-
-            if (inverse) {
-                for (int i = 0; i <= size / 2; ++i) {
-                    if (2 * i != size - 1) {
-                        swap(arr[i], arr[size - i - 1]);
+            tim_sort_state<T, Compare> st{arr, new T[size / 2 + 1], comp};
+            const size_t min_run = _min_run_length(size);
+            for (size_t lo = 0; lo < size;) {
+                size_t hi = lo + 1;
+                if (hi < size) {
+                    if (comp(arr[hi], arr[lo])) {
+                        while (hi + 1 < size && comp(arr[hi + 1], arr[hi])) {
+                            hi++;
+                        }
+                        _reverse(arr + lo, arr + hi + 1);
+                    } else {
+                        while (hi + 1 < size && !comp(arr[hi + 1], arr[hi])) {
+                            hi++;
+                        }
                     }
+                    hi++;
+                }
+                if (hi - lo < min_run) {
+                    const size_t forced =
+                        size - lo < min_run ? size : lo + min_run;
+                    _binary_insertion_sort(arr + lo, arr + hi, arr + forced,
+                                           comp);
+                    hi = forced;
+                }
+                st.run_base[st.run_count] = lo;
+                st.run_len[st.run_count] = hi - lo;
+                st.run_count++;
+                _merge_collapse(st);
+                lo = hi;
+            }
+            while (st.run_count > 1) {
+                size_t n = st.run_count - 2;
+                if (n > 0 && st.run_len[n - 1] < st.run_len[n + 1]) {
+                    n--;
                 }
+                _merge_at(st, n);
+            }
+            delete[] st.buffer;
+        }
+
+        template <typename T>
+        static void stable_sort(T arr[], const size_t size) {
+            stable_sort(arr, size, less());
+        }
+
+      private:
+        template <typename K>
+        struct key_index {
+            K key;
+            size_t index;
+        };
+
+      public:
+        /**
+         * 求排序后的下标：返回的数组`perm`满足`arr[perm[0]], arr[perm[1]], ...`
+         * 按`key_fn`的结果升序排列，键相同时保持原来的顺序。
+         *
+         * 只排序（键, 下标）对，不移动`arr`中的元素，适合元素较大而键较小的情况。
+         * 键为算术类型时使用`radix_sort()`，否则使用`stable_sort()`。
+         * 配合`permute_in_place()`可以把`arr`原地重排为有序。
+         *
+         * @return 长度为`size`的下标数组，由调用者负责delete[]
+         */
+        template <typename T, typename KeyFn>
+        static size_t* argsort(const T arr[], const size_t size, KeyFn key_fn) {
+            using key_t = typename std::decay<decltype(key_fn(arr[0]))>::type;
+            size_t* perm = new size_t[size];
+            if constexpr (std::is_arithmetic<key_t>::value) {
+                key_t* keys = new key_t[size];
+                for (size_t i = 0; i < size; ++i) {
+                    keys[i] = key_fn(arr[i]);
+                    perm[i] = i;
+                }
+                radix_sort(keys, perm, size);
+                delete[] keys;
+            } else {
+                key_index<key_t>* pairs = new key_index<key_t>[size];
+                for (size_t i = 0; i < size; ++i) {
+                    pairs[i].key = key_fn(arr[i]);
+                    pairs[i].index = i;
+                }
+                stable_sort(pairs, size,
+                            [](const key_index<key_t>& a,
+                               const key_index<key_t>& b) {
+                                return a.key < b.key;
+                            });
+                for (size_t i = 0; i < size; ++i) {
+                    perm[i] = pairs[i].index;
+                }
+                delete[] pairs;
+            }
+            return perm;
+        }
+
+        /**
+         * 按下标数组原地重排，完成后新的`arr[i]`为原来的`arr[perm[i]]`。
+         * 沿置换环移动元素，每个元素只移动一次，额外空间为n个比特。
+         */
+        template <typename T>
+        static void permute_in_place(T arr[], const size_t perm[],
+                                     const size_t size) {
+            unsigned char* done = new unsigned char[size / 8 + 1]();
+            for (size_t start = 0; start < size; ++start) {
+                if (done[start / 8] & (1 << start % 8)) {
+                    continue;
+                }
+                T tmp = std::move(arr[start]);
+                size_t i = start;
+                for (;;) {
+                    done[i / 8] |= static_cast<unsigned char>(1 << i % 8);
+                    const size_t next = perm[i];
+                    if (next == start) {
+                        arr[i] = std::move(tmp);
+                        break;
+                    }
+                    arr[i] = std::move(arr[next]);
+                    i = next;
+                }
+            }
+            delete[] done;
+        }
+
+      private:
+        static constexpr size_t parallel_sort_cutoff = 1 << 16;
+
+        /**
+         * 稳定地合并两个有序区间，相等元素中[a, a_end)的排在前面。
+         */
+        template <typename T, typename Compare>
+        static T* _merge(T* a, T* a_end, T* b, T* b_end, T* out,
+                         Compare comp) {
+            while (a != a_end && b != b_end) {
+                if (comp(*b, *a)) {
+                    *out++ = std::move(*b++);
+                } else {
+                    *out++ = std::move(*a++);
+                }
+            }
+            while (a != a_end) {
+                *out++ = std::move(*a++);
+            }
+            while (b != b_end) {
+                *out++ = std::move(*b++);
+            }
+            return out;
+        }
+
+        /**
+         * 求归并A、B后输出的第k个位置上，有多少个元素来自A（merge path）。
+         * 与`_merge()`的稳定性约定一致。
+         */
+        template <typename T, typename Compare>
+        static size_t _co_rank(const size_t k, const T* a, const size_t m,
+                               const T* b, const size_t n, Compare comp) {
+            size_t lo = k > n ? k - n : 0;
+            size_t hi = k < m ? k : m;
+            while (lo < hi) {
+                const size_t i = lo + (hi - lo) / 2;
+                const size_t j = k - i;
+                if (j == 0 || comp(b[j - 1], a[i])) {
+                    hi = i;
+                } else {
+                    lo = i + 1;
+                }
+            }
+            return lo;
+        }
+
+        /**
+         * 并行样本排序：抽样选出分割元素，各线程按块统计每个桶的元素数量并分发到
+         * 临时数组，最后每个桶作为一个任务排序，由线程池的工作窃取平衡负载。
+         */
+        template <typename T, typename Compare>
+        static void _sample_sort(T arr[], const size_t size, task_pool& pool,
+                                 Compare comp) {
+            const size_t threads = pool.size();
+            size_t max_buckets = 2;
+            while (max_buckets < threads * 8 && max_buckets < 256) {
+                max_buckets *= 2;
+            }
+            const size_t oversample = 32;
+            const size_t sample_count = max_buckets * oversample;
+
+            T* sample = new T[sample_count];
+            uint64_t state = 0x9e3779b97f4a7c15ull ^ size;
+            for (size_t i = 0; i < sample_count; ++i) {
+                state ^= state >> 12;
+                state ^= state << 25;
+                state ^= state >> 27;
+                sample[i] = arr[(state * 0x2545f4914f6cdd1dull) % size];
+            }
+            pdq_sort(sample, sample + sample_count, comp);
+            T* splitters = new T[max_buckets - 1];
+            size_t splitter_count = 0;
+            for (size_t i = 1; i < max_buckets; ++i) {
+                const T& s = sample[i * oversample - 1];
+                if (splitter_count == 0 ||
+                    comp(splitters[splitter_count - 1], s)) {
+                    splitters[splitter_count++] = s;
+                }
+            }
+            delete[] sample;
+            const size_t buckets = splitter_count + 1;
+
+            // 桶编号：第一个不小于x的分割元素的下标，等于分割元素的元素进入左侧的桶
+            auto bucket_of = [&](const T& x) {
+                size_t lo = 0;
+                size_t hi = splitter_count;
+                while (lo < hi) {
+                    const size_t mid = (lo + hi) / 2;
+                    if (comp(splitters[mid], x)) {
+                        lo = mid + 1;
+                    } else {
+                        hi = mid;
+                    }
+                }
+                return lo;
+            };
+
+            const size_t blocks = threads;
+            const size_t block_size = (size + blocks - 1) / blocks;
+            unsigned char* ids = new unsigned char[size];
+            size_t* offsets = new size_t[blocks * buckets]();
+            pool.parallel_for(0, blocks, 1, [&](size_t lo, size_t hi) {
+                for (size_t b = lo; b < hi; ++b) {
+                    size_t* count = offsets + b * buckets;
+                    const size_t end = size - b * block_size < block_size
+                                           ? size
+                                           : (b + 1) * block_size;
+                    for (size_t i = b * block_size; i < end; ++i) {
+                        const size_t id = bucket_of(arr[i]);
+                        ids[i] = static_cast<unsigned char>(id);
+                        count[id]++;
+                    }
+                }
+            });
+
+            // 按(桶, 块)的顺序求前缀和，得到每个块在每个桶中的写入位置
+            size_t* bucket_begin = new size_t[buckets + 1];
+            size_t sum = 0;
+            for (size_t k = 0; k < buckets; ++k) {
+                bucket_begin[k] = sum;
+                for (size_t b = 0; b < blocks; ++b) {
+                    const size_t count = offsets[b * buckets + k];
+                    offsets[b * buckets + k] = sum;
+                    sum += count;
+                }
+            }
+            bucket_begin[buckets] = size;
+
+            // 临时数组由各线程首次写入，在NUMA机器上页面会分配在写入线程所在的节点
+            T* tmp = new T[size];
+            pool.parallel_for(0, blocks, 1, [&](size_t lo, size_t hi) {
+                for (size_t b = lo; b < hi; ++b) {
+                    size_t* offset = offsets + b * buckets;
+                    const size_t end = size - b * block_size < block_size
+                                           ? size
+                                           : (b + 1) * block_size;
+                    for (size_t i = b * block_size; i < end; ++i) {
+                        tmp[offset[ids[i]]++] = std::move(arr[i]);
+                    }
+                }
+            });
+            delete[] ids;
+            delete[] offsets;
+            delete[] splitters;
+
+            {
+                task_pool::task_group group(pool);
+                for (size_t k = 0; k < buckets; ++k) {
+                    group.run([=] {
+                        T* first = tmp + bucket_begin[k];
+                        T* last = tmp + bucket_begin[k + 1];
+                        pdq_sort(first, last, comp);
+                        T* out = arr + bucket_begin[k];
+                        while (first != last) {
+                            *out++ = std::move(*first++);
+                        }
+                    });
+                }
+                group.wait();
+            }
+            delete[] bucket_begin;
+            delete[] tmp;
+        }
+
+        /**
+         * 并行归并排序：每个线程对一段调用`stable_sort()`，然后逐轮两两归并。
+         * 每一轮都用merge path把输出均分给所有线程，归并不会只由少数线程完成。
+         */
+        template <typename T, typename Compare>
+        static void _parallel_merge_sort(T arr[], const size_t size,
+                                         task_pool& pool, Compare comp) {
+            const size_t threads = pool.size();
+            T* buffer = new T[size];
+            size_t runs = threads;
+            size_t* bounds = new size_t[runs + 1];
+            for (size_t i = 0; i <= runs; ++i) {
+                bounds[i] = size / runs * i + (i < size % runs ? i : size % runs);
+            }
+            pool.parallel_for(0, runs, 1, [&](size_t lo, size_t hi) {
+                for (size_t r = lo; r < hi; ++r) {
+                    stable_sort(arr + bounds[r], bounds[r + 1] - bounds[r],
+                                comp);
+                }
+            });
+
+            T* src = arr;
+            T* dst = buffer;
+            while (runs > 1) {
+                task_pool::task_group group(pool);
+                for (size_t r = 0; r < runs; r += 2) {
+                    T* a = src + bounds[r];
+                    const size_t m = bounds[r + 1] - bounds[r];
+                    T* out = dst + bounds[r];
+                    if (r + 1 == runs) {
+                        group.run([=] {
+                            for (size_t i = 0; i < m; ++i) {
+                                out[i] = std::move(a[i]);
+                            }
+                        });
+                        continue;
+                    }
+                    T* b = src + bounds[r + 1];
+                    const size_t n = bounds[r + 2] - bounds[r + 1];
+                    size_t pieces = (m + n) * threads / size;
+                    pieces = pieces == 0 ? 1 : pieces;
+                    for (size_t p = 0; p < pieces; ++p) {
+                        group.run([=] {
+                            const size_t k_lo = (m + n) * p / pieces;
+                            const size_t k_hi = (m + n) * (p + 1) / pieces;
+                            const size_t i_lo = _co_rank(k_lo, a, m, b, n, comp);
+                            const size_t i_hi = _co_rank(k_hi, a, m, b, n, comp);
+                            _merge(a + i_lo, a + i_hi, b + (k_lo - i_lo),
+                                   b + (k_hi - i_hi), out + k_lo, comp);
+                        });
+                    }
+                }
+                group.wait();
+                size_t new_runs = 0;
+                for (size_t r = 0; r < runs; r += 2) {
+                    bounds[new_runs++] = bounds[r];
+                }
+                bounds[new_runs] = size;
+                runs = new_runs;
+                T* tmp = src;
+                src = dst;
+                dst = tmp;
+            }
+            if (src != arr) {
+                pool.parallel_for(0, size, parallel_sort_cutoff,
+                                  [&](size_t lo, size_t hi) {
+                                      for (size_t i = lo; i < hi; ++i) {
+                                          arr[i] = std::move(src[i]);
+                                      }
+                                  });
+            }
+            delete[] bounds;
+            delete[] buffer;
+        }
+
+      public:
+        /**
+         * 多线程排序，不稳定。元素数量少于`parallel_sort_cutoff`或只有一个线程时
+         * 退化为`pdq_sort()`。需要额外O(n)的临时空间。
+         *
+         * @param arr 待排序数组
+         * @param size 数组长度
+         * @param threads 线程数，为0时使用硬件线程数
+         * @param comp 严格弱序比较函数
+         */
+        template <typename T, typename Compare>
+        static void parallel_sort(T arr[], const size_t size, unsigned threads,
+                                  Compare comp) {
+            threads = threads == 0 ? default_thread_count() : threads;
+            if (threads == 1 || size < parallel_sort_cutoff) {
+                pdq_sort(arr, arr + size, comp);
+                return;
+            }
+            task_pool pool(threads);
+            _sample_sort(arr, size, pool, comp);
+        }
+
+        template <typename T>
+        static void parallel_sort(T arr[], const size_t size,
+                                  const unsigned threads = 0) {
+            parallel_sort(arr, size, threads, less());
+        }
+
+        /**
+         * 多线程稳定排序，基于并行归并排序，需要额外O(n)的临时空间。
+         */
+        template <typename T, typename Compare>
+        static void parallel_stable_sort(T arr[], const size_t size,
+                                         unsigned threads, Compare comp) {
+            threads = threads == 0 ? default_thread_count() : threads;
+            if (threads == 1 || size < parallel_sort_cutoff) {
+                stable_sort(arr, size, comp);
+                return;
+            }
+            task_pool pool(threads);
+            _parallel_merge_sort(arr, size, pool, comp);
+        }
+
+        template <typename T>
+        static void parallel_stable_sort(T arr[], const size_t size,
+                                         const unsigned threads = 0) {
+            parallel_stable_sort(arr, size, threads, less());
+        }
+
+      private:
+        static constexpr size_t external_min_block = 1 << 16;
+
+        /**
+         * 外部排序的输入：默认使用fread，`use_mmap`时把整个文件映射到内存后复制。
+         * 读取出错或文件末尾只剩不完整的记录时`good()`变为false。
+         */
+        template <typename T>
+        class external_input {
+          private:
+            FILE* _file;
+            mapped_file _map;
+            size_t _offset;
+            bool _ok;
+
+          public:
+            external_input(const char* path, const bool use_mmap)
+                : _file(nullptr), _offset(0), _ok(true) {
+                if (use_mmap && _map.open(path)) {
+                    _map.advise(map_advice::sequential);
+                    _ok = _map.size() % sizeof(T) == 0;
+                    return;
+                }
+                _file = fopen(path, "rb");
+            }
+
+            external_input(const external_input&) = delete;
+
+            external_input& operator=(const external_input&) = delete;
+
+            ~external_input() {
+                if (_file != nullptr) {
+                    fclose(_file);
+                }
+            }
+
+            bool good() const {
+                return (_file != nullptr || _map.is_open()) && _ok;
+            }
+
+            size_t read(T* dst, const size_t count) {
+                if (!_map.is_open()) {
+                    // 按字节读取，才能发现末尾不完整的记录
+                    const size_t bytes = fread(dst, 1, count * sizeof(T), _file);
+                    if (ferror(_file) || bytes % sizeof(T) != 0) {
+                        _ok = false;
+                    }
+                    return bytes / sizeof(T);
+                }
+                size_t n = (_map.size() - _offset) / sizeof(T);
+                n = n < count ? n : count;
+                memcpy(dst, _map.data() + _offset, n * sizeof(T));
+                _offset += n * sizeof(T);
+                return n;
+            }
+        };
+
+        /**
+         * 双缓冲的顺序写：一个缓冲区由线程池中的线程写入文件时，调用者填充另一个。
+         */
+        template <typename T>
+        class external_output {
+          private:
+            FILE* _file;
+            T* _buffer[2];
+            size_t _capacity;
+            size_t _used;
+            int _current;
+            task_pool::task_group _writes;
+            bool _ok;
+
+            void _flush_async() {
+                _writes.wait();
+                T* data = _buffer[_current];
+                const size_t count = _used;
+                _writes.run([this, data, count] {
+                    if (fwrite(data, sizeof(T), count, _file) != count) {
+                        _ok = false;
+                    }
+                });
+                _current = 1 - _current;
+                _used = 0;
+            }
+
+          public:
+            external_output(const char* path, const size_t capacity,
+                            task_pool& pool)
+                : _capacity(capacity == 0 ? 1 : capacity), _used(0),
+                  _current(0), _writes(pool), _ok(true) {
+                _file = fopen(path, "wb");
+                _ok = _file != nullptr;
+                _buffer[0] = new T[_capacity];
+                _buffer[1] = new T[_capacity];
+            }
+
+            external_output(const external_output&) = delete;
+
+            external_output& operator=(const external_output&) = delete;
+
+            ~external_output() {
+                close();
+                delete[] _buffer[0];
+                delete[] _buffer[1];
+            }
+
+            bool good() const { return _file != nullptr && _ok; }
+
+            void put(const T& val) {
+                _buffer[_current][_used++] = val;
+                if (_used == _capacity) {
+                    _flush_async();
+                }
+            }
+
+            /**
+             * 写出剩余数据并关闭文件。
+             * @return 所有数据都写入成功时返回true
+             */
+            bool close() {
+                if (_file == nullptr) {
+                    return _ok;
+                }
+                if (_used > 0) {
+                    _flush_async();
+                }
+                _writes.wait();
+                if (fclose(_file) != 0) {
+                    _ok = false;
+                }
+                _file = nullptr;
+                return _ok;
+            }
+        };
+
+        /**
+         * 按块读取一个有序段，读取出错时`error`为true。
+         */
+        template <typename T>
+        struct external_run {
+            FILE* file = nullptr;
+            T* buffer = nullptr;
+            size_t capacity = 0;
+            size_t pos = 0;
+            size_t len = 0;
+            bool error = false;
+
+            bool next(T& out) {
+                if (pos == len) {
+                    len = fread(buffer, sizeof(T), capacity, file);
+                    pos = 0;
+                    if (len < capacity && ferror(file)) {
+                        error = true;
+                    }
+                    if (len == 0) {
+                        return false;
+                    }
+                }
+                out = buffer[pos++];
+                return true;
+            }
+        };
+
+        static std::string _run_path(const char* output_path, const size_t pass,
+                                     const size_t index) {
+            return std::string(output_path) + ".run" + std::to_string(pass) +
+                   "." + std::to_string(index);
+        }
+
+        /**
+         * 删除第`pass`趟的前`count`个有序段，不存在的文件被忽略。
+         */
+        static void _remove_runs(const char* output_path, const size_t pass,
+                                 const size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                remove(_run_path(output_path, pass, i).c_str());
+            }
+        }
+
+        /**
+         * 生成有序段：三个缓冲区轮流使用，读入下一块、排序当前块和写出上一块
+         * 三者同时进行，读和写由`pool`中的线程完成。
+         * @return 生成的有序段数量，出错时删除已生成的有序段并返回-1
+         */
+        template <typename T, typename Compare>
+        static long _external_make_runs(const char* input_path,
+                                        const char* output_path,
+                                        const size_t memory_budget,
+                                        Compare comp, const bool use_mmap,
+                                        task_pool& pool) {
+            external_input<T> input(input_path, use_mmap);
+            if (!input.good()) {
+                return -1;
+            }
+            size_t chunk = memory_budget / sizeof(T) / 3;
+            chunk = chunk == 0 ? 1 : chunk;
+            T* buffers[3];
+            size_t counts[3];
+            for (auto& buffer : buffers) {
+                buffer = new T[chunk];
+            }
+
+            long runs = 0;
+            bool written = true;
+            task_pool::task_group reads(pool);
+            task_pool::task_group writes(pool);
+            counts[0] = input.read(buffers[0], chunk);
+            bool ok = input.good();
+            for (size_t i = 0; ok && counts[i % 3] > 0; ++i) {
+                T* current = buffers[i % 3];
+                const size_t count = counts[i % 3];
+                const size_t next = (i + 1) % 3;
+                reads.run([&input, &buffers, &counts, next, chunk] {
+                    counts[next] = input.read(buffers[next], chunk);
+                });
+                pdq_sort(current, current + count, comp);
+                // 上一段写完后，它的缓冲区才能在下一轮被读入覆盖
+                writes.wait();
+                FILE* run =
+                    fopen(_run_path(output_path, 0, runs++).c_str(), "wb");
+                if (run == nullptr) {
+                    ok = false;
+                } else {
+                    writes.run([run, current, count, &written] {
+                        if (fwrite(current, sizeof(T), count, run) != count) {
+                            written = false;
+                        }
+                        if (fclose(run) != 0) {
+                            written = false;
+                        }
+                    });
+                }
+                reads.wait();
+                ok = ok && written && input.good();
+            }
+            reads.wait();
+            writes.wait();
+            ok = ok && written;
+            for (auto& buffer : buffers) {
+                delete[] buffer;
+            }
+            if (!ok) {
+                _remove_runs(output_path, 0, static_cast<size_t>(runs));
+                return -1;
+            }
+            return runs;
+        }
+
+        /**
+         * 用败者树把`paths`中的`k`个有序段归并到`output_path`，无论成败都删除
+         * 这些有序段。
+         */
+        template <typename T, typename Compare>
+        static bool _external_merge(const std::string* paths, const size_t k,
+                                    const char* output_path,
+                                    const size_t memory_budget, Compare comp,
+                                    task_pool& pool) {
+            // 每路输入一个缓冲区，输出两个缓冲区
+            size_t block = memory_budget / sizeof(T) / (k + 2);
+            block = block == 0 ? 1 : block;
+            external_run<T>* runs = new external_run<T>[k];
+            loser_tree<T, Compare> tree(k, comp);
+            bool ok = true;
+            for (size_t i = 0; i < k; ++i) {
+                runs[i].file = fopen(paths[i].c_str(), "rb");
+                runs[i].buffer = new T[block];
+                runs[i].capacity = block;
+                T first;
+                if (runs[i].file == nullptr) {
+                    ok = false;
+                } else if (runs[i].next(first)) {
+                    tree.set(i, first);
+                }
+            }
+
+            {
+                external_output<T> output(output_path, block, pool);
+                ok = ok && output.good();
+                if (ok) {
+                    tree.build();
+                    T next;
+                    while (!tree.empty()) {
+                        output.put(tree.top());
+                        if (runs[tree.top_index()].next(next)) {
+                            tree.replace_top(next);
+                        } else {
+                            tree.pop_top();
+                        }
+                    }
+                }
+                ok = output.close() && ok;
+            }
+
+            for (size_t i = 0; i < k; ++i) {
+                ok = ok && !runs[i].error;
+                if (runs[i].file != nullptr) {
+                    fclose(runs[i].file);
+                }
+                delete[] runs[i].buffer;
+                remove(paths[i].c_str());
+            }
+            delete[] runs;
+            return ok;
+        }
+
+      public:
+        /**
+         * 外部排序，用于排序大于内存的定长记录文件。
+         *
+         * 先按内存预算把输入切分成块，用`pdq_sort()`排序后写成有序段，读、排序、写
+         * 三者重叠进行；再用败者树做k路归并。每路输入的缓冲区不小于64KB，有序段
+         * 过多时分多趟归并。后台读写由同一个线程池完成，不为每次写入创建线程。
+         * 临时文件位于`output_path`所在目录，无论成败都会被删除。
+         *
+         * @tparam T 记录类型，必须可以按字节复制
+         * @param input_path 输入文件，由若干个T紧密排列组成
+         * @param output_path 输出文件
+         * @param memory_budget 可以使用的内存字节数
+         * @param comp 严格弱序比较函数
+         * @param use_mmap 为true时通过mmap读取输入文件（仅POSIX系统）
+         * @return 读写文件出错，或输入文件的大小不是sizeof(T)的整数倍时返回false，
+         *         此时输出文件的内容不完整
+         */
+        template <typename T, typename Compare>
+        static bool external_sort(const char* input_path,
+                                  const char* output_path,
+                                  const size_t memory_budget, Compare comp,
+                                  const bool use_mmap = false) {
+            static_assert(std::is_trivially_copyable<T>::value,
+                          "external_sort requires trivially copyable records");
+            // 调用线程排序，一个线程读、一个线程写
+            task_pool pool(3);
+            const long run_count = _external_make_runs<T>(
+                input_path, output_path, memory_budget, comp, use_mmap, pool);
+            if (run_count < 0) {
+                return false;
+            }
+            size_t runs = static_cast<size_t>(run_count);
+            if (runs <= 1) {
+                if (runs == 0) {
+                    FILE* empty = fopen(output_path, "wb");
+                    return empty != nullptr && fclose(empty) == 0;
+                }
+                const std::string path = _run_path(output_path, 0, 0);
+                remove(output_path);
+                if (rename(path.c_str(), output_path) != 0) {
+                    remove(path.c_str());
+                    return false;
+                }
+                return true;
+            }
+
+            size_t fan_in = memory_budget / external_min_block;
+            fan_in = fan_in < 4 ? 2 : fan_in - 2;
+            bool ok = true;
+            std::string* paths = new std::string[fan_in < runs ? fan_in : runs];
+            for (size_t pass = 0; runs > 1 && ok; ++pass) {
+                const size_t groups = (runs + fan_in - 1) / fan_in;
+                for (size_t g = 0; g < groups && ok; ++g) {
+                    const size_t first = g * fan_in;
+                    const size_t k = runs - first < fan_in ? runs - first : fan_in;
+                    for (size_t i = 0; i < k; ++i) {
+                        paths[i] = _run_path(output_path, pass, first + i);
+                    }
+                    const std::string out =
+                        groups == 1 ? std::string(output_path)
+                                    : _run_path(output_path, pass + 1, g);
+                    if (k == 1) {
+                        ok = rename(paths[0].c_str(), out.c_str()) == 0;
+                    } else {
+                        ok = _external_merge<T>(paths, k, out.c_str(),
+                                                memory_budget, comp, pool);
+                    }
+                }
+                if (!ok) {
+                    // 本趟尚未归并的有序段和已经生成的下一趟有序段
+                    _remove_runs(output_path, pass, runs);
+                    _remove_runs(output_path, pass + 1, groups);
+                }
+                runs = groups;
+            }
+            delete[] paths;
+            return ok;
+        }
+
+        template <typename T>
+        static bool external_sort(const char* input_path,
+                                  const char* output_path,
+                                  const size_t memory_budget,
+                                  const bool use_mmap = false) {
+            return external_sort<T>(input_path, output_path, memory_budget,
+                                    less(), use_mmap);
+        }
+
+      private:
+        template <size_t bytes>
+        struct radix_unsigned;
+
+        template <typename T>
+        struct radix_traits {
+            static_assert(std::is_arithmetic<T>::value,
+                          "radix sort only supports arithmetic types");
+            using key_t = typename radix_unsigned<sizeof(T)>::type;
+            static constexpr key_t sign_bit = static_cast<key_t>(
+                static_cast<key_t>(1) << (sizeof(T) * 8 - 1));
+
+            /**
+             * 把T映射为无符号整数，保持大小关系：有符号整数翻转符号位；
+             * 浮点数为负时翻转所有位，为正时只翻转符号位。
+             */
+            static key_t key(const T& val) {
+                key_t k;
+                memcpy(&k, &val, sizeof(T));
+                if (std::is_floating_point<T>::value) {
+                    return (k & sign_bit) ? static_cast<key_t>(~k)
+                                          : static_cast<key_t>(k | sign_bit);
+                }
+                if (std::is_signed<T>::value) {
+                    return static_cast<key_t>(k ^ sign_bit);
+                }
+                return k;
+            }
+        };
+
+        static constexpr size_t radix_bits = 8;
+        static constexpr size_t radix_buckets = 1 << radix_bits;
+        static constexpr size_t radix_insertion_threshold = 64;
+
+        /**
+         * LSD基数排序，每趟处理8位。一次遍历求出所有趟的计数，某一趟所有元素的
+         * 该位都相同时跳过这一趟。`values`不为空时随键一起移动，排序是稳定的。
+         */
+        template <typename T, typename V>
+        static void _lsd_radix_sort(T keys[], V values[], const size_t size,
+                                    const bool inverse) {
+            using traits = radix_traits<T>;
+            using key_t = typename traits::key_t;
+            constexpr size_t passes = sizeof(T);
+            if (size < 2) {
+                return;
+            }
+
+            const key_t flip = inverse ? static_cast<key_t>(~key_t(0)) : 0;
+            auto digit = [flip](const T& val, const size_t pass) {
+                return static_cast<size_t>(
+                    ((traits::key(val) ^ flip) >> (pass * radix_bits)) &
+                    (radix_buckets - 1));
+            };
+
+            size_t(*counts)[radix_buckets] = new size_t[passes][radix_buckets]();
+            for (size_t i = 0; i < size; ++i) {
+                const key_t k = traits::key(keys[i]) ^ flip;
+                for (size_t p = 0; p < passes; ++p) {
+                    counts[p][(k >> (p * radix_bits)) & (radix_buckets - 1)]++;
+                }
+            }
+
+            T* key_buffer = new T[size];
+            V* value_buffer = values == nullptr ? nullptr : new V[size];
+            T* src = keys;
+            T* dst = key_buffer;
+            V* value_src = values;
+            V* value_dst = value_buffer;
+            for (size_t p = 0; p < passes; ++p) {
+                size_t* offset = counts[p];
+                if (offset[digit(src[0], p)] == size) {
+                    continue;
+                }
+                size_t sum = 0;
+                for (size_t d = 0; d < radix_buckets; ++d) {
+                    const size_t count = offset[d];
+                    offset[d] = sum;
+                    sum += count;
+                }
+                for (size_t i = 0; i < size; ++i) {
+                    const size_t pos = offset[digit(src[i], p)]++;
+                    dst[pos] = src[i];
+                    if (values != nullptr) {
+                        value_dst[pos] = std::move(value_src[i]);
+                    }
+                }
+                T* tmp = src;
+                src = dst;
+                dst = tmp;
+                V* value_tmp = value_src;
+                value_src = value_dst;
+                value_dst = value_tmp;
+            }
+            if (src != keys) {
+                memcpy(keys, src, sizeof(T) * size);
+                for (size_t i = 0; values != nullptr && i < size; ++i) {
+                    values[i] = std::move(value_src[i]);
+                }
+            }
+            delete[] counts;
+            delete[] key_buffer;
+            delete[] value_buffer;
+        }
+
+        /**
+         * 原地MSD基数排序（American flag sort）。按当前字节计数后，沿置换环把
+         * 每个元素交换到所属的桶，再对每个桶递归处理下一个字节。
+         */
+        template <typename T>
+        static void _american_flag_sort(T arr[], const size_t size,
+                                        const size_t pass,
+                                        const typename radix_traits<T>::key_t
+                                            flip) {
+            using traits = radix_traits<T>;
+            auto digit = [flip, pass](const T& val) {
+                return static_cast<size_t>(
+                    ((traits::key(val) ^ flip) >> (pass * radix_bits)) &
+                    (radix_buckets - 1));
+            };
+            if (size < radix_insertion_threshold) {
+                _insertion_sort(arr, arr + size, [flip](const T& a, const T& b) {
+                    return (traits::key(a) ^ flip) < (traits::key(b) ^ flip);
+                });
+                return;
+            }
+
+            size_t count[radix_buckets] = {0};
+            for (size_t i = 0; i < size; ++i) {
+                count[digit(arr[i])]++;
+            }
+            if (count[digit(arr[0])] == size) {
+                if (pass > 0) {
+                    _american_flag_sort(arr, size, pass - 1, flip);
+                }
+                return;
+            }
+
+            size_t head[radix_buckets];
+            size_t tail[radix_buckets];
+            size_t sum = 0;
+            for (size_t d = 0; d < radix_buckets; ++d) {
+                head[d] = sum;
+                sum += count[d];
+                tail[d] = sum;
+            }
+            for (size_t d = 0; d < radix_buckets; ++d) {
+                while (head[d] < tail[d]) {
+                    T val = arr[head[d]];
+                    size_t target = digit(val);
+                    while (target != d) {
+                        cym::swap(val, arr[head[target]++]);
+                        target = digit(val);
+                    }
+                    arr[head[d]++] = val;
+                }
+            }
+
+            if (pass == 0) {
+                return;
+            }
+            size_t begin = 0;
+            for (size_t d = 0; d < radix_buckets; ++d) {
+                if (count[d] > 1) {
+                    _american_flag_sort(arr + begin, count[d], pass - 1, flip);
+                }
+                begin += count[d];
+            }
+        }
+
+      public:
+        /**
+         * 基数排序，支持整数（包括有符号整数）和浮点数，稳定。
+         * 需要额外O(n)的临时空间，时间复杂度O(n·sizeof(T))。
+         *
+         * @param arr 待排序数组
+         * @param size 数组长度
+         * @param inverse 为true时降序排列
+         */
+        template <typename T>
+        static void radix_sort(T arr[], const size_t size,
+                               const bool inverse = false) {
+            _lsd_radix_sort(arr, static_cast<unsigned char*>(nullptr), size,
+                            inverse);
+        }
+
+        /**
+         * 旧接口`radix_sort(arr, size, radix, inverse)`。位宽现在固定为8位，
+         * `radix`被忽略；保留这个重载是为了让`radix_sort(a, n, 10)`仍然升序排列，
+         * 而不是把10转换为`inverse = true`。
+         */
+        template <typename T, typename R,
+                  typename = std::enable_if_t<std::is_integral<R>::value &&
+                                              !std::is_same<R, bool>::value>>
+        [[deprecated("radix is ignored, use radix_sort(arr, size, inverse)")]]
+        static void radix_sort(T arr[], const size_t size, R,
+                               const bool inverse = false) {
+            radix_sort(arr, size, inverse);
+        }
+
+        /**
+         * 按`keys`对键值对排序，`values[i]`随`keys[i]`一起移动，稳定。
+         */
+        template <typename K, typename V>
+        static void radix_sort(K keys[], V values[], const size_t size,
+                               const bool inverse = false) {
+            _lsd_radix_sort(keys, values, size, inverse);
+        }
+
+        /**
+         * 原地基数排序，只需要O(sizeof(T))层递归的栈空间，但不稳定，
+         * 适合内存紧张的场景。
+         */
+        template <typename T>
+        static void radix_sort_in_place(T arr[], const size_t size,
+                                        const bool inverse = false) {
+            using key_t = typename radix_traits<T>::key_t;
+            if (size < 2) {
+                return;
+            }
+            _american_flag_sort(arr, size, sizeof(T) - 1,
+                                inverse ? static_cast<key_t>(~key_t(0))
+                                        : key_t(0));
+        }
+    };
+
+    template <>
+    struct sort::radix_unsigned<1> {
+        using type = uint8_t;
+    };
+
+    template <>
+    struct sort::radix_unsigned<2> {
+        using type = uint16_t;
+    };
+
+    template <>
+    struct sort::radix_unsigned<4> {
+        using type = uint32_t;
+    };
+
+    template <>
+    struct sort::radix_unsigned<8> {
+        using type = uint64_t;
+    };
+
+    /**
+     * 流式求最大的K个元素（按`comp`排序时排在最后的K个）。
+     *
+     * 内部是一个容量为K的堆，堆顶是已保留元素中最小的一个，新元素只有比堆顶大时
+     * 才会替换堆顶，插入n个元素的时间复杂度为O(nlogK)，空间为O(K)。
+     * 多线程使用时每个线程各自持有一个`top_k`，最后用`merge()`合并。
+     */
+    template <typename T, size_t K, typename Compare = less>
+    class top_k {
+        static_assert(K > 0, "K must be positive");
+
+      private:
+        T _el[K];
+        size_t _used;
+        Compare _comp;
+
+        /**
+         * 堆中a是否应该位于b的下方，即a是否比b大。
+         */
+        bool _below(const T& a, const T& b) const { return _comp(b, a); }
+
+        void _sift_down(size_t hole) {
+            T item = std::move(_el[hole]);
+            for (size_t child = hole * 2 + 1; child < _used;
+                 child = hole * 2 + 1) {
+                if (child + 1 < _used && _below(_el[child], _el[child + 1])) {
+                    child++;
+                }
+                if (!_below(item, _el[child])) {
+                    break;
+                }
+                _el[hole] = std::move(_el[child]);
+                hole = child;
+            }
+            _el[hole] = std::move(item);
+        }
+
+        void _sift_up(size_t hole) {
+            T item = std::move(_el[hole]);
+            while (hole > 0 && _below(_el[(hole - 1) / 2], item)) {
+                _el[hole] = std::move(_el[(hole - 1) / 2]);
+                hole = (hole - 1) / 2;
+            }
+            _el[hole] = std::move(item);
+        }
+
+      public:
+        explicit top_k(Compare comp = Compare()) : _used(0), _comp(comp) {}
+
+        static constexpr size_t capacity() { return K; }
+
+        size_t size() const { return _used; }
+
+        bool empty() const { return _used == 0; }
+
+        void clear() { _used = 0; }
+
+        /**
+         * 已保留元素中最小的一个，即当前的第K大元素。
+         */
+        const T& min() const { return _el[0]; }
+
+        void push(const T& e) {
+            if (_used < K) {
+                _el[_used++] = e;
+                _sift_up(_used - 1);
+            } else if (_comp(_el[0], e)) {
+                _el[0] = e;
+                _sift_down(0);
+            }
+        }
+
+        /**
+         * 批量加入元素。堆满以后，不大于堆顶的元素只需要一次比较就被丢弃。
+         */
+        void push(const T arr[], const size_t size) {
+            size_t i = 0;
+            for (; i < size && _used < K; ++i) {
+                push(arr[i]);
+            }
+            for (; i < size; ++i) {
+                if (_comp(_el[0], arr[i])) {
+                    _el[0] = arr[i];
+                    _sift_down(0);
+                }
+            }
+        }
+
+        /**
+         * 合并另一个`top_k`的结果，用于合并多个线程各自的统计结果。
+         */
+        void merge(const top_k& rhs) { push(rhs._el, rhs._used); }
+
+        /**
+         * 按从大到小的顺序把结果写入`out`。
+         * @return 写入的元素数量，即min(K, 已加入的元素数)
+         */
+        size_t extract(T out[]) const {
+            for (size_t i = 0; i < _used; ++i) {
+                out[i] = _el[i];
             }
+            sort::pdq_sort(out, out + _used, [this](const T& a, const T& b) {
+                return _comp(b, a);
+            });
+            return _used;
         }
     };
 } // namespace cym
@@ -0,0 +1,233 @@
+#pragma once
+
+#include "heap.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace cym {
+
+    /**
+     * 基于MultiQueue的松弛并发优先队列。
+     *
+     * 内部持有 c·P 个各自加锁的`heap`：`push()`随机选择一个堆插入，
+     * `pop()`随机抽取`choices`个堆，取出其中堆顶最优的元素。出队顺序是近似的，
+     * 平均秩误差约为 O(c·P)。
+     *
+     * 调整质量与吞吐量：
+     * - `queues_per_thread`（即c）越大，锁竞争越少，但出队顺序越松散；
+     * - `choices`越大，每次出队比较的堆越多，顺序越接近严格，但开销越大；
+     * - `set_strict(true)`后`pop()`会锁住全部堆，返回全局最优元素。
+     *
+     * 与`heap`相同，T需要可以通过memcpy复制。
+     */
+    template <typename T>
+    class concurrent_priority_queue {
+      private:
+        struct alignas(64) sub_queue {
+            std::mutex lock;
+            heap<T> el;
+            std::atomic<size_t> used;
+
+            explicit sub_queue(const heap_type type) : el(type), used(0) {}
+        };
+
+        heap_type _ty;
+        size_t _queue_count;
+        size_t _choices;
+        sub_queue** _queues;
+        std::atomic<bool> _strict;
+
+        static size_t next_random() {
+            static std::atomic<uint64_t> seed_counter(0x9e3779b97f4a7c15ull);
+            thread_local uint64_t state =
+                seed_counter.fetch_add(0x9e3779b97f4a7c15ull) ^
+                std::hash<std::thread::id>()(std::this_thread::get_id());
+            // xorshift64*
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            return static_cast<size_t>((state * 0x2545f4914f6cdd1dull) >> 32);
+        }
+
+        size_t random_queue() const { return next_random() % _queue_count; }
+
+        /**
+         * 判断a是否比b更应该先出队。对于最小堆是 a < b，对于最大堆是 b < a。
+         */
+        bool _prior(const T& a, const T& b) const {
+            return _ty == heap_type::min ? a < b : b < a;
+        }
+
+      public:
+        /**
+         * @param type 最小优先或最大优先
+         * @param threads 预期并发访问的线程数P，为0时使用硬件线程数
+         * @param queues_per_thread 每个线程对应的堆数量c
+         * @param choices 每次出队时比较的堆数量，至少为2
+         */
+        explicit concurrent_priority_queue(const heap_type type,
+                                           size_t threads = 0,
+                                           const size_t queues_per_thread = 2,
+                                           const size_t choices = 2)
+            : _ty(type), _strict(false) {
+            if (threads == 0) {
+                threads = std::thread::hardware_concurrency();
+            }
+            if (threads == 0) {
+                threads = 1;
+            }
+            _queue_count = threads * (queues_per_thread < 1 ? 1
+                                                            : queues_per_thread);
+            _choices = choices < 2 ? 2 : choices;
+            _queues = new sub_queue*[_queue_count];
+            for (size_t i = 0; i < _queue_count; ++i) {
+                _queues[i] = new sub_queue(type);
+            }
+        }
+
+        concurrent_priority_queue(const concurrent_priority_queue&) = delete;
+
+        concurrent_priority_queue&
+        operator=(const concurrent_priority_queue&) = delete;
+
+        ~concurrent_priority_queue() {
+            for (size_t i = 0; i < _queue_count; ++i) {
+                delete _queues[i];
+            }
+            delete[] _queues;
+        }
+
+        heap_type type() const { return _ty; }
+
+        size_t queue_count() const { return _queue_count; }
+
+        bool strict() const { return _strict.load(); }
+
+        /**
+         * 严格模式下每次出队都会锁住全部堆，返回全局最优元素，吞吐量与单锁堆相当。
+         */
+        void set_strict(const bool strict) { _strict.store(strict); }
+
+        /**
+         * 元素总数的近似值，并发修改时只是一个快照。
+         */
+        size_t size() const {
+            size_t total = 0;
+            for (size_t i = 0; i < _queue_count; ++i) {
+                total += _queues[i]->used.load(std::memory_order_relaxed);
+            }
+            return total;
+        }
+
+        bool empty() const { return size() == 0; }
+
+        void push(const T& e) {
+            for (;;) {
+                sub_queue* q = _queues[random_queue()];
+                if (!q->lock.try_lock()) {
+                    continue;
+                }
+                q->el.insert(e);
+                q->used.store(q->el.size(), std::memory_order_relaxed);
+                q->lock.unlock();
+                return;
+            }
+        }
+
+      private:
+        bool _pop_strict(T& out) {
+            for (size_t i = 0; i < _queue_count; ++i) {
+                _queues[i]->lock.lock();
+            }
+            sub_queue* best = nullptr;
+            for (size_t i = 0; i < _queue_count; ++i) {
+                sub_queue* q = _queues[i];
+                if (q->el.empty()) {
+                    continue;
+                }
+                if (best == nullptr || _prior(q->el.top(), best->el.top())) {
+                    best = q;
+                }
+            }
+            if (best != nullptr) {
+                out = best->el.top();
+                best->el.delete_top();
+                best->used.store(best->el.size(), std::memory_order_relaxed);
+            }
+            for (size_t i = 0; i < _queue_count; ++i) {
+                _queues[i]->lock.unlock();
+            }
+            return best != nullptr;
+        }
+
+        /**
+         * 随机抽取的堆都为空时，顺序扫描一遍，避免队列中尚有元素却返回false。
+         */
+        bool _pop_any(T& out) {
+            const size_t start = random_queue();
+            for (size_t i = 0; i < _queue_count; ++i) {
+                sub_queue* q = _queues[(start + i) % _queue_count];
+                if (q->used.load(std::memory_order_relaxed) == 0) {
+                    continue;
+                }
+                std::lock_guard<std::mutex> guard(q->lock);
+                if (q->el.empty()) {
+                    continue;
+                }
+                out = q->el.top();
+                q->el.delete_top();
+                q->used.store(q->el.size(), std::memory_order_relaxed);
+                return true;
+            }
+            return false;
+        }
+
+      public:
+        /**
+         * 取出一个（近似）最优元素。
+         * @param out 用于接收出队的元素
+         * @return 队列为空时返回false
+         */
+        bool pop(T& out) {
+            if (_strict.load(std::memory_order_relaxed)) {
+                return _pop_strict(out);
+            }
+            const size_t max_attempts = 4 * _queue_count;
+            for (size_t attempt = 0; attempt < max_attempts; ++attempt) {
+                sub_queue* best = nullptr;
+                for (size_t c = 0; c < _choices; ++c) {
+                    sub_queue* q = _queues[random_queue()];
+                    if (q == best ||
+                        q->used.load(std::memory_order_relaxed) == 0 ||
+                        !q->lock.try_lock()) {
+                        continue;
+                    }
+                    if (q->el.empty()) {
+                        q->lock.unlock();
+                        continue;
+                    }
+                    if (best == nullptr) {
+                        best = q;
+                    } else if (_prior(q->el.top(), best->el.top())) {
+                        best->lock.unlock();
+                        best = q;
+                    } else {
+                        q->lock.unlock();
+                    }
+                }
+                if (best == nullptr) {
+                    continue;
+                }
+                out = best->el.top();
+                best->el.delete_top();
+                best->used.store(best->el.size(), std::memory_order_relaxed);
+                best->lock.unlock();
+                return true;
+            }
+            return _pop_any(out);
+        }
+    };
+} // namespace cym
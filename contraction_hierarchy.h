@@ -0,0 +1,772 @@
+#pragma once
+
+#include "algorithm.h"
+#include "csr_graph.h"
+#include "heap.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace cym {
+
+    namespace ch_detail {
+
+        constexpr char magic[8] = {'C', 'Y', 'M', 'C', 'H', 'I', 'E', 'R'};
+        constexpr uint32_t version = 1;
+
+        /**
+         * 文件头，后面依次是每个顶点的次序、向上和向下的出边数（uint32_t），
+         * 以及所有向上和向下的边（`arc`）。所有字段按本机字节序存放。
+         */
+        struct file_header {
+            char magic[8];
+            uint32_t version;
+            uint32_t reserved;
+            uint64_t v_count;
+            uint64_t up_count;
+            uint64_t down_count;
+        };
+
+        /**
+         * 层次中的一条边。`middle`为捷径跳过的顶点，原图中的边为`UINT32_MAX`。
+         */
+        struct arc {
+            unsigned int target;
+            int weight;
+            unsigned int middle;
+        };
+
+        /**
+         * 只能在末尾增删的数组，用于预处理时每个顶点剩余的邻边等。
+         */
+        template <typename T>
+        class buffer {
+          private:
+            T* _data;
+            size_t _size;
+            size_t _capacity;
+
+          public:
+            buffer() : _data(nullptr), _size(0), _capacity(0) {}
+
+            buffer(const buffer&) = delete;
+
+            buffer& operator=(const buffer&) = delete;
+
+            ~buffer() { delete[] _data; }
+
+            void push(const T& x) {
+                if (_size == _capacity) {
+                    _capacity = _capacity == 0 ? 4 : _capacity * 2;
+                    T* data = new T[_capacity];
+                    for (size_t i = 0; i < _size; ++i) {
+                        data[i] = _data[i];
+                    }
+                    delete[] _data;
+                    _data = data;
+                }
+                _data[_size++] = x;
+            }
+
+            /**
+             * 删除第`i`个元素，用最后一个元素填补，不保持顺序。
+             */
+            void erase(const size_t i) { _data[i] = _data[--_size]; }
+
+            T pop() { return _data[--_size]; }
+
+            void clear() { _size = 0; }
+
+            /**
+             * 释放内存。
+             */
+            void release() {
+                delete[] _data;
+                _data = nullptr;
+                _size = 0;
+                _capacity = 0;
+            }
+
+            size_t size() const { return _size; }
+
+            bool empty() const { return _size == 0; }
+
+            T* data() { return _data; }
+
+            const T* data() const { return _data; }
+
+            T& operator[](const size_t i) { return _data[i]; }
+
+            const T& operator[](const size_t i) const { return _data[i]; }
+        };
+    } // namespace ch_detail
+
+    /**
+     * 收缩层次（Contraction Hierarchies），用于静态图上大量的点对点最短路径查询。
+     *
+     * 预处理按优先级依次收缩顶点：删去顶点`v`时，对每对邻居u -> v -> x，
+     * 若不经过`v`找不到不长于它的路径（见证搜索），就加入一条捷径u -> x。
+     * 优先级主要由边差（需要的捷径数减去`v`的边数）决定，见`builder::priority()`，
+     * 保存在`indexed_heap`中并延迟更新：取出堆顶时重新计算，仍不大于新的堆顶才收缩，
+     * 否则放回堆中。收缩的先后即顶点的次序。
+     *
+     * 任意最短路径都可以替换为先沿次序上升、再下降的一条路径，因此查询只需要
+     * 从起点沿向上的边、从终点沿反向的向下的边各做一次Dijkstra，在两侧都访问到的
+     * 顶点相遇。每侧只访问次序更高的顶点，在道路网上搜索空间只有数百个顶点。
+     * 得到的路径中的捷径按`middle`递归展开为原图中的边。
+     *
+     * 与`csr_graph::shortest_path()`一样，权值为负的边被忽略。
+     * 查询复用对象内的临时状态，同一个对象不能被多个线程同时查询。
+     */
+    class contraction_hierarchy {
+      private:
+        using arc = ch_detail::arc;
+
+        static constexpr unsigned int npos = UINT32_MAX;
+
+        /**
+         * 见证搜索最多出堆的顶点数。超过后放弃搜索并加入捷径，结果仍然正确，
+         * 只是可能多出不必要的捷径。
+         */
+        static constexpr size_t witness_limit = 500;
+
+        size_t _v_count;
+        unsigned int* _rank;
+        // 向上的边：`v`到次序更高的顶点
+        size_t* _up_offsets;
+        arc* _up;
+        // 向下的边按终点存放：第`v`行是次序更高的顶点到`v`的边，`target`为起点
+        size_t* _down_offsets;
+        arc* _down;
+
+        // 查询的临时状态，0为正向，1为反向
+        int* _dist[2];
+        unsigned int* _pred[2];
+        unsigned int* _pred_middle[2];
+        unsigned int* _stamp[2];
+        unsigned int _epoch;
+        indexed_heap<int64_t>* _queue[2];
+        ch_detail::buffer<unsigned int> _path;
+        size_t _settled;
+
+        /**
+         * 预处理时剩余的图和见证搜索的临时状态。
+         */
+        struct builder {
+            ch_detail::buffer<arc>* out;
+            ch_detail::buffer<arc>* in;
+            int* dist;
+            unsigned int* stamp;
+            // 等于`epoch`的顶点是本次见证搜索要找的终点
+            unsigned int* goal;
+            unsigned int epoch;
+            indexed_heap<int64_t> queue;
+
+            explicit builder(const size_t v_count)
+                : out(new ch_detail::buffer<arc>[v_count]),
+                  in(new ch_detail::buffer<arc>[v_count]),
+                  dist(new int[v_count]), stamp(new unsigned int[v_count]()),
+                  goal(new unsigned int[v_count]()), epoch(0),
+                  queue(v_count) {}
+
+            builder(const builder&) = delete;
+
+            builder& operator=(const builder&) = delete;
+
+            ~builder() {
+                delete[] out;
+                delete[] in;
+                delete[] dist;
+                delete[] stamp;
+                delete[] goal;
+            }
+
+            /**
+             * 在剩余的图中从`from`出发、不经过`skip`的Dijkstra，`targets`中的
+             * 终点（除`from`外）都已出堆、距离超过`limit`或出堆的顶点数达到
+             * `witness_limit`时停止。之后`distance(x)`为找到的距离，
+             * 未找到时为`dist::infinity`。
+             */
+            void witness_search(const size_t from, const size_t skip,
+                                const int64_t limit,
+                                const ch_detail::buffer<arc>& targets) {
+                queue.clear();
+                if (++epoch == 0) {
+                    memset(stamp, 0, sizeof(unsigned int) * queue.capacity());
+                    memset(goal, 0, sizeof(unsigned int) * queue.capacity());
+                    epoch = 1;
+                }
+                size_t remaining = 0;
+                for (size_t i = 0; i < targets.size(); ++i) {
+                    if (targets[i].target != from) {
+                        goal[targets[i].target] = epoch;
+                        remaining++;
+                    }
+                }
+                stamp[from] = epoch;
+                dist[from] = 0;
+                queue.push_or_decrease(from, 0);
+                for (size_t settled = 0; !queue.empty() && remaining > 0 &&
+                                         settled < witness_limit;
+                     ++settled) {
+                    const size_t v = queue.top();
+                    const int64_t len = queue.top_key();
+                    if (len > limit) {
+                        break;
+                    }
+                    queue.pop();
+                    if (goal[v] == epoch) {
+                        remaining--;
+                    }
+                    const ch_detail::buffer<arc>& arcs = out[v];
+                    for (size_t i = 0; i < arcs.size(); ++i) {
+                        const unsigned int u = arcs[i].target;
+                        const int64_t candidate = len + arcs[i].weight;
+                        if (u != skip && candidate < distance(u)) {
+                            stamp[u] = epoch;
+                            dist[u] = static_cast<int>(candidate);
+                            queue.push_or_decrease(u, candidate);
+                        }
+                    }
+                }
+            }
+
+            int64_t distance(const size_t v) const {
+                return stamp[v] == epoch ? dist[v] : graph::dist::infinity;
+            }
+
+            /**
+             * 对收缩`v`时需要的每条捷径u -> x调用`fn(u, x, weight)`。
+             */
+            template <typename F>
+            void for_each_shortcut(const size_t v, F fn) {
+                const ch_detail::buffer<arc>& ins = in[v];
+                const ch_detail::buffer<arc>& outs = out[v];
+                for (size_t i = 0; i < ins.size(); ++i) {
+                    const unsigned int u = ins[i].target;
+                    int max_out = -1;
+                    for (size_t j = 0; j < outs.size(); ++j) {
+                        if (outs[j].target != u && outs[j].weight > max_out) {
+                            max_out = outs[j].weight;
+                        }
+                    }
+                    if (max_out < 0) {
+                        continue;
+                    }
+                    const int64_t w = ins[i].weight;
+                    witness_search(u, v, w + max_out, outs);
+                    for (size_t j = 0; j < outs.size(); ++j) {
+                        const unsigned int x = outs[j].target;
+                        const int64_t through = w + outs[j].weight;
+                        if (x != u && through < distance(x)) {
+                            fn(u, x, static_cast<int>(through));
+                        }
+                    }
+                }
+            }
+
+            /**
+             * 2 × 边差 + 已收缩的邻居数 + 层数。层数为`v`之前被收缩的邻居的最大层数加1，
+             * 使收缩在图中均匀地推进，避免捷径集中在少数顶点上。
+             */
+            int priority(const size_t v, const unsigned int contracted,
+                         const unsigned int level) {
+                int shortcuts = 0;
+                for_each_shortcut(v, [&](unsigned int, unsigned int, int) {
+                    shortcuts++;
+                });
+                return 2 * (shortcuts - static_cast<int>(in[v].size()) -
+                            static_cast<int>(out[v].size())) +
+                       static_cast<int>(contracted) + static_cast<int>(level);
+            }
+
+            /**
+             * 在`arcs`中设置到`target`的边，已有更短或相等的边时不修改。
+             */
+            static void relax(ch_detail::buffer<arc>& arcs,
+                              const unsigned int target, const int weight,
+                              const unsigned int middle) {
+                for (size_t i = 0; i < arcs.size(); ++i) {
+                    if (arcs[i].target == target) {
+                        if (weight < arcs[i].weight) {
+                            arcs[i].weight = weight;
+                            arcs[i].middle = middle;
+                        }
+                        return;
+                    }
+                }
+                arcs.push({target, weight, middle});
+            }
+
+            static void erase(ch_detail::buffer<arc>& arcs,
+                              const unsigned int target) {
+                for (size_t i = 0; i < arcs.size(); ++i) {
+                    if (arcs[i].target == target) {
+                        arcs.erase(i);
+                        return;
+                    }
+                }
+            }
+        };
+
+        void allocate_query_state() {
+            for (int side = 0; side < 2; ++side) {
+                _dist[side] = new int[_v_count];
+                _pred[side] = new unsigned int[_v_count];
+                _pred_middle[side] = new unsigned int[_v_count];
+                _stamp[side] = new unsigned int[_v_count]();
+                _queue[side] = new indexed_heap<int64_t>(_v_count);
+            }
+            _epoch = 0;
+        }
+
+        void release() {
+            delete[] _rank;
+            delete[] _up_offsets;
+            delete[] _up;
+            delete[] _down_offsets;
+            delete[] _down;
+            for (int side = 0; side < 2; ++side) {
+                delete[] _dist[side];
+                delete[] _pred[side];
+                delete[] _pred_middle[side];
+                delete[] _stamp[side];
+                delete _queue[side];
+                _dist[side] = nullptr;
+                _pred[side] = nullptr;
+                _pred_middle[side] = nullptr;
+                _stamp[side] = nullptr;
+                _queue[side] = nullptr;
+            }
+            _v_count = 0;
+            _rank = nullptr;
+            _up_offsets = nullptr;
+            _up = nullptr;
+            _down_offsets = nullptr;
+            _down = nullptr;
+        }
+
+        /**
+         * 把每个顶点的边表合并为连续的数组，每一行按`target`升序排列。
+         */
+        static void flatten(ch_detail::buffer<arc>* rows, const size_t v_count,
+                            size_t*& offsets, arc*& arcs) {
+            offsets = new size_t[v_count + 1];
+            offsets[0] = 0;
+            for (size_t v = 0; v < v_count; ++v) {
+                offsets[v + 1] = offsets[v] + rows[v].size();
+            }
+            arcs = new arc[offsets[v_count]];
+            for (size_t v = 0; v < v_count; ++v) {
+                arc* row = arcs + offsets[v];
+                for (size_t i = 0; i < rows[v].size(); ++i) {
+                    row[i] = rows[v][i];
+                }
+                sort::pdq_sort(row, row + rows[v].size(),
+                               [](const arc& a, const arc& b) {
+                                   return a.target < b.target;
+                               });
+                rows[v].release();
+            }
+        }
+
+        /**
+         * 在第`v`行中查找到`target`的边。
+         */
+        static const arc* find(const size_t* offsets, const arc* arcs,
+                               const size_t v, const unsigned int target) {
+            size_t lo = offsets[v];
+            size_t hi = offsets[v + 1];
+            while (lo < hi) {
+                const size_t mid = lo + (hi - lo) / 2;
+                if (arcs[mid].target < target) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            return lo < offsets[v + 1] && arcs[lo].target == target ? arcs + lo
+                                                                     : nullptr;
+        }
+
+        /**
+         * 把边`from -> to`（经过`middle`）展开为原图中的边，把`from`之后的顶点追加到路径中。
+         */
+        void unpack(const unsigned int from, const unsigned int to,
+                    const unsigned int middle) {
+            struct segment {
+                unsigned int from;
+                unsigned int to;
+                unsigned int middle;
+            };
+            ch_detail::buffer<segment> stack;
+            stack.push({from, to, middle});
+            while (!stack.empty()) {
+                const segment s = stack.pop();
+                if (s.middle == npos) {
+                    _path.push(s.to);
+                    continue;
+                }
+                // `middle`的次序低于两端：from -> middle是middle的向下的边，
+                // middle -> to是middle的向上的边
+                const arc* first = find(_down_offsets, _down, s.middle, s.from);
+                const arc* second = find(_up_offsets, _up, s.middle, s.to);
+                stack.push({s.middle, s.to, second->middle});
+                stack.push({s.from, s.middle, first->middle});
+            }
+        }
+
+        /**
+         * 检查每条捷径都能被`unpack()`展开：`middle`有到两端的边，且次序低于两端，
+         * 逐层展开时`middle`的次序严格下降，展开一定会结束。
+         */
+        bool shortcuts_valid() const {
+            for (size_t v = 0; v < _v_count; ++v) {
+                for (int side = 0; side < 2; ++side) {
+                    const size_t* offsets =
+                        side == 0 ? _up_offsets : _down_offsets;
+                    const arc* arcs = side == 0 ? _up : _down;
+                    for (size_t k = offsets[v]; k < offsets[v + 1]; ++k) {
+                        const unsigned int m = arcs[k].middle;
+                        if (m == npos) {
+                            continue;
+                        }
+                        // 向上的边为v -> target，向下的边为target -> v
+                        const unsigned int from =
+                            side == 0 ? static_cast<unsigned int>(v)
+                                      : arcs[k].target;
+                        const unsigned int to =
+                            side == 0 ? arcs[k].target
+                                      : static_cast<unsigned int>(v);
+                        if (_rank[m] >= _rank[from] || _rank[m] >= _rank[to] ||
+                            find(_down_offsets, _down, m, from) == nullptr ||
+                            find(_up_offsets, _up, m, to) == nullptr) {
+                            return false;
+                        }
+                    }
+                }
+            }
+            return true;
+        }
+
+      public:
+        /**
+         * 空的层次，只能用于`load()`。
+         */
+        contraction_hierarchy()
+            : _v_count(0), _rank(nullptr), _up_offsets(nullptr), _up(nullptr),
+              _down_offsets(nullptr), _down(nullptr), _dist{nullptr, nullptr},
+              _pred{nullptr, nullptr}, _pred_middle{nullptr, nullptr},
+              _stamp{nullptr, nullptr}, _epoch(0), _queue{nullptr, nullptr},
+              _settled(0) {}
+
+        /**
+         * 对`graph`做预处理。
+         */
+        explicit contraction_hierarchy(const csr_graph& graph)
+            : contraction_hierarchy() {
+            _v_count = graph.vertex_count();
+            const size_t v_count = _v_count;
+            builder b(v_count);
+            const size_t* offsets = graph.offsets();
+            const unsigned int* targets = graph.targets();
+            const int* weights = graph.weights();
+            for (size_t v = 0; v < v_count; ++v) {
+                for (size_t e = offsets[v]; e < offsets[v + 1]; ++e) {
+                    if (weights[e] >= 0 && targets[e] != v) {
+                        b.out[v].push({targets[e], weights[e], npos});
+                        b.in[targets[e]].push(
+                            {static_cast<unsigned int>(v), weights[e], npos});
+                    }
+                }
+            }
+
+            unsigned int* contracted = new unsigned int[v_count]();
+            unsigned int* level = new unsigned int[v_count]();
+            indexed_heap<int> order(v_count);
+            for (size_t v = 0; v < v_count; ++v) {
+                order.push_or_decrease(v, b.priority(v, 0, 0));
+            }
+            _rank = new unsigned int[v_count];
+            ch_detail::buffer<arc>* up = new ch_detail::buffer<arc>[v_count];
+            ch_detail::buffer<arc>* down = new ch_detail::buffer<arc>[v_count];
+            struct shortcut {
+                unsigned int from;
+                unsigned int to;
+                int weight;
+            };
+            ch_detail::buffer<shortcut> shortcuts;
+            unsigned int next_rank = 0;
+            while (!order.empty()) {
+                const unsigned int v = order.top();
+                order.pop();
+                const int p = b.priority(v, contracted[v], level[v]);
+                if (!order.empty() && p > order.top_key()) {
+                    order.push_or_decrease(v, p);
+                    continue;
+                }
+                _rank[v] = next_rank++;
+
+                shortcuts.clear();
+                b.for_each_shortcut(
+                    v, [&](unsigned int u, unsigned int x, int w) {
+                        shortcuts.push({u, x, w});
+                    });
+                // 剩余的邻居次序都更高，`v`的边就是它在层次中的边
+                for (size_t i = 0; i < b.out[v].size(); ++i) {
+                    const arc& a = b.out[v][i];
+                    up[v].push(a);
+                    builder::erase(b.in[a.target], v);
+                    contracted[a.target]++;
+                    level[a.target] = level[a.target] > level[v] + 1
+                                          ? level[a.target]
+                                          : level[v] + 1;
+                }
+                for (size_t i = 0; i < b.in[v].size(); ++i) {
+                    const arc& a = b.in[v][i];
+                    down[v].push(a);
+                    builder::erase(b.out[a.target], v);
+                    contracted[a.target]++;
+                    level[a.target] = level[a.target] > level[v] + 1
+                                          ? level[a.target]
+                                          : level[v] + 1;
+                }
+                b.out[v].release();
+                b.in[v].release();
+                for (size_t i = 0; i < shortcuts.size(); ++i) {
+                    const shortcut& s = shortcuts[i];
+                    builder::relax(b.out[s.from], s.to, s.weight, v);
+                    builder::relax(b.in[s.to], s.from, s.weight, v);
+                }
+            }
+            delete[] contracted;
+            delete[] level;
+            flatten(up, v_count, _up_offsets, _up);
+            flatten(down, v_count, _down_offsets, _down);
+            delete[] up;
+            delete[] down;
+            allocate_query_state();
+        }
+
+        contraction_hierarchy(const contraction_hierarchy&) = delete;
+
+        contraction_hierarchy& operator=(const contraction_hierarchy&) = delete;
+
+        ~contraction_hierarchy() { release(); }
+
+        size_t vertex_count() const { return _v_count; }
+
+        /**
+         * 顶点被收缩的次序，越晚收缩的顶点越“重要”。
+         */
+        unsigned int rank(const size_t v) const { return _rank[v]; }
+
+        /**
+         * 层次中边的总数，包括原图中的边和捷径。
+         */
+        size_t arc_count() const {
+            return _up_offsets == nullptr
+                       ? 0
+                       : _up_offsets[_v_count] + _down_offsets[_v_count];
+        }
+
+        /**
+         * 最近一次查询的路径，从起点到终点（都包含在内），不可达时为空。
+         * 下一次查询后失效。
+         */
+        const unsigned int* path() const { return _path.data(); }
+
+        size_t path_size() const { return _path.size(); }
+
+        /**
+         * 最近一次查询中两侧出堆的顶点总数。
+         */
+        size_t settled() const { return _settled; }
+
+        /**
+         * 求`from`到`to`的最短路径长度，不可达时为`dist::infinity`，
+         * 并把展开后的路径写入`path()`。
+         *
+         * 两侧交替扩展堆顶较小的一侧，某一侧的堆顶不小于已知的最短长度时
+         * 这一侧停止，两侧都停止时结束。
+         */
+        int query(const size_t from, const size_t to) {
+            _path.clear();
+            _settled = 0;
+            if (++_epoch == 0) {
+                for (int side = 0; side < 2; ++side) {
+                    memset(_stamp[side], 0, sizeof(unsigned int) * _v_count);
+                }
+                _epoch = 1;
+            }
+            const size_t* offsets[2] = {_up_offsets, _down_offsets};
+            const arc* arcs[2] = {_up, _down};
+            const size_t sources[2] = {from, to};
+            for (int side = 0; side < 2; ++side) {
+                _queue[side]->clear();
+                _stamp[side][sources[side]] = _epoch;
+                _dist[side][sources[side]] = 0;
+                _pred[side][sources[side]] = npos;
+                _queue[side]->push_or_decrease(sources[side], 0);
+            }
+            int64_t best = graph::dist::infinity;
+            unsigned int meet = npos;
+            for (;;) {
+                bool active[2];
+                for (int side = 0; side < 2; ++side) {
+                    active[side] = !_queue[side]->empty() &&
+                                   _queue[side]->top_key() < best;
+                }
+                if (!active[0] && !active[1]) {
+                    break;
+                }
+                const int side =
+                    !active[1] || (active[0] && _queue[0]->top_key() <=
+                                                    _queue[1]->top_key())
+                        ? 0
+                        : 1;
+                const unsigned int v = _queue[side]->top();
+                const int64_t len = _queue[side]->top_key();
+                _queue[side]->pop();
+                _settled++;
+                if (_stamp[1 - side][v] == _epoch &&
+                    len + _dist[1 - side][v] < best) {
+                    best = len + _dist[1 - side][v];
+                    meet = v;
+                }
+                for (size_t e = offsets[side][v]; e < offsets[side][v + 1];
+                     ++e) {
+                    const arc& a = arcs[side][e];
+                    const int64_t candidate = len + a.weight;
+                    if (_stamp[side][a.target] != _epoch ||
+                        candidate < _dist[side][a.target]) {
+                        _stamp[side][a.target] = _epoch;
+                        _dist[side][a.target] = static_cast<int>(candidate);
+                        _pred[side][a.target] = v;
+                        _pred_middle[side][a.target] = a.middle;
+                        _queue[side]->push_or_decrease(a.target, candidate);
+                    }
+                }
+            }
+            if (meet == npos) {
+                return graph::dist::infinity;
+            }
+
+            // 正向的前驱链从相遇点倒推到起点，先收集再逆序展开
+            ch_detail::buffer<unsigned int> chain;
+            for (unsigned int v = meet; v != from; v = _pred[0][v]) {
+                chain.push(v);
+            }
+            _path.push(static_cast<unsigned int>(from));
+            for (size_t i = chain.size(); i > 0; --i) {
+                const unsigned int v = chain[i - 1];
+                unpack(_pred[0][v], v, _pred_middle[0][v]);
+            }
+            for (unsigned int v = meet; v != to; v = _pred[1][v]) {
+                unpack(v, _pred[1][v], _pred_middle[1][v]);
+            }
+            return static_cast<int>(best);
+        }
+
+        /**
+         * 把层次写入文件，格式见`ch_detail::file_header`。
+         * @return 文件无法写入时返回false
+         */
+        bool save(const char* path) const {
+            FILE* file = fopen(path, "wb");
+            if (file == nullptr) {
+                return false;
+            }
+            ch_detail::file_header header;
+            memcpy(header.magic, ch_detail::magic, sizeof(header.magic));
+            header.version = ch_detail::version;
+            header.reserved = 0;
+            header.v_count = _v_count;
+            header.up_count = _v_count == 0 ? 0 : _up_offsets[_v_count];
+            header.down_count = _v_count == 0 ? 0 : _down_offsets[_v_count];
+            uint32_t* degrees = new uint32_t[2 * _v_count];
+            for (size_t v = 0; v < _v_count; ++v) {
+                degrees[v] =
+                    static_cast<uint32_t>(_up_offsets[v + 1] - _up_offsets[v]);
+                degrees[_v_count + v] = static_cast<uint32_t>(
+                    _down_offsets[v + 1] - _down_offsets[v]);
+            }
+            bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                      fwrite(_rank, sizeof(unsigned int), _v_count, file) ==
+                          _v_count &&
+                      fwrite(degrees, sizeof(uint32_t), 2 * _v_count, file) ==
+                          2 * _v_count &&
+                      fwrite(_up, sizeof(arc), header.up_count, file) ==
+                          header.up_count &&
+                      fwrite(_down, sizeof(arc), header.down_count, file) ==
+                          header.down_count;
+            delete[] degrees;
+            ok = fclose(file) == 0 && ok;
+            return ok;
+        }
+
+        /**
+         * 读取`save()`写入的文件，替换当前的层次。
+         * @return 文件不存在、格式不符、长度不足或有无法展开的捷径时返回false，
+         *         当前的层次被清空
+         */
+        bool load(const char* path) {
+            release();
+            FILE* file = fopen(path, "rb");
+            if (file == nullptr) {
+                return false;
+            }
+            ch_detail::file_header header;
+            bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+                      memcmp(header.magic, ch_detail::magic,
+                             sizeof(header.magic)) == 0 &&
+                      header.version == ch_detail::version;
+            uint32_t* degrees = nullptr;
+            if (ok) {
+                _v_count = header.v_count;
+                _rank = new unsigned int[_v_count];
+                degrees = new uint32_t[2 * _v_count];
+                _up = new arc[header.up_count];
+                _down = new arc[header.down_count];
+                ok = fread(_rank, sizeof(unsigned int), _v_count, file) ==
+                         _v_count &&
+                     fread(degrees, sizeof(uint32_t), 2 * _v_count, file) ==
+                         2 * _v_count &&
+                     fread(_up, sizeof(arc), header.up_count, file) ==
+                         header.up_count &&
+                     fread(_down, sizeof(arc), header.down_count, file) ==
+                         header.down_count;
+            }
+            fclose(file);
+            if (ok) {
+                _up_offsets = new size_t[_v_count + 1];
+                _down_offsets = new size_t[_v_count + 1];
+                _up_offsets[0] = 0;
+                _down_offsets[0] = 0;
+                for (size_t v = 0; v < _v_count; ++v) {
+                    _up_offsets[v + 1] = _up_offsets[v] + degrees[v];
+                    _down_offsets[v + 1] =
+                        _down_offsets[v] + degrees[_v_count + v];
+                }
+                ok = _up_offsets[_v_count] == header.up_count &&
+                     _down_offsets[_v_count] == header.down_count;
+            }
+            for (size_t i = 0; ok && i < header.up_count + header.down_count;
+                 ++i) {
+                const arc& a = i < header.up_count ? _up[i]
+                                                   : _down[i - header.up_count];
+                ok = a.target < _v_count &&
+                     (a.middle == npos || a.middle < _v_count);
+            }
+            ok = ok && shortcuts_valid();
+            delete[] degrees;
+            if (!ok) {
+                release();
+                return false;
+            }
+            allocate_query_state();
+            return true;
+        }
+    };
+} // namespace cym
@@ -0,0 +1,877 @@
+#pragma once
+
+#include "algorithm.h"
+#include "graph.h"
+#include "heap.h"
+#include "parallel.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace cym {
+
+    /**
+     * 以压缩稀疏行（CSR）形式存储的有向图。
+     *
+     * 顶点`v`的出边是`targets()[offsets()[v]]`到`targets()[offsets()[v + 1] - 1]`，
+     * 对应的权值在`weights()`的相同位置，每一行内按终点升序排列。
+     * 内存为O(V + E)，遍历一个顶点的邻居只是顺序读两段连续的数组。
+     *
+     * 图应当通过边表一次构造；`set_edge()`和`remove_edge()`需要移动后面所有的边，
+     * 代价为O(V + E)，只适合少量修改。
+     */
+    class csr_graph : public graph {
+      private:
+        size_t _v_count;
+        size_t _e_count;
+        size_t* _offsets;
+        unsigned int* _targets;
+        int* _weights;
+
+        static constexpr size_t build_grain = 1 << 14;
+
+        /**
+         * 构造时把一条边的终点和权值压缩为一个64位整数，按它排序即按终点、
+         * 再按权值升序排列。
+         */
+        static uint64_t pack(const unsigned int to, const int weight) {
+            return (static_cast<uint64_t>(to) << 32) |
+                   (static_cast<uint32_t>(weight) ^ 0x80000000u);
+        }
+
+        static unsigned int packed_target(const uint64_t x) {
+            return static_cast<unsigned int>(x >> 32);
+        }
+
+        static int packed_weight(const uint64_t x) {
+            return static_cast<int>(static_cast<uint32_t>(x) ^ 0x80000000u);
+        }
+
+        static void add(size_t& counter, const bool shared) {
+            if (shared) {
+                __atomic_fetch_add(&counter, 1, __ATOMIC_RELAXED);
+            } else {
+                counter++;
+            }
+        }
+
+        static size_t fetch_add(size_t& counter, const bool shared) {
+            return shared ? __atomic_fetch_add(&counter, 1, __ATOMIC_RELAXED)
+                          : counter++;
+        }
+
+        /**
+         * 把`counts`替换为它的前缀和，`counts[v]`为第`v`行的起点。
+         */
+        static size_t exclusive_scan(size_t* counts, const size_t n) {
+            size_t sum = 0;
+            for (size_t i = 0; i < n; ++i) {
+                const size_t c = counts[i];
+                counts[i] = sum;
+                sum += c;
+            }
+            return sum;
+        }
+
+      protected:
+        /**
+         * 在第`from`行中二分查找终点`to`，返回第一个不小于`to`的位置。
+         */
+        size_t lower_bound(const size_t from, const size_t to) const {
+            size_t lo = _offsets[from];
+            size_t hi = _offsets[from + 1];
+            while (lo < hi) {
+                const size_t mid = lo + (hi - lo) / 2;
+                if (_targets[mid] < to) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            return lo;
+        }
+
+        /**
+         * 由边表构造CSR数组，`symmetric`为true时所有边都按无向边存储。
+         */
+        void build(const edge* edges, const size_t e_count, unsigned threads,
+                   bool symmetric = false);
+
+        /**
+         * 供`undirected_graph`使用，见`build()`。
+         */
+        csr_graph(const size_t v_count, const edge* edges, const size_t e_count,
+                  const unsigned threads, const bool symmetric)
+            : _v_count(v_count), _e_count(0), _offsets(nullptr),
+              _targets(nullptr), _weights(nullptr) {
+            build(edges, e_count, threads, symmetric);
+        }
+
+      private:
+        /**
+         * 只能追加的顶点数组，用作线程私有的桶。
+         */
+        class vertex_buffer {
+          private:
+            unsigned int* _data;
+            size_t _size;
+            size_t _capacity;
+
+          public:
+            vertex_buffer() : _data(nullptr), _size(0), _capacity(0) {}
+
+            vertex_buffer(const vertex_buffer&) = delete;
+
+            vertex_buffer& operator=(const vertex_buffer&) = delete;
+
+            ~vertex_buffer() { delete[] _data; }
+
+            void push(const unsigned int v) {
+                if (_size == _capacity) {
+                    _capacity = _capacity == 0 ? 64 : _capacity * 2;
+                    unsigned int* data = new unsigned int[_capacity];
+                    if (_size > 0) {
+                        memcpy(data, _data, sizeof(unsigned int) * _size);
+                    }
+                    delete[] _data;
+                    _data = data;
+                }
+                _data[_size++] = v;
+            }
+
+            /**
+             * 把`rhs`中的顶点追加到末尾，并清空`rhs`。
+             */
+            void take(vertex_buffer& rhs) {
+                for (size_t i = 0; i < rhs._size; ++i) {
+                    push(rhs._data[i]);
+                }
+                rhs._size = 0;
+            }
+
+            void clear() { _size = 0; }
+
+            bool empty() const { return _size == 0; }
+
+            size_t size() const { return _size; }
+
+            unsigned int operator[](const size_t i) const { return _data[i]; }
+        };
+
+        /**
+         * delta-stepping中每个顶点的状态，高32位为距离，低32位为前驱，
+         * 用一次比较交换同时更新两者。
+         */
+        static uint64_t pack_state(const uint32_t len, const uint32_t pre) {
+            return (static_cast<uint64_t>(len) << 32) | pre;
+        }
+
+      public:
+        /**
+         * 有`v_count`个顶点、没有边的图。
+         */
+        explicit csr_graph(const size_t v_count)
+            : _v_count(v_count), _e_count(0),
+              _offsets(new size_t[v_count + 1]()), _targets(new unsigned int[0]),
+              _weights(new int[0]) {}
+
+        /**
+         * 由边表构造图。
+         *
+         * 先按起点计数排序：统计每个顶点的出度，求前缀和得到行偏移，再把每条边
+         * 放到所在行的下一个空位；然后对每一行按终点排序并合并重复的边。
+         * 各个步骤都按边或按顶点划分给`threads`个线程并行执行。
+         *
+         * 无向边按两条方向相反的有向边存储。同一对顶点之间的多条边只保留权值最小的一条。
+         *
+         * @param threads 线程数，为0时使用硬件线程数
+         */
+        csr_graph(const size_t v_count, const edge* edges, const size_t e_count,
+                  const unsigned threads = 1)
+            : _v_count(v_count), _e_count(0), _offsets(nullptr),
+              _targets(nullptr), _weights(nullptr) {
+            build(edges, e_count, threads);
+        }
+
+        csr_graph(const csr_graph& rhs)
+            : _v_count(rhs._v_count), _e_count(rhs._e_count),
+              _offsets(new size_t[rhs._v_count + 1]),
+              _targets(new unsigned int[rhs._e_count]),
+              _weights(new int[rhs._e_count]) {
+            memcpy(_offsets, rhs._offsets, sizeof(size_t) * (_v_count + 1));
+            memcpy(_targets, rhs._targets, sizeof(unsigned int) * _e_count);
+            memcpy(_weights, rhs._weights, sizeof(int) * _e_count);
+        }
+
+        csr_graph(csr_graph&& rhs) noexcept
+            : _v_count(rhs._v_count), _e_count(rhs._e_count),
+              _offsets(rhs._offsets), _targets(rhs._targets),
+              _weights(rhs._weights) {
+            rhs._v_count = 0;
+            rhs._e_count = 0;
+            rhs._offsets = nullptr;
+            rhs._targets = nullptr;
+            rhs._weights = nullptr;
+        }
+
+        csr_graph& operator=(const csr_graph&) = delete;
+
+        ~csr_graph() {
+            delete[] _offsets;
+            delete[] _targets;
+            delete[] _weights;
+        }
+
+        /**
+         * 设置边的权值，边不存在时插入这条边。
+         */
+        void set_edge(const edge& edge) override {
+            const size_t from = edge.from();
+            const size_t pos = lower_bound(from, edge.to());
+            if (pos < _offsets[from + 1] && _targets[pos] == edge.to()) {
+                _weights[pos] = edge.weight();
+                return;
+            }
+            unsigned int* targets = new unsigned int[_e_count + 1];
+            int* weights = new int[_e_count + 1];
+            memcpy(targets, _targets, sizeof(unsigned int) * pos);
+            memcpy(weights, _weights, sizeof(int) * pos);
+            targets[pos] = edge.to();
+            weights[pos] = edge.weight();
+            memcpy(targets + pos + 1, _targets + pos,
+                   sizeof(unsigned int) * (_e_count - pos));
+            memcpy(weights + pos + 1, _weights + pos,
+                   sizeof(int) * (_e_count - pos));
+            delete[] _targets;
+            delete[] _weights;
+            _targets = targets;
+            _weights = weights;
+            for (size_t v = from + 1; v <= _v_count; ++v) {
+                _offsets[v]++;
+            }
+            _e_count++;
+        }
+
+        void remove_edge(const edge& edge) override {
+            const size_t from = edge.from();
+            const size_t pos = lower_bound(from, edge.to());
+            if (pos == _offsets[from + 1] || _targets[pos] != edge.to()) {
+                return;
+            }
+            memmove(_targets + pos, _targets + pos + 1,
+                    sizeof(unsigned int) * (_e_count - pos - 1));
+            memmove(_weights + pos, _weights + pos + 1,
+                    sizeof(int) * (_e_count - pos - 1));
+            for (size_t v = from + 1; v <= _v_count; ++v) {
+                _offsets[v]--;
+            }
+            _e_count--;
+        }
+
+        /**
+         * 边不存在时返回的权值为-1。
+         */
+        edge get_edge(const size_t from, const size_t to) override {
+            const size_t pos = lower_bound(from, to);
+            const bool found =
+                pos < _offsets[from + 1] && _targets[pos] == to;
+            return {static_cast<unsigned int>(from),
+                    static_cast<unsigned int>(to), found ? _weights[pos] : -1,
+                    true};
+        }
+
+        size_t edge_count() const override { return _e_count; }
+
+        size_t vertex_count() const override { return _v_count; }
+
+        size_t degree(const size_t v) const {
+            return _offsets[v + 1] - _offsets[v];
+        }
+
+        const size_t* offsets() const { return _offsets; }
+
+        const unsigned int* targets() const { return _targets; }
+
+        const int* weights() const { return _weights; }
+
+        /**
+         * 存储图占用的字节数。
+         */
+        size_t memory_usage() const {
+            return sizeof(size_t) * (_v_count + 1) +
+                   (sizeof(unsigned int) + sizeof(int)) * _e_count;
+        }
+
+        /**
+         * 使用Dijkstra算法求`from`到每个顶点的最短路径长度，不可达的顶点为`dist::infinity`。
+         *
+         * 待处理的顶点放在`indexed_heap`中，每个顶点最多出堆一次，
+         * 每条边最多引起一次降低优先级，总代价为O(E log V)。权值为负的边被忽略。
+         */
+        vector_t shortest_path(const size_t from) const {
+            vector_t path_vector({_v_count}, dist::infinity);
+            int* dists = path_vector.data();
+            indexed_heap<int> queue(_v_count);
+            dists[from] = 0;
+            queue.push_or_decrease(from, 0);
+            while (!queue.empty()) {
+                const size_t v = queue.top();
+                const int len = queue.top_key();
+                queue.pop();
+                const size_t end = _offsets[v + 1];
+                for (size_t e = _offsets[v]; e < end; ++e) {
+                    const int weight = _weights[e];
+                    if (weight < 0) {
+                        continue;
+                    }
+                    const unsigned int u = _targets[e];
+                    const int64_t candidate = static_cast<int64_t>(len) + weight;
+                    if (candidate < dists[u]) {
+                        dists[u] = static_cast<int>(candidate);
+                        queue.push_or_decrease(u, dists[u]);
+                    }
+                }
+            }
+            return path_vector;
+        }
+
+        /**
+         * 多线程的delta-stepping单源最短路径，距离与`shortest_path(from)`相同。
+         *
+         * 顶点按当前距离放入宽为`delta`的桶中，从编号最小的非空桶开始：
+         * 反复用桶中顶点的轻边（权值不超过`delta`）松弛，直到桶不再有新的顶点，
+         * 这样桶内的距离全部确定；再用这些顶点的重边各松弛一次。
+         * 同一个桶中的顶点由各线程并行处理，距离和前驱用比较交换更新，
+         * 被松弛的顶点放入线程私有的桶，一轮结束后再合并。
+         * 所有待处理的顶点都在当前桶之后的max_weight / delta + 1个桶中，
+         * 桶按环形数组复用。
+         *
+         * `delta`越小，每个桶中无效的松弛越少，但桶数和同步次数越多。
+         * 自动选择时取最大权值除以平均出度，使一个顶点的轻边期望只有常数条。
+         *
+         * @param threads 线程数，为0时使用硬件线程数
+         * @param delta 桶宽，不大于0时自动选择
+         * @param pred 不为空时写入每个顶点在最短路径树中的前驱，起点和不可达的顶点为-1
+         */
+        vector_t shortest_path(size_t from, unsigned threads, int delta = 0,
+                               vector_t* pred = nullptr) const;
+
+        /**
+         * 反向图：每条边`from -> to`变为`to -> from`，权值不变。
+         * 第`v`行是原图中`v`的入边，可以作为`breadth_first_search()`的`reverse`。
+         *
+         * @param threads 线程数，为0时使用硬件线程数
+         */
+        csr_graph transpose(unsigned threads = 1) const;
+
+        /**
+         * 多线程的方向优化广度优先搜索（Beamer），返回每个顶点到`from`的层数，
+         * 即所有权值为1时的最短路径长度，不可达的顶点为`dist::infinity`。边的权值被忽略。
+         *
+         * 前沿较小时自顶向下：前沿中的顶点检查所有出边，用比较交换认领未访问的终点，
+         * 认领成功的线程把它放入线程私有的下一层。前沿中的出边数超过未访问顶点的
+         * 边数的1/14时改为自底向上：每个未访问的顶点检查入边，找到一个在前沿中的
+         * 邻居就停止；前沿和下一层都是位图，每个64位的字只由一个线程写。
+         * 前沿的顶点数少于顶点数的1/24时回到自顶向下。
+         *
+         * 自底向上需要入边，由`reverse`提供；无向图可以传入自身。
+         * `reverse`为空时只使用自顶向下。
+         *
+         * @param threads 线程数，为0时使用硬件线程数
+         * @param parents 不为空时写入每个顶点在广度优先树中的父顶点，起点和不可达的顶点为-1
+         * @param reverse 入边图，通常为`transpose()`的结果
+         */
+        vector_t breadth_first_search(size_t from, unsigned threads,
+                                      vector_t* parents = nullptr,
+                                      const csr_graph* reverse = nullptr) const;
+    };
+
+    inline void csr_graph::build(const edge* edges, const size_t e_count,
+                                 unsigned threads, const bool symmetric) {
+        threads = threads == 0 ? default_thread_count() : threads;
+        task_pool pool(threads);
+        const bool shared = pool.size() > 1;
+        const size_t v_count = _v_count;
+
+        // 统计出度，求前缀和得到每一行的起点
+        size_t* cursor = new size_t[v_count + 1]();
+        pool.parallel_for(0, e_count, build_grain, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) {
+                add(cursor[edges[i].from()], shared);
+                if (symmetric || !edges[i].directed()) {
+                    add(cursor[edges[i].to()], shared);
+                }
+            }
+        });
+        const size_t slots = exclusive_scan(cursor, v_count);
+        size_t* row_begin = new size_t[v_count + 1];
+        memcpy(row_begin, cursor, sizeof(size_t) * v_count);
+        row_begin[v_count] = slots;
+
+        // 把每条边放到所在行的下一个空位
+        uint64_t* packed = new uint64_t[slots];
+        pool.parallel_for(0, e_count, build_grain, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) {
+                const edge& e = edges[i];
+                packed[fetch_add(cursor[e.from()], shared)] =
+                    pack(e.to(), e.weight());
+                if (symmetric || !e.directed()) {
+                    packed[fetch_add(cursor[e.to()], shared)] =
+                        pack(e.from(), e.weight());
+                }
+            }
+        });
+
+        // 每一行按终点排序，相同终点中权值最小的排在最前，统计去重后的出度
+        const size_t v_grain = build_grain / 4;
+        pool.parallel_for(0, v_count, v_grain, [&](size_t lo, size_t hi) {
+            for (size_t v = lo; v < hi; ++v) {
+                uint64_t* first = packed + row_begin[v];
+                uint64_t* last = packed + row_begin[v + 1];
+                sort::pdq_sort(first, last);
+                size_t unique = 0;
+                for (uint64_t* p = first; p < last; ++p) {
+                    if (p == first || packed_target(*p) != packed_target(p[-1])) {
+                        unique++;
+                    }
+                }
+                cursor[v] = unique;
+            }
+        });
+        _offsets = cursor;
+        _e_count = exclusive_scan(_offsets, v_count);
+        _offsets[v_count] = _e_count;
+
+        _targets = new unsigned int[_e_count];
+        _weights = new int[_e_count];
+        pool.parallel_for(0, v_count, v_grain, [&](size_t lo, size_t hi) {
+            for (size_t v = lo; v < hi; ++v) {
+                const uint64_t* first = packed + row_begin[v];
+                const uint64_t* last = packed + row_begin[v + 1];
+                size_t out = _offsets[v];
+                for (const uint64_t* p = first; p < last; ++p) {
+                    if (p == first || packed_target(*p) != packed_target(p[-1])) {
+                        _targets[out] = packed_target(*p);
+                        _weights[out] = packed_weight(*p);
+                        out++;
+                    }
+                }
+            }
+        });
+        delete[] packed;
+        delete[] row_begin;
+    }
+
+    inline vector_t csr_graph::shortest_path(const size_t from, unsigned threads,
+                                             int delta, vector_t* pred) const {
+        constexpr uint32_t infinity = dist::infinity;
+        constexpr uint32_t npos = UINT32_MAX;
+        threads = threads == 0 ? default_thread_count() : threads;
+        task_pool pool(threads);
+        const unsigned workers = pool.size();
+        const bool shared = workers > 1;
+        const size_t v_count = _v_count;
+
+        int* local_max = new int[workers]();
+        pool.parallel_for(0, _e_count, build_grain, [&](size_t lo, size_t hi) {
+            int& m = local_max[pool.current_index()];
+            for (size_t e = lo; e < hi; ++e) {
+                m = _weights[e] > m ? _weights[e] : m;
+            }
+        });
+        int max_weight = 0;
+        for (unsigned w = 0; w < workers; ++w) {
+            max_weight = local_max[w] > max_weight ? local_max[w] : max_weight;
+        }
+        delete[] local_max;
+        if (delta <= 0) {
+            const size_t average_degree =
+                v_count == 0 || _e_count < v_count ? 1 : _e_count / v_count;
+            delta = static_cast<int>(max_weight / average_degree);
+            delta = delta < 1 ? 1 : delta;
+        }
+        const size_t slots = static_cast<size_t>(max_weight / delta) + 2;
+
+        uint64_t* state = new uint64_t[v_count];
+        unsigned int* mark = new unsigned int[v_count];
+        pool.parallel_for(0, v_count, build_grain, [&](size_t lo, size_t hi) {
+            for (size_t v = lo; v < hi; ++v) {
+                state[v] = pack_state(infinity, npos);
+                mark[v] = 0;
+            }
+        });
+        vertex_buffer* buckets = new vertex_buffer[workers * slots];
+        vertex_buffer* settled = new vertex_buffer[workers];
+        vertex_buffer frontier;
+        unsigned int epoch = 0;
+
+        auto relax = [&](const unsigned w, const size_t u, const int64_t len,
+                         const size_t v) {
+            if (len >= infinity) {
+                return;
+            }
+            const uint64_t next =
+                pack_state(static_cast<uint32_t>(len), static_cast<uint32_t>(v));
+            uint64_t old = shared ? __atomic_load_n(&state[u], __ATOMIC_RELAXED)
+                                  : state[u];
+            while ((next >> 32) < (old >> 32)) {
+                if (!shared) {
+                    state[u] = next;
+                } else if (!__atomic_compare_exchange_n(
+                               &state[u], &old, next, true, __ATOMIC_RELAXED,
+                               __ATOMIC_RELAXED)) {
+                    continue;
+                }
+                const size_t bucket = static_cast<size_t>(len / delta);
+                buckets[w * slots + bucket % slots].push(
+                    static_cast<unsigned int>(u));
+                return;
+            }
+        };
+        // 并行处理`frontier`中的顶点，同一轮中重复出现的顶点只处理一次
+        auto for_frontier = [&](auto fn) {
+            epoch++;
+            const size_t grain =
+                frontier.size() / (workers * 8) > 64
+                    ? frontier.size() / (workers * 8)
+                    : 64;
+            pool.parallel_for(0, frontier.size(), grain, [&](size_t lo, size_t hi) {
+                const unsigned w = pool.current_index();
+                for (size_t i = lo; i < hi; ++i) {
+                    const unsigned int v = frontier[i];
+                    if (shared) {
+                        if (__atomic_exchange_n(&mark[v], epoch,
+                                                __ATOMIC_RELAXED) == epoch) {
+                            continue;
+                        }
+                    } else if (mark[v] == epoch) {
+                        continue;
+                    } else {
+                        mark[v] = epoch;
+                    }
+                    const uint64_t x =
+                        shared ? __atomic_load_n(&state[v], __ATOMIC_RELAXED)
+                               : state[v];
+                    fn(w, v, static_cast<uint32_t>(x >> 32));
+                }
+            });
+        };
+
+        if (from < v_count) {
+            state[from] = pack_state(0, npos);
+            buckets[0].push(static_cast<unsigned int>(from));
+        }
+        size_t current = 0;
+        for (;;) {
+            size_t step = 0;
+            for (; step < slots; ++step) {
+                const size_t slot = (current + step) % slots;
+                bool found = false;
+                for (unsigned w = 0; w < workers && !found; ++w) {
+                    found = !buckets[w * slots + slot].empty();
+                }
+                if (found) {
+                    break;
+                }
+            }
+            if (step == slots) {
+                break;
+            }
+            current += step;
+            const size_t slot = current % slots;
+
+            // 轻边：反复处理当前桶，直到没有新的顶点进入
+            for (;;) {
+                frontier.clear();
+                for (unsigned w = 0; w < workers; ++w) {
+                    frontier.take(buckets[w * slots + slot]);
+                }
+                if (frontier.empty()) {
+                    break;
+                }
+                for_frontier([&](const unsigned w, const unsigned int v,
+                                 const uint32_t len) {
+                    if (len / delta != current) {
+                        return;
+                    }
+                    settled[w].push(v);
+                    const size_t end = _offsets[v + 1];
+                    for (size_t e = _offsets[v]; e < end; ++e) {
+                        const int weight = _weights[e];
+                        if (0 <= weight && weight <= delta) {
+                            relax(w, _targets[e], static_cast<int64_t>(len) + weight,
+                                  v);
+                        }
+                    }
+                });
+            }
+
+            // 重边：当前桶中的距离已经确定，每个顶点松弛一次
+            frontier.clear();
+            for (unsigned w = 0; w < workers; ++w) {
+                frontier.take(settled[w]);
+            }
+            for_frontier([&](const unsigned w, const unsigned int v,
+                             const uint32_t len) {
+                const size_t end = _offsets[v + 1];
+                for (size_t e = _offsets[v]; e < end; ++e) {
+                    const int weight = _weights[e];
+                    if (weight > delta) {
+                        relax(w, _targets[e], static_cast<int64_t>(len) + weight, v);
+                    }
+                }
+            });
+        }
+
+        vector_t path_vector({v_count});
+        if (pred != nullptr) {
+            *pred = vector_t({v_count});
+        }
+        for (size_t v = 0; v < v_count; ++v) {
+            path_vector(v) = static_cast<int>(state[v] >> 32);
+            if (pred != nullptr) {
+                (*pred)(v) = static_cast<int>(static_cast<uint32_t>(state[v]));
+            }
+        }
+        delete[] state;
+        delete[] mark;
+        delete[] buckets;
+        delete[] settled;
+        return path_vector;
+    }
+
+    inline csr_graph csr_graph::transpose(unsigned threads) const {
+        threads = threads == 0 ? default_thread_count() : threads;
+        task_pool pool(threads);
+        const bool shared = pool.size() > 1;
+        const size_t v_count = _v_count;
+        const size_t v_grain = build_grain / 4;
+
+        // 统计入度，求前缀和得到每一行的起点
+        size_t* cursor = new size_t[v_count + 1]();
+        pool.parallel_for(0, v_count, v_grain, [&](size_t lo, size_t hi) {
+            for (size_t e = _offsets[lo]; e < _offsets[hi]; ++e) {
+                add(cursor[_targets[e]], shared);
+            }
+        });
+        exclusive_scan(cursor, v_count);
+        size_t* row_begin = new size_t[v_count + 1];
+        memcpy(row_begin, cursor, sizeof(size_t) * v_count);
+        row_begin[v_count] = _e_count;
+
+        // 按起点顺序放置时每一行已经有序，多线程放置后需要再排序
+        uint64_t* packed = new uint64_t[_e_count];
+        pool.parallel_for(0, v_count, v_grain, [&](size_t lo, size_t hi) {
+            for (size_t v = lo; v < hi; ++v) {
+                for (size_t e = _offsets[v]; e < _offsets[v + 1]; ++e) {
+                    packed[fetch_add(cursor[_targets[e]], shared)] =
+                        pack(static_cast<unsigned int>(v), _weights[e]);
+                }
+            }
+        });
+        delete[] cursor;
+
+        csr_graph result(v_count);
+        delete[] result._offsets;
+        delete[] result._targets;
+        delete[] result._weights;
+        result._offsets = row_begin;
+        result._e_count = _e_count;
+        result._targets = new unsigned int[_e_count];
+        result._weights = new int[_e_count];
+        pool.parallel_for(0, v_count, v_grain, [&](size_t lo, size_t hi) {
+            for (size_t v = lo; v < hi; ++v) {
+                uint64_t* first = packed + row_begin[v];
+                uint64_t* last = packed + row_begin[v + 1];
+                if (shared) {
+                    sort::pdq_sort(first, last);
+                }
+                for (uint64_t* p = first; p < last; ++p) {
+                    result._targets[p - packed] = packed_target(*p);
+                    result._weights[p - packed] = packed_weight(*p);
+                }
+            }
+        });
+        delete[] packed;
+        return result;
+    }
+
+    inline vector_t csr_graph::breadth_first_search(const size_t from,
+                                                    unsigned threads,
+                                                    vector_t* parents,
+                                                    const csr_graph* reverse) const {
+        constexpr uint32_t npos = UINT32_MAX;
+        constexpr size_t alpha = 14;
+        constexpr size_t beta = 24;
+        constexpr size_t word_grain = 256;
+        threads = threads == 0 ? default_thread_count() : threads;
+        task_pool pool(threads);
+        const unsigned workers = pool.size();
+        const bool shared = workers > 1;
+        const size_t v_count = _v_count;
+        const size_t words = (v_count + 63) / 64;
+
+        vector_t level_vector({v_count});
+        int* levels = level_vector.data();
+        uint32_t* parent = new uint32_t[v_count];
+        pool.parallel_for(0, v_count, build_grain, [&](size_t lo, size_t hi) {
+            for (size_t v = lo; v < hi; ++v) {
+                levels[v] = dist::infinity;
+                parent[v] = npos;
+            }
+        });
+        uint64_t* front = new uint64_t[words];
+        uint64_t* next = new uint64_t[words];
+        vertex_buffer* local = new vertex_buffer[workers];
+        vertex_buffer frontier;
+
+        // 本层的顶点数、它们的出边数，以及尚未访问的顶点的出边数
+        size_t count = 0;
+        size_t frontier_edges = 0;
+        size_t unexplored = _e_count;
+        if (from < v_count) {
+            levels[from] = 0;
+            parent[from] = static_cast<uint32_t>(from);
+            frontier.push(static_cast<unsigned int>(from));
+            count = 1;
+            frontier_edges = degree(from);
+            unexplored -= frontier_edges;
+        }
+        bool bottom_up = false;
+        for (int depth = 1; count > 0; ++depth) {
+            if (reverse != nullptr && !bottom_up &&
+                frontier_edges > unexplored / alpha) {
+                pool.parallel_for(0, words, word_grain, [&](size_t lo, size_t hi) {
+                    memset(front + lo, 0, sizeof(uint64_t) * (hi - lo));
+                });
+                const size_t grain = frontier.size() / (workers * 8) > 64
+                                         ? frontier.size() / (workers * 8)
+                                         : 64;
+                pool.parallel_for(0, frontier.size(), grain, [&](size_t lo, size_t hi) {
+                    for (size_t i = lo; i < hi; ++i) {
+                        const unsigned int v = frontier[i];
+                        const uint64_t bit = uint64_t(1) << (v & 63);
+                        if (shared) {
+                            __atomic_fetch_or(&front[v >> 6], bit,
+                                              __ATOMIC_RELAXED);
+                        } else {
+                            front[v >> 6] |= bit;
+                        }
+                    }
+                });
+                bottom_up = true;
+            } else if (bottom_up && count < v_count / beta) {
+                pool.parallel_for(0, words, word_grain, [&](size_t lo, size_t hi) {
+                    vertex_buffer& out = local[pool.current_index()];
+                    for (size_t i = lo; i < hi; ++i) {
+                        for (uint64_t bits = front[i]; bits != 0;
+                             bits &= bits - 1) {
+                            out.push(static_cast<unsigned int>(
+                                i * 64 + __builtin_ctzll(bits)));
+                        }
+                    }
+                });
+                frontier.clear();
+                for (unsigned w = 0; w < workers; ++w) {
+                    frontier.take(local[w]);
+                }
+                bottom_up = false;
+            }
+
+            size_t next_count = 0;
+            size_t next_edges = 0;
+            if (bottom_up) {
+                const size_t* in_offsets = reverse->_offsets;
+                const unsigned int* in_targets = reverse->_targets;
+                pool.parallel_for(0, words, word_grain, [&](size_t lo, size_t hi) {
+                    size_t c = 0;
+                    size_t m = 0;
+                    for (size_t i = lo; i < hi; ++i) {
+                        uint64_t bits = 0;
+                        const size_t first = i * 64;
+                        const size_t last =
+                            first + 64 < v_count ? first + 64 : v_count;
+                        for (size_t v = first; v < last; ++v) {
+                            if (parent[v] != npos) {
+                                continue;
+                            }
+                            const size_t end = in_offsets[v + 1];
+                            for (size_t e = in_offsets[v]; e < end; ++e) {
+                                const unsigned int u = in_targets[e];
+                                if ((front[u >> 6] >> (u & 63)) & 1) {
+                                    parent[v] = u;
+                                    levels[v] = depth;
+                                    bits |= uint64_t(1) << (v & 63);
+                                    c++;
+                                    m += degree(v);
+                                    break;
+                                }
+                            }
+                        }
+                        next[i] = bits;
+                    }
+                    __atomic_fetch_add(&next_count, c, __ATOMIC_RELAXED);
+                    __atomic_fetch_add(&next_edges, m, __ATOMIC_RELAXED);
+                });
+                uint64_t* t = front;
+                front = next;
+                next = t;
+            } else {
+                const size_t grain = frontier.size() / (workers * 8) > 64
+                                         ? frontier.size() / (workers * 8)
+                                         : 64;
+                pool.parallel_for(0, frontier.size(), grain, [&](size_t lo, size_t hi) {
+                    vertex_buffer& out = local[pool.current_index()];
+                    size_t c = 0;
+                    size_t m = 0;
+                    for (size_t i = lo; i < hi; ++i) {
+                        const unsigned int v = frontier[i];
+                        for (size_t e = _offsets[v]; e < _offsets[v + 1]; ++e) {
+                            const unsigned int u = _targets[e];
+                            uint32_t p = shared ? __atomic_load_n(&parent[u],
+                                                                  __ATOMIC_RELAXED)
+                                                : parent[u];
+                            if (p != npos) {
+                                continue;
+                            }
+                            if (!shared) {
+                                parent[u] = v;
+                            } else if (!__atomic_compare_exchange_n(
+                                           &parent[u], &p, v, false,
+                                           __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                                continue;
+                            }
+                            levels[u] = depth;
+                            out.push(u);
+                            c++;
+                            m += degree(u);
+                        }
+                    }
+                    __atomic_fetch_add(&next_count, c, __ATOMIC_RELAXED);
+                    __atomic_fetch_add(&next_edges, m, __ATOMIC_RELAXED);
+                });
+                frontier.clear();
+                for (unsigned w = 0; w < workers; ++w) {
+                    frontier.take(local[w]);
+                }
+            }
+            count = next_count;
+            frontier_edges = next_edges;
+            unexplored -= next_edges;
+        }
+
+        if (parents != nullptr) {
+            *parents = vector_t({v_count});
+            for (size_t v = 0; v < v_count; ++v) {
+                (*parents)(v) = parent[v] == npos || v == from
+                                    ? -1
+                                    : static_cast<int>(parent[v]);
+            }
+        }
+        delete[] parent;
+        delete[] front;
+        delete[] next;
+        delete[] local;
+        return level_vector;
+    }
+} // namespace cym
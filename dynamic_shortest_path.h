@@ -0,0 +1,607 @@
+#pragma once
+
+#include "csr_graph.h"
+#include "graph.h"
+#include "heap.h"
+#include "parallel.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace cym {
+
+    /**
+     * 边权变化时增量维护的单源最短路径，用于权值不断变化（如实时路况）的图。
+     *
+     * 对象本身就是一个`csr_graph`，`set_edge()`和`remove_edge()`在修改图的同时
+     * 记下受影响边的终点，累积的修改在下一次读取距离或调用`repair()`时一起修复，
+     * 一批修改只修复一次。修复采用Ramalingam–Reps的思路：
+     *
+     * 1. 最短路径树上的边变长或被删除时，以它的终点为根的子树中的顶点受到影响，
+     *    沿树向下收集这些顶点并把距离置为无穷；
+     * 2. 受影响的顶点从未受影响的入边邻居取得初始距离，边变短或新插入时终点
+     *    从各条入边取得初始距离，有变化的顶点入堆；
+     * 3. 从这些顶点出发运行Dijkstra，只会访问距离真正改变的顶点及其出边。
+     *
+     * 修复的代价与受影响的顶点及其邻边的数量有关，与图的大小无关；受影响的顶点
+     * 过多时直接从起点重新计算。
+     * 反向图与本图同步修改，用于第2步查询入边。
+     * 与`csr_graph::shortest_path()`一样，权值为负的边被忽略。
+     *
+     * 注意`csr_graph::set_edge()`插入新边的代价为O(V+E)，修改已有边的权值为O(log d)。
+     */
+    class dynamic_sssp : public csr_graph {
+      private:
+        csr_graph _reverse;
+        size_t _source;
+        int* _dist;
+        unsigned int* _pred;
+        unsigned int* _stamp;
+        unsigned int _epoch;
+        unsigned int* _dirty;
+        size_t _dirty_count;
+        unsigned char* _is_dirty;
+        unsigned int* _affected;
+        size_t _affected_count;
+        indexed_heap<int> _queue;
+
+        static constexpr unsigned int npos = UINT32_MAX;
+
+        void mark_dirty(const size_t v) {
+            if (!_is_dirty[v]) {
+                _is_dirty[v] = 1;
+                _dirty[_dirty_count++] = static_cast<unsigned int>(v);
+            }
+        }
+
+        /**
+         * 从堆中的顶点出发运行Dijkstra，堆中每个顶点的键等于它当前的距离。
+         */
+        void propagate() {
+            const size_t* offsets = this->offsets();
+            const unsigned int* targets = this->targets();
+            const int* weights = this->weights();
+            while (!_queue.empty()) {
+                const size_t v = _queue.top();
+                const int64_t len = _queue.top_key();
+                _queue.pop();
+                for (size_t k = offsets[v]; k < offsets[v + 1]; ++k) {
+                    const int weight = weights[k];
+                    if (weight < 0) {
+                        continue;
+                    }
+                    const unsigned int u = targets[k];
+                    const int64_t candidate = len + weight;
+                    if (candidate < _dist[u]) {
+                        _dist[u] = static_cast<int>(candidate);
+                        _pred[u] = static_cast<unsigned int>(v);
+                        _queue.push_or_decrease(u, _dist[u]);
+                    }
+                }
+            }
+        }
+
+        /**
+         * 用入边邻居中满足`usable`的顶点更新`v`的距离，变短时入堆。
+         */
+        template <typename Usable>
+        void pull(const size_t v, const Usable& usable) {
+            const size_t* offsets = _reverse.offsets();
+            const unsigned int* targets = _reverse.targets();
+            const int* weights = _reverse.weights();
+            int64_t best = _dist[v];
+            unsigned int pre = _pred[v];
+            for (size_t k = offsets[v]; k < offsets[v + 1]; ++k) {
+                const unsigned int u = targets[k];
+                const int weight = weights[k];
+                if (weight < 0 || _dist[u] == graph::dist::infinity ||
+                    !usable(u)) {
+                    continue;
+                }
+                const int64_t candidate =
+                    static_cast<int64_t>(_dist[u]) + weight;
+                if (candidate < best) {
+                    best = candidate;
+                    pre = u;
+                }
+            }
+            if (best < _dist[v]) {
+                _dist[v] = static_cast<int>(best);
+                _pred[v] = pre;
+                _queue.push_or_decrease(v, _dist[v]);
+            }
+        }
+
+      public:
+        /**
+         * 受影响的顶点超过V/`full_ratio`时改为从起点重新计算。
+         */
+        static constexpr size_t full_ratio = 4;
+
+        /**
+         * @param graph 初始的图，会被复制
+         * @param source 起点
+         */
+        dynamic_sssp(const csr_graph& graph, const size_t source)
+            : csr_graph(graph), _reverse(graph.transpose()), _source(source),
+              _dist(new int[graph.vertex_count()]),
+              _pred(new unsigned int[graph.vertex_count()]),
+              _stamp(new unsigned int[graph.vertex_count()]()), _epoch(0),
+              _dirty(new unsigned int[graph.vertex_count()]),
+              _dirty_count(0),
+              _is_dirty(new unsigned char[graph.vertex_count()]()),
+              _affected(new unsigned int[graph.vertex_count()]),
+              _affected_count(0), _queue(graph.vertex_count()) {
+            recompute();
+        }
+
+        dynamic_sssp(const dynamic_sssp&) = delete;
+
+        dynamic_sssp& operator=(const dynamic_sssp&) = delete;
+
+        ~dynamic_sssp() {
+            delete[] _dist;
+            delete[] _pred;
+            delete[] _stamp;
+            delete[] _dirty;
+            delete[] _is_dirty;
+            delete[] _affected;
+        }
+
+        void set_edge(const edge& edge) override {
+            csr_graph::set_edge(edge);
+            _reverse.set_edge(graph::edge(edge.to(), edge.from(),
+                                          edge.weight(), true));
+            mark_dirty(edge.to());
+        }
+
+        void remove_edge(const edge& edge) override {
+            csr_graph::remove_edge(edge);
+            _reverse.remove_edge(graph::edge(edge.to(), edge.from(), 0, true));
+            mark_dirty(edge.to());
+        }
+
+        size_t source() const { return _source; }
+
+        /**
+         * 尚未修复的修改涉及的顶点数。
+         */
+        size_t pending() const { return _dirty_count; }
+
+        /**
+         * 最近一次修复中距离被置为无穷后重新计算的顶点数。
+         */
+        size_t affected() const { return _affected_count; }
+
+        /**
+         * 丢弃已有的结果，从起点重新运行Dijkstra。
+         */
+        void recompute() {
+            const size_t v_count = vertex_count();
+            for (size_t v = 0; v < v_count; ++v) {
+                _dist[v] = graph::dist::infinity;
+                _pred[v] = npos;
+            }
+            for (size_t i = 0; i < _dirty_count; ++i) {
+                _is_dirty[_dirty[i]] = 0;
+            }
+            _dirty_count = 0;
+            _affected_count = v_count;
+            _queue.clear();
+            if (_source < v_count) {
+                _dist[_source] = 0;
+                _queue.push_or_decrease(_source, 0);
+                propagate();
+            }
+        }
+
+        /**
+         * 修复累积的修改，没有修改时直接返回。
+         */
+        void repair() {
+            if (_dirty_count == 0) {
+                return;
+            }
+            if (++_epoch == 0) {
+                memset(_stamp, 0, sizeof(unsigned int) * vertex_count());
+                _epoch = 1;
+            }
+            // 树边变长或被删除，终点是一棵受影响子树的根
+            size_t count = 0;
+            for (size_t i = 0; i < _dirty_count; ++i) {
+                const unsigned int v = _dirty[i];
+                const unsigned int p = _pred[v];
+                if (p == npos) {
+                    continue;
+                }
+                const int weight = get_edge(p, v).weight();
+                if (weight < 0 ||
+                    static_cast<int64_t>(_dist[p]) + weight > _dist[v]) {
+                    _stamp[v] = _epoch;
+                    _affected[count++] = v;
+                }
+            }
+            // 沿最短路径树向下收集整棵子树，列表本身充当队列
+            const size_t* offsets = this->offsets();
+            const unsigned int* targets = this->targets();
+            for (size_t i = 0; i < count; ++i) {
+                const unsigned int v = _affected[i];
+                for (size_t k = offsets[v]; k < offsets[v + 1]; ++k) {
+                    const unsigned int u = targets[k];
+                    if (_pred[u] == v && _stamp[u] != _epoch) {
+                        _stamp[u] = _epoch;
+                        _affected[count++] = u;
+                    }
+                }
+                if (count > vertex_count() / full_ratio) {
+                    recompute();
+                    return;
+                }
+            }
+            for (size_t i = 0; i < count; ++i) {
+                _dist[_affected[i]] = graph::dist::infinity;
+                _pred[_affected[i]] = npos;
+            }
+            const unsigned int epoch = _epoch;
+            const unsigned int* stamp = _stamp;
+            auto unaffected = [stamp, epoch](const unsigned int u) {
+                return stamp[u] != epoch;
+            };
+            auto any = [](unsigned int) { return true; };
+            for (size_t i = 0; i < count; ++i) {
+                pull(_affected[i], unaffected);
+            }
+            // 其余有修改的顶点：入边可能变短或是新插入的
+            for (size_t i = 0; i < _dirty_count; ++i) {
+                const unsigned int v = _dirty[i];
+                if (_stamp[v] != _epoch) {
+                    pull(v, any);
+                }
+                _is_dirty[v] = 0;
+            }
+            _dirty_count = 0;
+            _affected_count = count;
+            propagate();
+        }
+
+        /**
+         * 起点到`v`的最短路径长度，不可达时为`dist::infinity`。
+         */
+        int distance(const size_t v) {
+            repair();
+            return _dist[v];
+        }
+
+        /**
+         * 最短路径上`v`的前一个顶点，`v`为起点或不可达时为-1。
+         */
+        int predecessor(const size_t v) {
+            repair();
+            return _pred[v] == npos ? -1 : static_cast<int>(_pred[v]);
+        }
+
+        /**
+         * 起点到每个顶点的最短路径长度，与`csr_graph::shortest_path(source())`相同。
+         */
+        vector_t distances() {
+            repair();
+            vector_t path_vector({vertex_count()});
+            memcpy(path_vector.data(), _dist, sizeof(int) * vertex_count());
+            return path_vector;
+        }
+    };
+
+    /**
+     * 边权变化时增量维护的全源最短路径矩阵。
+     *
+     * 对象本身就是一个`directed_graph`，另外保存上一次修复时的邻接矩阵和距离矩阵。
+     * 修改只标记所在的行，在下一次读取距离或调用`repair()`时一起修复，分两步：
+     *
+     * 1. 变长或被删除的边(u, v, w)只影响它是紧边（`d[i][u] + w == d[i][v]`）的行i，
+     *    且只影响其中`d[i][u] + w + d[v][j] == d[i][j]`的列j。这些列置为无穷，
+     *    从未受影响的列取得初始距离，再在受影响的列之间运行Dijkstra。
+     *    这一步使用只包含变长修改的邻接矩阵，得到的仍是一个精确的距离矩阵；
+     * 2. 变短或新插入的边(u, v, w)逐条对每一行松弛
+     *    `d[i][j] = min(d[i][j], d[i][u] + w + d[v][j])`，`d[i][u] + w`不小于
+     *    `d[i][v]`的行不会变化，直接跳过。
+     *
+     * 不是u到v的最短路径的边不会出现在任何最短路径上，第1步直接跳过它。
+     * 受影响的行数与变长的边数之积超过V²/`full_ratio`时，逐行修复不如分块的
+     * Floyd–Warshall快，此时改为调用`all_pairs_shortest_path()`。
+     * 与`all_pairs_shortest_path()`一样，权值为负的边按不存在处理。
+     */
+    class dynamic_apsp : public directed_graph {
+      private:
+        unsigned _threads;
+        matrix_t _snapshot;
+        matrix_t _dist;
+        unsigned char* _dirty_rows;
+        size_t _pending;
+        size_t _repaired_rows;
+
+        static constexpr int inf = graph::dist::infinity;
+
+        static bool increased(const int before, const int after) {
+            return before >= 0 && (after < 0 || after > before);
+        }
+
+        static bool decreased(const int before, const int after) {
+            return after >= 0 && (before < 0 || after < before);
+        }
+
+        /**
+         * 第1步中修复一行，结果写入`out`。
+         *
+         * @param edges 变长的边，每条边依次为起点、终点和原来的权值
+         * @param weights 只包含变长修改的邻接矩阵
+         * @param mark 长度为V的临时数组，全为0，返回时恢复为全0
+         * @param columns 长度为V的临时数组
+         */
+        void repair_row(const size_t from, const unsigned int* edges,
+                        const size_t edge_count, const int* weights, int* out,
+                        unsigned char* mark, unsigned int* columns) const {
+            const size_t n = vertex_count();
+            const int* d = _dist.data();
+            const int* row = d + from * n;
+            memcpy(out, row, sizeof(int) * n);
+            // 找出最短路径可能经过变长的边的列，自身到自身的距离始终为0
+            size_t count = 0;
+            for (size_t e = 0; e < edge_count; ++e) {
+                const unsigned int u = edges[3 * e];
+                const unsigned int v = edges[3 * e + 1];
+                const int w = static_cast<int>(edges[3 * e + 2]);
+                if (row[u] == inf ||
+                    static_cast<int64_t>(row[u]) + w != row[v]) {
+                    continue;
+                }
+                const int64_t through = static_cast<int64_t>(row[u]) + w;
+                const int* dv = d + v * n;
+                for (size_t j = 0; j < n; ++j) {
+                    if (dv[j] != inf && through + dv[j] == row[j] &&
+                        !mark[j] && j != from) {
+                        mark[j] = 1;
+                        columns[count++] = static_cast<unsigned int>(j);
+                    }
+                }
+            }
+            for (size_t t = 0; t < count; ++t) {
+                out[columns[t]] = inf;
+            }
+            // 从未受影响的列取得初始距离
+            for (size_t k = 0; k < n; ++k) {
+                if (mark[k] || out[k] == inf) {
+                    continue;
+                }
+                const int* wk = weights + k * n;
+                for (size_t t = 0; t < count; ++t) {
+                    const unsigned int j = columns[t];
+                    if (wk[j] >= 0 &&
+                        static_cast<int64_t>(out[k]) + wk[j] < out[j]) {
+                        out[j] = out[k] + wk[j];
+                    }
+                }
+            }
+            // 在受影响的列之间运行稠密的Dijkstra，已确定的列标记为2
+            for (;;) {
+                size_t best = count;
+                int len = inf;
+                for (size_t t = 0; t < count; ++t) {
+                    const unsigned int j = columns[t];
+                    if (mark[j] == 1 && out[j] < len) {
+                        len = out[j];
+                        best = t;
+                    }
+                }
+                if (best == count) {
+                    break;
+                }
+                const unsigned int v = columns[best];
+                mark[v] = 2;
+                const int* wv = weights + v * n;
+                for (size_t t = 0; t < count; ++t) {
+                    const unsigned int j = columns[t];
+                    if (mark[j] == 1 && wv[j] >= 0 &&
+                        static_cast<int64_t>(len) + wv[j] < out[j]) {
+                        out[j] = len + wv[j];
+                    }
+                }
+            }
+            for (size_t t = 0; t < count; ++t) {
+                mark[columns[t]] = 0;
+            }
+        }
+
+        /**
+         * 第2步中松弛一条变短的边(u, v, w)，行之间互不依赖，第v行不会变化。
+         */
+        void relax(const size_t u, const size_t v, const int w,
+                   task_pool& pool) {
+            const size_t n = vertex_count();
+            int* d = _dist.data();
+            if (w >= d[u * n + v]) {
+                return;
+            }
+            const int* dv = d + v * n;
+            pool.parallel_for(0, n, 64, [&](size_t lo, size_t hi) {
+                for (size_t i = lo; i < hi; ++i) {
+                    int* di = d + i * n;
+                    if (i == v || di[u] == inf ||
+                        static_cast<int64_t>(di[u]) + w >= di[v]) {
+                        continue;
+                    }
+                    const int64_t through = static_cast<int64_t>(di[u]) + w;
+                    for (size_t j = 0; j < n; ++j) {
+                        if (dv[j] != inf && through + dv[j] < di[j]) {
+                            di[j] = static_cast<int>(through + dv[j]);
+                        }
+                    }
+                }
+            });
+        }
+
+      public:
+        /**
+         * 受影响的行数与变长的边数之积超过V²/`full_ratio`时改为整体重新计算。
+         */
+        static constexpr size_t full_ratio = 32;
+
+        /**
+         * @param graph 初始的图，会被复制
+         * @param threads 修复和重新计算使用的线程数，为0时使用硬件线程数
+         */
+        explicit dynamic_apsp(const directed_graph& graph,
+                              const unsigned threads = 1)
+            : directed_graph(graph), _threads(threads),
+              _snapshot(*_connection_matrix),
+              _dist(all_pairs_shortest_path(threads)),
+              _dirty_rows(new unsigned char[graph.vertex_count()]()),
+              _pending(0), _repaired_rows(graph.vertex_count()) {}
+
+        dynamic_apsp(const dynamic_apsp&) = delete;
+
+        dynamic_apsp& operator=(const dynamic_apsp&) = delete;
+
+        ~dynamic_apsp() { delete[] _dirty_rows; }
+
+        void set_edge(const edge& edge) override {
+            directed_graph::set_edge(edge);
+            _dirty_rows[edge.from()] = 1;
+            _pending++;
+        }
+
+        void remove_edge(const edge& edge) override {
+            directed_graph::remove_edge(edge);
+            _dirty_rows[edge.from()] = 1;
+            _pending++;
+        }
+
+        /**
+         * 尚未修复的修改次数。
+         */
+        size_t pending() const { return _pending; }
+
+        /**
+         * 最近一次修复中第1步修复的行数，整体重新计算时为V。
+         */
+        size_t repaired_rows() const { return _repaired_rows; }
+
+        /**
+         * 修复累积的修改，没有修改时直接返回。
+         */
+        void repair() {
+            if (_pending == 0) {
+                return;
+            }
+            const size_t n = vertex_count();
+            const int* weights = _connection_matrix->data();
+            int* snapshot = _snapshot.data();
+            int* d = _dist.data();
+            // 收集变长且在最短路径上的边，然后在快照中只应用变长的修改
+            size_t edge_count = 0;
+            for (size_t u = 0; u < n; ++u) {
+                for (size_t v = 0; _dirty_rows[u] && v < n; ++v) {
+                    const int before = snapshot[u * n + v];
+                    edge_count += increased(before, weights[u * n + v]) &&
+                                  before == d[u * n + v];
+                }
+            }
+            unsigned int* edges = new unsigned int[3 * edge_count];
+            edge_count = 0;
+            for (size_t u = 0; u < n; ++u) {
+                for (size_t v = 0; _dirty_rows[u] && v < n; ++v) {
+                    const int before = snapshot[u * n + v];
+                    const int after = weights[u * n + v];
+                    if (increased(before, after) && before == d[u * n + v]) {
+                        edges[3 * edge_count] = static_cast<unsigned int>(u);
+                        edges[3 * edge_count + 1] =
+                            static_cast<unsigned int>(v);
+                        edges[3 * edge_count + 2] =
+                            static_cast<unsigned int>(before);
+                        edge_count++;
+                    }
+                    if (!decreased(before, after)) {
+                        snapshot[u * n + v] = after;
+                    }
+                }
+            }
+
+            // 变长的边在哪些行中是紧的
+            unsigned int* rows = new unsigned int[n];
+            size_t row_count = 0;
+            for (size_t i = 0; i < n && edge_count > 0; ++i) {
+                const int* di = d + i * n;
+                for (size_t e = 0; e < edge_count; ++e) {
+                    const int du = di[edges[3 * e]];
+                    if (du != inf &&
+                        static_cast<int64_t>(du) + edges[3 * e + 2] ==
+                            di[edges[3 * e + 1]]) {
+                        rows[row_count++] = static_cast<unsigned int>(i);
+                        break;
+                    }
+                }
+            }
+
+            task_pool pool(_threads);
+            if (row_count * edge_count > n * n / full_ratio) {
+                _dist = all_pairs_shortest_path(_threads);
+                _repaired_rows = n;
+            } else {
+                // 各行的新值先写入临时缓冲区，修复时读取的都是原来的距离
+                int* out = new int[row_count * n];
+                unsigned char* mark = new unsigned char[pool.size() * n]();
+                unsigned int* columns = new unsigned int[pool.size() * n];
+                pool.parallel_for(0, row_count, 1, [&](size_t lo, size_t hi) {
+                    const size_t w = pool.current_index();
+                    for (size_t k = lo; k < hi; ++k) {
+                        repair_row(rows[k], edges, edge_count, snapshot,
+                                   out + k * n, mark + w * n,
+                                   columns + w * n);
+                    }
+                });
+                for (size_t k = 0; k < row_count; ++k) {
+                    memcpy(d + rows[k] * n, out + k * n, sizeof(int) * n);
+                }
+                delete[] out;
+                delete[] mark;
+                delete[] columns;
+                _repaired_rows = row_count;
+
+                // 此时快照与当前矩阵只在变短的边上不同
+                for (size_t u = 0; u < n; ++u) {
+                    for (size_t v = 0; _dirty_rows[u] && v < n; ++v) {
+                        const int w = weights[u * n + v];
+                        if (w != snapshot[u * n + v]) {
+                            relax(u, v, w, pool);
+                        }
+                    }
+                }
+            }
+            delete[] edges;
+            delete[] rows;
+            for (size_t u = 0; u < n; ++u) {
+                if (_dirty_rows[u]) {
+                    memcpy(snapshot + u * n, weights + u * n, sizeof(int) * n);
+                    _dirty_rows[u] = 0;
+                }
+            }
+            _pending = 0;
+        }
+
+        /**
+         * `from`到`to`的最短路径长度，不可达时为`dist::infinity`。
+         */
+        int distance(const size_t from, const size_t to) {
+            repair();
+            return _dist(from, to);
+        }
+
+        /**
+         * 整个距离矩阵，与`all_pairs_shortest_path()`的结果相同。
+         * 下一次修改后失效。
+         */
+        const matrix_t& distances() {
+            repair();
+            return _dist;
+        }
+    };
+} // namespace cym
@@ -1,8 +1,12 @@
 #pragma once
 
+#include "algorithm.h"
 #include "heap.h"
+#include "matrix.h"
 #include "multi_dimension_array.h"
-#include "set.h"
+#include "parallel.h"
+#include "union_find.h"
+#include <cstdint>
 
 namespace cym {
 
@@ -13,6 +17,8 @@ namespace cym {
       public:
         class edge {
           public:
+            edge() : _from(0), _to(0), _weight(0), _directed(true) {}
+
             edge(unsigned int from, unsigned int to, int weight, bool directed)
                 : _from(from), _to(to), _weight(weight), _directed(directed) {}
 
@@ -92,8 +98,248 @@ namespace cym {
         virtual size_t vertex_count() const = 0;
     };
 
-    class directed_graph : public graph {
+    /**
+     * 最小生成森林的边表和总权值。
+     */
+    class spanning_forest {
       private:
+        graph::edge* _edges;
+        size_t _size;
+        int64_t _weight;
+
+      public:
+        /**
+         * 空的森林，最多容纳`capacity`条边。
+         */
+        explicit spanning_forest(const size_t capacity)
+            : _edges(new graph::edge[capacity]), _size(0), _weight(0) {}
+
+        spanning_forest(const spanning_forest&) = delete;
+
+        spanning_forest(spanning_forest&& rhs) noexcept
+            : _edges(rhs._edges), _size(rhs._size), _weight(rhs._weight) {
+            rhs._edges = nullptr;
+            rhs._size = 0;
+            rhs._weight = 0;
+        }
+
+        spanning_forest& operator=(const spanning_forest&) = delete;
+
+        ~spanning_forest() { delete[] _edges; }
+
+        void push(const graph::edge& e) {
+            _edges[_size++] = e;
+            _weight += e.weight();
+        }
+
+        size_t size() const { return _size; }
+
+        int64_t weight() const { return _weight; }
+
+        const graph::edge* edges() const { return _edges; }
+
+        const graph::edge& operator[](const size_t i) const {
+            return _edges[i];
+        }
+    };
+
+    /**
+     * Kruskal算法求最小生成森林，边按无向处理，自环被忽略。
+     *
+     * 权值用基数排序（稳定）排成升序，再依次用`union_find`判断两端是否已连通，
+     * 代价为O(E + E·α(V))。权值相同的边按在`edges`中的位置先后选择，
+     * 因此结果与`boruvka()`相同。
+     */
+    inline spanning_forest kruskal(const size_t v_count, const graph::edge* edges,
+                                   const size_t e_count) {
+        int* keys = new int[e_count];
+        unsigned int* order = new unsigned int[e_count];
+        for (size_t i = 0; i < e_count; ++i) {
+            keys[i] = edges[i].weight();
+            order[i] = static_cast<unsigned int>(i);
+        }
+        sort::radix_sort(keys, order, e_count);
+        delete[] keys;
+
+        spanning_forest forest(v_count == 0 ? 0 : v_count - 1);
+        union_find sets(v_count);
+        for (size_t i = 0; i < e_count && sets.count() > 1; ++i) {
+            const graph::edge& e = edges[order[i]];
+            if (sets.unite(e.from(), e.to())) {
+                forest.push(e);
+            }
+        }
+        delete[] order;
+        return forest;
+    }
+
+    /**
+     * 多线程的Borůvka算法求最小生成森林，边按无向处理，自环被忽略。
+     *
+     * 每一轮中各线程并行扫描剩余的边，用比较交换为每个连通分量记录权值最小的
+     * 出边，再依次合并这些边的两端。剩余的边以两端所在分量的代表顶点存储，
+     * 合并后并行地把端点换成新的代表顶点，并删去两端已在同一分量中的边，
+     * 之后的轮次只访问这些收缩后的边。每一轮分量数至少减半，最多log V轮。
+     * 比较时权值相同的边按在`edges`中的位置区分，保证不会选出环，结果与`kruskal()`相同。
+     *
+     * @param threads 线程数，为0时使用硬件线程数
+     */
+    inline spanning_forest boruvka(const size_t v_count, const graph::edge* edges,
+                                   const size_t e_count, unsigned threads = 1) {
+        constexpr uint64_t none = UINT64_MAX;
+        constexpr size_t grain = 1 << 14;
+        threads = threads == 0 ? default_thread_count() : threads;
+        task_pool pool(threads);
+        const bool shared = pool.size() > 1;
+
+        // 每个代表顶点合并后所在分量的代表顶点，以及该分量当前最小的出边
+        // （高32位为权值，低32位为边号）
+        unsigned int* comp = new unsigned int[v_count];
+        uint64_t* best = new uint64_t[v_count];
+        unsigned int* roots = new unsigned int[v_count];
+        pool.parallel_for(0, v_count, grain, [&](size_t lo, size_t hi) {
+            for (size_t v = lo; v < hi; ++v) {
+                comp[v] = static_cast<unsigned int>(v);
+                best[v] = none;
+                roots[v] = static_cast<unsigned int>(v);
+            }
+        });
+        size_t root_count = v_count;
+
+        // 剩余的边：两端的代表顶点和边号，`kept`用于压缩
+        unsigned int* src = new unsigned int[e_count];
+        unsigned int* dst = new unsigned int[e_count];
+        unsigned int* ids = new unsigned int[e_count];
+        unsigned int* kept_src = new unsigned int[e_count];
+        unsigned int* kept_dst = new unsigned int[e_count];
+        unsigned int* kept_ids = new unsigned int[e_count];
+        pool.parallel_for(0, e_count, grain, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) {
+                src[i] = edges[i].from();
+                dst[i] = edges[i].to();
+                ids[i] = static_cast<unsigned int>(i);
+            }
+        });
+        size_t alive_count = e_count;
+        size_t* chunk_counts = new size_t[(e_count + grain - 1) / grain + 1];
+
+        auto update = [shared](uint64_t& slot, const uint64_t key) {
+            uint64_t old =
+                shared ? __atomic_load_n(&slot, __ATOMIC_RELAXED) : slot;
+            while (key < old) {
+                if (!shared) {
+                    slot = key;
+                    return;
+                }
+                if (__atomic_compare_exchange_n(&slot, &old, key, true,
+                                                __ATOMIC_RELAXED,
+                                                __ATOMIC_RELAXED)) {
+                    return;
+                }
+            }
+        };
+
+        spanning_forest forest(v_count == 0 ? 0 : v_count - 1);
+        union_find sets(v_count);
+        while (alive_count > 0) {
+            pool.parallel_for(0, alive_count, grain, [&](size_t lo, size_t hi) {
+                for (size_t i = lo; i < hi; ++i) {
+                    if (src[i] == dst[i]) {
+                        continue;
+                    }
+                    const uint32_t weight =
+                        static_cast<uint32_t>(edges[ids[i]].weight()) ^
+                        0x80000000u;
+                    const uint64_t key =
+                        (static_cast<uint64_t>(weight) << 32) | ids[i];
+                    update(best[src[i]], key);
+                    update(best[dst[i]], key);
+                }
+            });
+
+            // 两个分量可能选中同一条边，第二次合并时`unite()`返回false
+            for (size_t i = 0; i < root_count; ++i) {
+                const unsigned int r = roots[i];
+                if (best[r] != none) {
+                    const graph::edge& e =
+                        edges[static_cast<uint32_t>(best[r])];
+                    if (sets.unite(e.from(), e.to())) {
+                        forest.push(e);
+                    }
+                    best[r] = none;
+                }
+            }
+            size_t next_root_count = 0;
+            for (size_t i = 0; i < root_count; ++i) {
+                const unsigned int r = roots[i];
+                comp[r] = static_cast<unsigned int>(sets.find(r));
+                if (comp[r] == r) {
+                    roots[next_root_count++] = r;
+                }
+            }
+            root_count = next_root_count;
+
+            // 每块在原地换上新的代表顶点并删去分量内部的边，求前缀和后把各块拼接起来
+            const size_t chunks = (alive_count + grain - 1) / grain;
+            pool.parallel_for(0, alive_count, grain, [&](size_t lo, size_t hi) {
+                for (size_t c = lo / grain; c * grain < hi; ++c) {
+                    const size_t end = (c + 1) * grain < hi ? (c + 1) * grain : hi;
+                    size_t out = c * grain;
+                    for (size_t i = c * grain; i < end; ++i) {
+                        const unsigned int cu = comp[src[i]];
+                        const unsigned int cv = comp[dst[i]];
+                        if (cu != cv) {
+                            src[out] = cu;
+                            dst[out] = cv;
+                            ids[out] = ids[i];
+                            out++;
+                        }
+                    }
+                    chunk_counts[c] = out - c * grain;
+                }
+            });
+            size_t sum = 0;
+            for (size_t c = 0; c < chunks; ++c) {
+                const size_t count = chunk_counts[c];
+                chunk_counts[c] = sum;
+                sum += count;
+            }
+            chunk_counts[chunks] = sum;
+            pool.parallel_for(0, chunks, 1, [&](size_t lo, size_t hi) {
+                for (size_t c = lo; c < hi; ++c) {
+                    const size_t count = chunk_counts[c + 1] - chunk_counts[c];
+                    const size_t bytes = sizeof(unsigned int) * count;
+                    memcpy(kept_src + chunk_counts[c], src + c * grain, bytes);
+                    memcpy(kept_dst + chunk_counts[c], dst + c * grain, bytes);
+                    memcpy(kept_ids + chunk_counts[c], ids + c * grain, bytes);
+                }
+            });
+            unsigned int* t = src;
+            src = kept_src;
+            kept_src = t;
+            t = dst;
+            dst = kept_dst;
+            kept_dst = t;
+            t = ids;
+            ids = kept_ids;
+            kept_ids = t;
+            alive_count = sum;
+        }
+        delete[] comp;
+        delete[] best;
+        delete[] roots;
+        delete[] src;
+        delete[] dst;
+        delete[] ids;
+        delete[] kept_src;
+        delete[] kept_dst;
+        delete[] kept_ids;
+        delete[] chunk_counts;
+        return forest;
+    }
+
+    class directed_graph : public graph {
+      protected:
         matrix_t* _connection_matrix;
         size_t _v_count;
         size_t _e_count;
@@ -103,7 +349,7 @@ namespace cym {
             : _v_count(v_count), _e_count(0) {
             _connection_matrix = new matrix_t({v_count, v_count}, -1);
             for (size_t i = 0; i < _v_count; ++i) {
-                _connection_matrix->visit({i, i}) = 0;
+                (*_connection_matrix)(i, i) = 0;
             }
         }
 
@@ -113,18 +359,22 @@ namespace cym {
             _e_count = rhs._e_count;
         }
 
+        directed_graph& operator=(const directed_graph&) = delete;
+
+        ~directed_graph() { delete _connection_matrix; }
+
         void set_edge(const edge& edge) override {
             unsigned int from = edge.from();
             unsigned int to = edge.to();
             int weight = edge.weight();
-            _connection_matrix->visit({from, to}) = weight;
+            (*_connection_matrix)(from, to) = weight;
             _e_count++;
         }
 
         void remove_edge(const edge& edge) override {
             unsigned int from = edge.from();
             unsigned int to = edge.to();
-            _connection_matrix->visit({from, to}) = 0;
+            (*_connection_matrix)(from, to) = -1;
             _e_count--;
         }
 
@@ -135,148 +385,117 @@ namespace cym {
         edge get_edge(size_t from, size_t to) override {
             return {static_cast<unsigned int>(from),
                     static_cast<unsigned int>(to),
-                    _connection_matrix->visit({from, to}), false};
+                    (*_connection_matrix)(from, to), false};
         }
 
+        /**
+         * 邻接矩阵，`(i, j)`为边i -> j的权值，不存在时为-1，对角线初始为0。
+         */
+        const matrix_t& adjacency_matrix() const { return *_connection_matrix; }
+
         /**
          * 求最短路径，对于给定的起点`from`，使用Dijkstra算法求出`from`到每个顶点之间的最短路径。
+         * 与`all_pairs_shortest_path()`相同，权值为负的项表示没有边，权值为0的边可以经过。
          * @param from 最短路径的起点
-         * @return 返回从`from`到个点的最短路径
+         * @return 返回从`from`到个点的最短路径，不可达或长度不小于INT_MAX时为
+         *         `dist::infinity`
          */
         vector_t shortest_path(const size_t from) const {
-            bool* visited = new bool[_v_count];
-            memset(visited, 0, sizeof(int) * _v_count);
-            dist* dists = new dist[_v_count];
-            for (int i = 0; i < _v_count; ++i) {
-                dists[i].len = dist::infinity;
-                dists[i].index = i;
-                dists[i].pre = from;
-            }
-            dists[from].len = 0;
-            heap<dist> current_dist(heap_type::min);
-            current_dist.insert(dists[from]);
-            for (int i = 0; i < _v_count; ++i) {
-                bool found_min = false;
-                dist min;
-                while (!current_dist.empty()) {
-                    min = current_dist.top();
-                    current_dist.delete_top();
-                    if (!visited[min.index]) {
-                        found_min = true;
-                        break;
-                    }
-                }
-                if (!found_min) {
-                    break;
-                }
-                int v = min.index;
-                visited[v] = true;
-                for (int u = 0; u < _v_count; ++u) {
-                    auto begin = static_cast<size_t>(v);
-                    auto end = static_cast<size_t>(u);
-                    if (_connection_matrix->visit({begin, end}) < 1) {
+            vector_t path_vector({_v_count}, dist::infinity);
+            int* dists = path_vector.data();
+            indexed_heap<int> queue(_v_count);
+            dists[from] = 0;
+            queue.push_or_decrease(from, 0);
+            while (!queue.empty()) {
+                const size_t v = queue.top();
+                const int len = queue.top_key();
+                queue.pop();
+                for (size_t u = 0; u < _v_count; ++u) {
+                    const int weight = (*_connection_matrix)(v, u);
+                    if (weight < 0) {
                         continue;
                     }
-                    if (dists[u].len == dist::infinity ||
-                        dists[u].len > dists[v].len + _connection_matrix->visit(
-                                                          {begin, end})) {
-                        dists[u].len = dists[v].len +
-                                       _connection_matrix->visit({begin, end});
-                        dists[u].pre = v;
-                        current_dist.insert(dists[u]);
+                    const int64_t candidate = static_cast<int64_t>(len) + weight;
+                    if (candidate < dists[u]) {
+                        dists[u] = static_cast<int>(candidate);
+                        queue.push_or_decrease(u, dists[u]);
                     }
                 }
             }
-            vector_t path_vector({_v_count}, 0);
-            for (size_t i = 0; i < _v_count; ++i) {
-                if (i == from) {
-                    continue;
-                }
-                path_vector.visit({i}) = dists[i].len;
-            }
             return path_vector;
         }
 
-      private:
-        static void ensure_non_negative_weight(matrix_t& matrix,
-                                               const size_t from,
-                                               const size_t to) {
-            if (matrix.visit({from, to}) < 0) {
-                matrix.visit({from, to}) = dist::infinity;
-            }
-        }
-
-      public:
         /**
          * 求最短路径，未指定起点，使用Floyd算法求每两个顶点之间的最短路径。
-         * @return 返回每两个顶点之间的最短路径
+         * @return 返回每两个顶点之间的最短路径，不可达时为`dist::infinity`
          */
-        matrix_t shortest_path() const {
+        matrix_t shortest_path() const { return all_pairs_shortest_path(); }
+
+        /**
+         * 使用分块的Floyd–Warshall算法求每两个顶点之间的最短路径，见`floyd_warshall()`。
+         * 权值为负的边（即不存在的边）按不可达处理。与`shortest_path(from)`一样，
+         * 长度不小于INT_MAX的路径为`dist::infinity`；路径长度可能达到2^30时
+         * 改用较慢的int64计算。
+         *
+         * @param threads 线程数，为0时使用硬件线程数
+         * @param next 不为空时写入路径矩阵，`(*next)(i, j)`为从i到j的最短路径上
+         *             i之后的顶点，不可达时为-1
+         */
+        matrix_t all_pairs_shortest_path(const unsigned threads = 1,
+                                         matrix_t* next = nullptr) const {
             matrix_t path_matrix(*_connection_matrix);
-            for (size_t i = 0; i < _v_count; ++i) {
-                for (size_t j = 0; j < _v_count; ++j) {
-                    for (size_t k = 0; k < _v_count; ++k) {
-                        if (i == j || i == k || j == k) {
-                            continue;
-                        }
-                        ensure_non_negative_weight(path_matrix, i, j);
-                        ensure_non_negative_weight(path_matrix, i, k);
-                        ensure_non_negative_weight(path_matrix, k, j);
-                        const bool ij_is_infinity =
-                            path_matrix.visit({i, j}) == dist::infinity;
-                        const bool others_are_not_infinity =
-                            path_matrix.visit({i, k}) != dist::infinity &&
-                            path_matrix.visit({k, j}) != dist::infinity;
-                        const int ik_kj_weight_sum = path_matrix.visit({i, k}) +
-                                                     path_matrix.visit({k, j});
-                        const bool has_shorter_path =
-                            path_matrix.visit({i, j}) > ik_kj_weight_sum;
-
-                        if (others_are_not_infinity &&
-                            (ij_is_infinity || has_shorter_path)) {
-                            path_matrix.visit({i, j}) = ik_kj_weight_sum;
-                        }
-                    }
+            const size_t storage = path_matrix.storage_size();
+            int* weights = path_matrix.data();
+            for (size_t i = 0; i < storage; ++i) {
+                if (weights[i] < 0) {
+                    weights[i] = dist::infinity;
                 }
             }
+            if (next != nullptr) {
+                *next = matrix_t({_v_count, _v_count});
+                floyd_warshall(md_view<int, 2>(path_matrix),
+                               md_view<int, 2>(*next), threads);
+            } else {
+                floyd_warshall(md_view<int, 2>(path_matrix), threads);
+            }
             return path_matrix;
         }
 
+        /**
+         * 最小生成树，只包含`root`所在的连通分量。
+         *
+         * 矩阵中对角线以外权值非负的项都作为无向边，用`kruskal()`求最小生成森林后
+         * 取出与`root`连通的边，每条边只在结果中设置一个方向。
+         */
         directed_graph minimum_spanning_tree(const size_t root) {
-            directed_graph mst(_v_count);
-
-            set<size_t> vertex_set(_v_count);
-            set<size_t> to_add_vertex_set(_v_count);
+            size_t e_count = 0;
             for (size_t i = 0; i < _v_count; ++i) {
-                if (i == root) {
-                    continue;
+                for (size_t j = 0; j < _v_count; ++j) {
+                    e_count += i != j && (*_connection_matrix)(i, j) >= 0;
                 }
-                to_add_vertex_set.put(i);
             }
-            vertex_set.put(root);
-            while (vertex_set.count() != _v_count) {
-                list<size_t> added = vertex_set.get_all();
-                list<size_t> to_add = to_add_vertex_set.get_all();
-                int min_weight = dist::infinity;
-                int from = -1;
-                int to = -1;
-                for (size_t i = 0; i < added.size(); i++) {
-                    for (size_t j = 0; j < to_add.size(); j++) {
-                        int current_weight =
-                            _connection_matrix->visit({added[i], to_add[j]});
-                        if (0 < current_weight && current_weight < min_weight) {
-                            min_weight = current_weight;
-                            from = added[i];
-                            to = to_add[j];
-                        }
+            edge* edges = new edge[e_count];
+            size_t k = 0;
+            for (size_t i = 0; i < _v_count; ++i) {
+                for (size_t j = 0; j < _v_count; ++j) {
+                    const int weight = (*_connection_matrix)(i, j);
+                    if (i != j && weight >= 0) {
+                        edges[k++] = edge(i, j, weight, true);
                     }
                 }
-                if (to == -1) {
-                    break;
+            }
+            const spanning_forest forest = kruskal(_v_count, edges, e_count);
+            delete[] edges;
+
+            union_find components(_v_count);
+            for (size_t i = 0; i < forest.size(); ++i) {
+                components.unite(forest[i].from(), forest[i].to());
+            }
+            directed_graph mst(_v_count);
+            for (size_t i = 0; i < forest.size(); ++i) {
+                if (components.same(forest[i].from(), root)) {
+                    mst.set_edge(forest[i]);
                 }
-                vertex_set.put(to);
-                to_add_vertex_set.remove(to);
-                mst.set_edge(edge(from, to, min_weight, true));
             }
             return mst;
         }
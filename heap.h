@@ -1,6 +1,8 @@
 #pragma once
 
 #include "vlarray.h"
+#include <cstddef>
+#include <cstdint>
 
 namespace cym {
 
@@ -26,10 +28,18 @@ namespace cym {
             }
         }
 
+        heap(const heap&) = delete;
+
+        heap& operator=(const heap&) = delete;
+
+        ~heap() { delete _el; }
+
         heap_type type() const { return _ty; }
 
         bool empty() const { return _used == 0; }
 
+        size_t size() const { return _used; }
+
       private:
         /**
          * 用于insert()中，寻找新插入元素的位置。判断是否需要将parent移动到child的位置。
@@ -38,7 +48,7 @@ namespace cym {
          */
         bool _move_parent_to_child(T& parent, T& item) {
             const bool result = parent < item;
-            return _ty == heap_type::max == result;
+            return (_ty == heap_type::max) == result;
         }
 
         static int parent_for(const int child) { return (child - 1) / 2; }
@@ -62,7 +72,7 @@ namespace cym {
          */
         bool _use_right_child(T& left, T& right) {
             const bool result = left < right;
-            return _ty == heap_type::max == result;
+            return (_ty == heap_type::max) == result;
         }
 
         /**
@@ -70,7 +80,7 @@ namespace cym {
          */
         bool _item_position_found(T& item, T& child) {
             const bool result = item >= child;
-            return _ty == heap_type::max == result;
+            return (_ty == heap_type::max) == result;
         }
 
       public:
@@ -80,17 +90,10 @@ namespace cym {
             }
             T item = _el->at(_used - 1);
             _used--;
-            int parent_index, child_index;
-            for (parent_index = 0; parent_index < _used;
-                 parent_index = child_index) {
-                if (parent_index == 0) {
-                    child_index = 1;
-                } else {
-                    child_index = parent_index * 2;
-                }
-                if (child_index > _used) {
-                    break;
-                }
+            size_t parent_index = 0;
+            size_t child_index;
+            for (; parent_index * 2 + 1 < _used; parent_index = child_index) {
+                child_index = parent_index * 2 + 1;
                 if (child_index < _used - 1 &&
                     _use_right_child(_el->at(child_index),
                                      _el->at(child_index + 1))) {
@@ -104,4 +107,136 @@ namespace cym {
             _el->at(parent_index) = item;
         }
     };
+
+    /**
+     * 元素为0到capacity-1之间的整数、按优先级取最小值的堆，支持降低优先级。
+     *
+     * 用4叉堆存放(优先级, 元素)对，另外记录每个元素在堆中的位置，
+     * 同一个元素最多在堆中出现一次。Dijkstra算法中以顶点为元素、距离为优先级，
+     * 堆的大小不超过顶点数，每次松弛的代价为O(log V)。
+     */
+    template <typename Key>
+    class indexed_heap {
+      private:
+        struct entry {
+            Key key;
+            unsigned int id;
+        };
+
+        static constexpr unsigned int npos = UINT32_MAX;
+
+        size_t _capacity;
+        size_t _used;
+        entry* _heap;
+        unsigned int* _pos;
+
+        void place(const size_t i, const entry& e) {
+            _heap[i] = e;
+            _pos[e.id] = static_cast<unsigned int>(i);
+        }
+
+        void sift_up(size_t i, const entry e) {
+            while (i > 0) {
+                const size_t parent = (i - 1) / 4;
+                if (!(e.key < _heap[parent].key)) {
+                    break;
+                }
+                place(i, _heap[parent]);
+                i = parent;
+            }
+            place(i, e);
+        }
+
+        void sift_down(size_t i, const entry e) {
+            for (;;) {
+                const size_t first = i * 4 + 1;
+                if (first >= _used) {
+                    break;
+                }
+                const size_t last = first + 4 < _used ? first + 4 : _used;
+                size_t child = first;
+                for (size_t c = first + 1; c < last; ++c) {
+                    if (_heap[c].key < _heap[child].key) {
+                        child = c;
+                    }
+                }
+                if (!(_heap[child].key < e.key)) {
+                    break;
+                }
+                place(i, _heap[child]);
+                i = child;
+            }
+            place(i, e);
+        }
+
+      public:
+        explicit indexed_heap(const size_t capacity)
+            : _capacity(capacity), _used(0), _heap(new entry[capacity]),
+              _pos(new unsigned int[capacity]) {
+            for (size_t i = 0; i < capacity; ++i) {
+                _pos[i] = npos;
+            }
+        }
+
+        indexed_heap(const indexed_heap&) = delete;
+
+        indexed_heap& operator=(const indexed_heap&) = delete;
+
+        ~indexed_heap() {
+            delete[] _heap;
+            delete[] _pos;
+        }
+
+        size_t capacity() const { return _capacity; }
+
+        bool empty() const { return _used == 0; }
+
+        size_t size() const { return _used; }
+
+        bool contains(const size_t id) const { return _pos[id] != npos; }
+
+        /**
+         * 堆中元素`id`的优先级，`id`必须在堆中。
+         */
+        Key key(const size_t id) const { return _heap[_pos[id]].key; }
+
+        /**
+         * 把`id`以优先级`key`放入堆中；已在堆中时只在`key`更小时降低其优先级。
+         * @return 堆是否被修改
+         */
+        bool push_or_decrease(const size_t id, const Key key) {
+            const entry e{key, static_cast<unsigned int>(id)};
+            if (_pos[id] == npos) {
+                sift_up(_used++, e);
+                return true;
+            }
+            const size_t i = _pos[id];
+            if (!(key < _heap[i].key)) {
+                return false;
+            }
+            sift_up(i, e);
+            return true;
+        }
+
+        unsigned int top() const { return _heap[0].id; }
+
+        Key top_key() const { return _heap[0].key; }
+
+        void pop() {
+            _pos[_heap[0].id] = npos;
+            if (--_used > 0) {
+                sift_down(0, _heap[_used]);
+            }
+        }
+
+        /**
+         * 清空堆，代价与堆中剩余的元素个数成正比，可以在多次查询之间复用。
+         */
+        void clear() {
+            for (size_t i = 0; i < _used; ++i) {
+                _pos[_heap[i].id] = npos;
+            }
+            _used = 0;
+        }
+    };
 } // namespace cym
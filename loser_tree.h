@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+
+namespace cym {
+
+    /**
+     * 败者树，用于k路归并。
+     *
+     * 每个叶子对应一路输入的当前元素，内部节点保存比较中的失败者，`_tree[0]`保存
+     * 最终的胜者。更新胜者所在的叶子后只需沿着到根的路径比较log2(k)次。
+     * 相等的元素中编号较小的一路获胜，因此按输入编号顺序归并时是稳定的。
+     */
+    template <typename T, typename Compare>
+    class loser_tree {
+      private:
+        size_t _k;
+        size_t* _tree;
+        T* _keys;
+        bool* _done;
+        Compare _comp;
+
+        /**
+         * 判断第a路是否胜过第b路，已经耗尽的一路视为无穷大。
+         */
+        bool _beats(const size_t a, const size_t b) const {
+            if (_done[a] || _done[b]) {
+                return !_done[a] && (_done[b] || a < b);
+            }
+            if (_comp(_keys[a], _keys[b])) {
+                return true;
+            }
+            return !_comp(_keys[b], _keys[a]) && a < b;
+        }
+
+        void _replay(const size_t leaf) {
+            size_t winner = leaf;
+            for (size_t node = (leaf + _k) / 2; node > 0; node /= 2) {
+                if (_beats(_tree[node], winner)) {
+                    const size_t tmp = _tree[node];
+                    _tree[node] = winner;
+                    winner = tmp;
+                }
+            }
+            _tree[0] = winner;
+        }
+
+      public:
+        explicit loser_tree(const size_t k, Compare comp = Compare())
+            : _k(k), _comp(comp) {
+            _tree = new size_t[k];
+            _keys = new T[k];
+            _done = new bool[k];
+            for (size_t i = 0; i < k; ++i) {
+                _tree[i] = 0;
+                _done[i] = true;
+            }
+        }
+
+        loser_tree(const loser_tree&) = delete;
+
+        loser_tree& operator=(const loser_tree&) = delete;
+
+        ~loser_tree() {
+            delete[] _tree;
+            delete[] _keys;
+            delete[] _done;
+        }
+
+        /**
+         * 设置第i路的初始元素，所有路都设置完成后调用`build()`。
+         * 没有调用`set()`的路视为空。
+         */
+        void set(const size_t i, const T& key) {
+            _keys[i] = key;
+            _done[i] = false;
+        }
+
+        void build() {
+            // 叶子位于[k, 2k)，内部节点位于[1, k)，自底向上求出每个节点的胜者
+            size_t* winners = new size_t[2 * _k];
+            for (size_t i = 0; i < _k; ++i) {
+                winners[_k + i] = i;
+            }
+            for (size_t node = _k - 1; node > 0; --node) {
+                const size_t l = winners[2 * node];
+                const size_t r = winners[2 * node + 1];
+                if (_beats(l, r)) {
+                    winners[node] = l;
+                    _tree[node] = r;
+                } else {
+                    winners[node] = r;
+                    _tree[node] = l;
+                }
+            }
+            _tree[0] = _k == 1 ? 0 : winners[1];
+            delete[] winners;
+        }
+
+        bool empty() const { return _done[_tree[0]]; }
+
+        /**
+         * 胜者所在的路编号。
+         */
+        size_t top_index() const { return _tree[0]; }
+
+        const T& top() const { return _keys[_tree[0]]; }
+
+        /**
+         * 用胜者所在路的下一个元素替换胜者。
+         */
+        void replace_top(const T& key) {
+            const size_t leaf = _tree[0];
+            _keys[leaf] = key;
+            _replay(leaf);
+        }
+
+        /**
+         * 胜者所在的路已经耗尽。
+         */
+        void pop_top() {
+            const size_t leaf = _tree[0];
+            _done[leaf] = true;
+            _replay(leaf);
+        }
+    };
+} // namespace cym
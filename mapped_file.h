@@ -0,0 +1,233 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CYM_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define CYM_HAS_MMAP 0
+#endif
+
+namespace cym {
+
+    enum class map_mode {
+        read_only,
+        /**
+         * 修改直接写回文件（MAP_SHARED），其他进程映射同一文件时可以看到。
+         */
+        read_write
+    };
+
+    /**
+     * 传给madvise的访问模式提示。
+     */
+    enum class map_advice {
+        normal,
+        /**
+         * 顺序访问，内核加大预读并尽早回收已读过的页。
+         */
+        sequential,
+        /**
+         * 随机访问，关闭预读。
+         */
+        random,
+        /**
+         * 即将访问，内核在后台开始读入这些页。
+         */
+        will_need,
+        /**
+         * 暂时不再访问，内核可以回收这些页，修改过的页会先写回文件。
+         */
+        dont_need
+    };
+
+    /**
+     * 把整个文件映射到内存，析构时解除映射。
+     *
+     * 映射后页在第一次访问时才从文件读入，打开任意大小的文件都是瞬间完成的；
+     * 内存不足时内核会把页换出到文件本身，因此可以处理比内存大的文件。
+     * 不支持mmap的平台上`open()`和`create()`总是返回false。
+     */
+    class mapped_file {
+      private:
+        unsigned char* _data;
+        size_t _size;
+        map_mode _mode;
+
+#if CYM_HAS_MMAP
+        bool map(const int fd, const size_t size, const map_mode mode) {
+            const int prot = mode == map_mode::read_only
+                                 ? PROT_READ
+                                 : PROT_READ | PROT_WRITE;
+            void* p = mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+            close(fd);
+            if (p == MAP_FAILED) {
+                return false;
+            }
+            _data = static_cast<unsigned char*>(p);
+            _size = size;
+            _mode = mode;
+            return true;
+        }
+
+        static int to_native(const map_advice advice) {
+            switch (advice) {
+            case map_advice::sequential:
+                return MADV_SEQUENTIAL;
+            case map_advice::random:
+                return MADV_RANDOM;
+            case map_advice::will_need:
+                return MADV_WILLNEED;
+            case map_advice::dont_need:
+                return MADV_DONTNEED;
+            default:
+                return MADV_NORMAL;
+            }
+        }
+
+        static size_t page_size() {
+            static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            return size;
+        }
+#endif
+
+      public:
+        mapped_file()
+            : _data(nullptr), _size(0), _mode(map_mode::read_only) {}
+
+        mapped_file(const mapped_file&) = delete;
+
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        mapped_file(mapped_file&& rhs) noexcept
+            : _data(rhs._data), _size(rhs._size), _mode(rhs._mode) {
+            rhs._data = nullptr;
+            rhs._size = 0;
+        }
+
+        mapped_file& operator=(mapped_file&& rhs) noexcept {
+            std::swap(_data, rhs._data);
+            std::swap(_size, rhs._size);
+            std::swap(_mode, rhs._mode);
+            return *this;
+        }
+
+        ~mapped_file() { unmap(); }
+
+        /**
+         * 映射已有的文件，原来的映射先被解除。
+         * @return 文件不存在、为空或映射失败时返回false
+         */
+        bool open(const char* path, const map_mode mode = map_mode::read_only) {
+            unmap();
+#if CYM_HAS_MMAP
+            const int fd =
+                ::open(path, mode == map_mode::read_only ? O_RDONLY : O_RDWR);
+            if (fd < 0) {
+                return false;
+            }
+            struct stat st;
+            if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+                close(fd);
+                return false;
+            }
+            return map(fd, static_cast<size_t>(st.st_size), mode);
+#else
+            (void)path;
+            (void)mode;
+            return false;
+#endif
+        }
+
+        /**
+         * 创建（或截断）长度为`size`字节的文件并以读写模式映射。
+         * 文件是稀疏的，内容全为0，只有写入过的页才占用磁盘空间。
+         */
+        bool create(const char* path, const size_t size) {
+            unmap();
+#if CYM_HAS_MMAP
+            if (size == 0) {
+                return false;
+            }
+            const int fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0) {
+                return false;
+            }
+            if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+                close(fd);
+                return false;
+            }
+            return map(fd, size, map_mode::read_write);
+#else
+            (void)path;
+            (void)size;
+            return false;
+#endif
+        }
+
+        /**
+         * 解除映射。读写模式下修改过的页由内核在之后写回文件。
+         */
+        void unmap() {
+#if CYM_HAS_MMAP
+            if (_data != nullptr) {
+                munmap(_data, _size);
+            }
+#endif
+            _data = nullptr;
+            _size = 0;
+        }
+
+        bool is_open() const { return _data != nullptr; }
+
+        size_t size() const { return _size; }
+
+        map_mode mode() const { return _mode; }
+
+        unsigned char* data() { return _data; }
+
+        const unsigned char* data() const { return _data; }
+
+        /**
+         * 对从`offset`开始的`length`字节给出访问提示，范围按页对齐后传给madvise。
+         */
+        bool advise(const map_advice advice, size_t offset = 0,
+                    size_t length = SIZE_MAX) const {
+#if CYM_HAS_MMAP
+            if (_data == nullptr || offset >= _size) {
+                return false;
+            }
+            length = length < _size - offset ? length : _size - offset;
+            const size_t begin = offset / page_size() * page_size();
+            return madvise(_data + begin, offset + length - begin,
+                           to_native(advice)) == 0;
+#else
+            (void)advice;
+            (void)offset;
+            (void)length;
+            return false;
+#endif
+        }
+
+        /**
+         * 把修改过的页写回文件，`wait`为false时只发起写回不等待完成。
+         */
+        bool sync(const bool wait = true) const {
+#if CYM_HAS_MMAP
+            if (_data == nullptr || _mode == map_mode::read_only) {
+                return false;
+            }
+            return msync(_data, _size, wait ? MS_SYNC : MS_ASYNC) == 0;
+#else
+            (void)wait;
+            return false;
+#endif
+        }
+    };
+} // namespace cym
@@ -0,0 +1,860 @@
+#pragma once
+
+#include "md_view.h"
+#include "multi_dimension_array.h"
+#include "parallel.h"
+#include "simd.h"
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace cym {
+
+    namespace gemm_detail {
+
+        /**
+         * 分块参数（按元素计）。微内核一次计算mr×nr的C块，nr为两个寄存器宽；
+         * A的mc×kc块打包后约占L2的一半，B的kc×nc块打包后放在L3中，
+         * 一个kc×nr的B微面板位于L1中。
+         */
+        constexpr size_t mr = 6;
+        constexpr size_t mc = 96;
+        constexpr size_t kc = 256;
+        constexpr size_t nc = 3072;
+
+        template <typename T>
+        constexpr size_t nr = 64 / sizeof(T);
+
+        /**
+         * 普通的乘加半环。
+         */
+        template <typename T>
+        struct plus_times {
+            static T identity() { return 0; }
+            static T pack(const T x) { return x; }
+            static T update(const T acc, const T a, const T b) {
+                return acc + a * b;
+            }
+            static T combine(const T c, const T acc) { return c + acc; }
+            static T finish(const T x) { return x; }
+        };
+
+        /**
+         * (min, +)半环。浮点数直接使用无穷大。int32以INT_MAX表示无穷大：
+         * 打包时不小于limit（2^29）的元素换成inf（约2^30），不大于-limit的元素
+         * 换成-limit，两数相加不会溢出，无穷大加上任意有限值仍不小于limit；
+         * 结果不小于limit时写回INT_MAX。`min_plus()`拒绝会被截断的输入。
+         */
+        template <typename T>
+        struct min_plus_ops {
+            static constexpr bool is_int = std::is_integral<T>::value;
+            static constexpr T limit = is_int ? T(1 << 29) : T(0);
+            static constexpr T inf = is_int ? T((1 << 30) - 1) : T(0);
+
+            static T infinity() {
+                if constexpr (is_int) {
+                    return std::numeric_limits<T>::max();
+                } else {
+                    return std::numeric_limits<T>::infinity();
+                }
+            }
+            static T identity() { return is_int ? inf : infinity(); }
+            static T pack(const T x) {
+                if constexpr (is_int) {
+                    return x >= limit ? inf : x <= -limit ? -limit : x;
+                } else {
+                    return x;
+                }
+            }
+            static T update(const T acc, const T a, const T b) {
+                return a + b < acc ? a + b : acc;
+            }
+            static T combine(const T c, const T acc) {
+                return acc < c ? acc : c;
+            }
+            static T finish(const T x) {
+                if constexpr (is_int) {
+                    return x >= limit ? infinity() : x;
+                } else {
+                    return x;
+                }
+            }
+        };
+
+        /**
+         * 把A的m×k块打包为若干mr行的微面板，每个面板内按列存放，
+         * 微内核每次读取连续的mr个元素。不足mr行的部分补0。
+         */
+        template <typename S, typename T>
+        void pack_a(const T* a, const size_t lda, const size_t m,
+                    const size_t k, T* out) {
+            for (size_t i0 = 0; i0 < m; i0 += mr) {
+                const size_t rows = m - i0 < mr ? m - i0 : mr;
+                for (size_t p = 0; p < k; ++p) {
+                    size_t r = 0;
+                    for (; r < rows; ++r) {
+                        *out++ = S::pack(a[(i0 + r) * lda + p]);
+                    }
+                    for (; r < mr; ++r) {
+                        *out++ = T(0);
+                    }
+                }
+            }
+        }
+
+        /**
+         * 把B的k×n块打包为若干nr列的微面板，每个面板内按行存放。
+         */
+        template <typename S, typename T>
+        void pack_b(const T* b, const size_t ldb, const size_t k,
+                    const size_t n, T* out) {
+            constexpr size_t w = nr<T>;
+            for (size_t j0 = 0; j0 < n; j0 += w) {
+                const size_t cols = n - j0 < w ? n - j0 : w;
+                for (size_t p = 0; p < k; ++p) {
+                    const T* row = b + p * ldb + j0;
+                    size_t j = 0;
+                    for (; j < cols; ++j) {
+                        *out++ = S::pack(row[j]);
+                    }
+                    for (; j < w; ++j) {
+                        *out++ = T(0);
+                    }
+                }
+            }
+        }
+
+        /**
+         * 把微内核算出的mr×nr块写回C的左上m×n部分。
+         * `first`为true时是第一个kc块，直接覆盖C，否则与C中已有的值合并。
+         */
+        template <typename S, typename T>
+        void store_tile(const T (&tile)[mr][nr<T>], T* c, const size_t ldc,
+                        const size_t m, const size_t n, const bool first) {
+            for (size_t r = 0; r < m; ++r) {
+                T* row = c + r * ldc;
+                for (size_t j = 0; j < n; ++j) {
+                    row[j] = S::finish(first ? tile[r][j]
+                                             : S::combine(row[j], tile[r][j]));
+                }
+            }
+        }
+
+        template <typename S, typename T>
+        void micro_kernel_scalar(const size_t k, const T* a, const T* b, T* c,
+                                 const size_t ldc, const size_t m,
+                                 const size_t n, const bool first) {
+            constexpr size_t w = nr<T>;
+            T tile[mr][w];
+            for (size_t r = 0; r < mr; ++r) {
+                for (size_t j = 0; j < w; ++j) {
+                    tile[r][j] = S::identity();
+                }
+            }
+            for (size_t p = 0; p < k; ++p) {
+                for (size_t r = 0; r < mr; ++r) {
+                    const T av = a[r];
+                    for (size_t j = 0; j < w; ++j) {
+                        tile[r][j] = S::update(tile[r][j], av, b[j]);
+                    }
+                }
+                a += mr;
+                b += w;
+            }
+            store_tile<S>(tile, c, ldc, m, n, first);
+        }
+
+#if CYM_SIMD_X86
+        CYM_TARGET_AVX2_FMA inline __m256 vupdate(plus_times<float>, __m256 acc,
+                                                  __m256 a, __m256 b) {
+            return _mm256_fmadd_ps(a, b, acc);
+        }
+
+        CYM_TARGET_AVX2_FMA inline __m256d vupdate(plus_times<double>,
+                                                   __m256d acc, __m256d a,
+                                                   __m256d b) {
+            return _mm256_fmadd_pd(a, b, acc);
+        }
+
+        CYM_TARGET_AVX2 inline __m256i vupdate(plus_times<int32_t>, __m256i acc,
+                                               __m256i a, __m256i b) {
+            return _mm256_add_epi32(acc, _mm256_mullo_epi32(a, b));
+        }
+
+        template <typename T, typename R>
+        CYM_TARGET_AVX2 R vupdate(min_plus_ops<T>, R acc, R a, R b) {
+            using V = simd_detail::avx2_vec<T>;
+            return V::min(acc, V::add(a, b));
+        }
+
+        template <typename T, typename R>
+        CYM_TARGET_AVX2 R vcombine(plus_times<T>, R c, R acc) {
+            return simd_detail::avx2_vec<T>::add(c, acc);
+        }
+
+        template <typename T, typename R>
+        CYM_TARGET_AVX2 R vcombine(min_plus_ops<T>, R c, R acc) {
+            return simd_detail::avx2_vec<T>::min(c, acc);
+        }
+
+        template <typename T, typename R>
+        CYM_TARGET_AVX2 R vfinish(plus_times<T>, R x) {
+            return x;
+        }
+
+        template <typename T, typename R>
+        CYM_TARGET_AVX2 R vfinish(min_plus_ops<T>, R x) {
+            if constexpr (std::is_integral<T>::value) {
+                const __m256i overflow = _mm256_cmpgt_epi32(
+                    x, _mm256_set1_epi32(min_plus_ops<T>::limit - 1));
+                return _mm256_blendv_epi8(x, _mm256_set1_epi32(INT_MAX),
+                                          overflow);
+            } else {
+                return x;
+            }
+        }
+
+        /**
+         * AVX2微内核：12个累加寄存器保存mr×nr的C块，每一步广播A的mr个元素，
+         * 与B的一行（两个寄存器）做乘加或min-plus。
+         */
+        template <typename S, typename T>
+        CYM_TARGET_AVX2_FMA void
+        micro_kernel_avx2(const size_t k, const T* a, const T* b, T* c,
+                          const size_t ldc, const size_t m, const size_t n,
+                          const bool first) {
+            using V = simd_detail::avx2_vec<T>;
+            using reg = typename V::reg;
+            constexpr size_t w = V::width;
+            const S op;
+            reg acc[mr][2];
+#pragma GCC unroll 6
+            for (size_t r = 0; r < mr; ++r) {
+                acc[r][0] = V::set1(S::identity());
+                acc[r][1] = V::set1(S::identity());
+            }
+            for (size_t p = 0; p < k; ++p) {
+                const reg b0 = V::load(b);
+                const reg b1 = V::load(b + w);
+#pragma GCC unroll 6
+                for (size_t r = 0; r < mr; ++r) {
+                    const reg av = V::set1(a[r]);
+                    acc[r][0] = vupdate(op, acc[r][0], av, b0);
+                    acc[r][1] = vupdate(op, acc[r][1], av, b1);
+                }
+                a += mr;
+                b += 2 * w;
+            }
+            if (m == mr && n == 2 * w) {
+#pragma GCC unroll 6
+                for (size_t r = 0; r < mr; ++r) {
+                    T* row = c + r * ldc;
+                    if (first) {
+                        V::store(row, vfinish(op, acc[r][0]));
+                        V::store(row + w, vfinish(op, acc[r][1]));
+                    } else {
+                        V::store(row, vfinish(op, vcombine(op, V::load(row),
+                                                           acc[r][0])));
+                        V::store(row + w,
+                                 vfinish(op, vcombine(op, V::load(row + w),
+                                                      acc[r][1])));
+                    }
+                }
+                return;
+            }
+            T tile[mr][2 * w];
+            for (size_t r = 0; r < mr; ++r) {
+                V::store(tile[r], acc[r][0]);
+                V::store(tile[r] + w, acc[r][1]);
+            }
+            store_tile<S>(tile, c, ldc, m, n, first);
+        }
+#endif
+
+        template <typename T>
+        using kernel_t = void (*)(size_t, const T*, const T*, T*, size_t,
+                                  size_t, size_t, bool);
+
+        template <typename S, typename T>
+        kernel_t<T> select_kernel() {
+#if CYM_SIMD_X86
+            const bool vectorized = std::is_integral<T>::value
+                                        ? simd_detail::has_avx2()
+                                        : simd_detail::has_fma();
+            if (vectorized) {
+                return micro_kernel_avx2<S, T>;
+            }
+#endif
+            return micro_kernel_scalar<S, T>;
+        }
+
+        /**
+         * C(m×n) = A(m×k) ⊗ B(k×n)，三个矩阵都按行存放，行距分别为lda、ldb、ldc。
+         *
+         * 按nc列、kc层、mc行三级分块：每个kc×nc的B块打包一次，由所有线程共享；
+         * 各线程分别处理不同的mc行块，各自打包A块后逐个调用微内核。
+         */
+        template <typename S, typename T>
+        void run(const T* a, const size_t lda, const T* b, const size_t ldb,
+                 T* c, const size_t ldc, const size_t m, const size_t n,
+                 const size_t k, const unsigned threads) {
+            if (m == 0 || n == 0) {
+                return;
+            }
+            if (k == 0) {
+                for (size_t i = 0; i < m; ++i) {
+                    for (size_t j = 0; j < n; ++j) {
+                        c[i * ldc + j] = S::finish(S::identity());
+                    }
+                }
+                return;
+            }
+            constexpr size_t w = nr<T>;
+            const kernel_t<T> kernel = select_kernel<S, T>();
+            const size_t b_cols = n < nc ? n : nc;
+            T* b_pack = new T[kc * ((b_cols + w - 1) / w * w)];
+            task_pool pool(threads);
+            const size_t m_blocks = (m + mc - 1) / mc;
+
+            for (size_t jc = 0; jc < n; jc += nc) {
+                const size_t nb = n - jc < nc ? n - jc : nc;
+                for (size_t pc = 0; pc < k; pc += kc) {
+                    const size_t kb = k - pc < kc ? k - pc : kc;
+                    pack_b<S>(b + pc * ldb + jc, ldb, kb, nb, b_pack);
+                    pool.parallel_for(0, m_blocks, 1, [&](size_t lo, size_t hi) {
+                        T* a_pack = new T[mc * kc];
+                        for (size_t block = lo; block < hi; ++block) {
+                            const size_t ic = block * mc;
+                            const size_t mb = m - ic < mc ? m - ic : mc;
+                            pack_a<S>(a + ic * lda + pc, lda, mb, kb, a_pack);
+                            for (size_t jr = 0; jr < nb; jr += w) {
+                                const size_t n_tile = nb - jr < w ? nb - jr : w;
+                                for (size_t ir = 0; ir < mb; ir += mr) {
+                                    const size_t m_tile =
+                                        mb - ir < mr ? mb - ir : mr;
+                                    kernel(kb, a_pack + ir * kb,
+                                           b_pack + jr * kb,
+                                           c + (ic + ir) * ldc + jc + jr, ldc,
+                                           m_tile, n_tile, pc == 0);
+                                }
+                            }
+                        }
+                        delete[] a_pack;
+                    });
+                }
+            }
+            delete[] b_pack;
+        }
+
+        /**
+         * int32的有限值是否都在(-limit, limit)内，超出范围的值在打包时会被截断。
+         */
+        template <typename T>
+        bool in_min_plus_range(const md_view<const T, 2>& m) {
+            using S = min_plus_ops<T>;
+            for (size_t i = 0; i < m.extent(0); ++i) {
+                for (size_t j = 0; j < m.extent(1); ++j) {
+                    const T x = m(i, j);
+                    if (x != S::infinity() &&
+                        (x >= S::limit || x <= -S::limit)) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        template <typename S, typename T>
+        bool run_views(const md_view<const T, 2>& a, const md_view<const T, 2>& b,
+                       const md_view<T, 2>& c, const unsigned threads) {
+            static_assert(std::is_same<T, int32_t>::value ||
+                              std::is_same<T, float>::value ||
+                              std::is_same<T, double>::value,
+                          "element type must be int32, float or double");
+            if (a.extent(1) != b.extent(0) || c.extent(0) != a.extent(0) ||
+                c.extent(1) != b.extent(1)) {
+                return false;
+            }
+            // 要求每一行连续存放
+            if ((a.extent(1) > 1 && a.stride(1) != 1) ||
+                (b.extent(1) > 1 && b.stride(1) != 1) ||
+                (c.extent(1) > 1 && c.stride(1) != 1)) {
+                return false;
+            }
+            run<S>(a.data(), a.stride(0), b.data(), b.stride(0), c.data(),
+                   c.stride(0), a.extent(0), b.extent(1), a.extent(1),
+                   threads);
+            return true;
+        }
+    } // namespace gemm_detail
+
+    /**
+     * 矩阵乘法 C = A·B，支持int32、float和double。
+     *
+     * 采用GotoBLAS/BLIS的结构：B按kc×nc、A按mc×kc分块并打包为连续的微面板，
+     * 6×16（double为6×8）的AVX2微内核把C块保存在寄存器中，float和double使用FMA。
+     * 多线程时各线程处理不同的行块。视图的每一行必须连续，可以是子块，
+     * 但C不能与A、B重叠。int32的乘加按补码回绕。
+     *
+     * @param threads 线程数，为0时使用硬件线程数
+     * @return 维度不匹配或行不连续时不做任何事并返回false
+     */
+    template <typename T>
+    bool gemm(const md_view<const T, 2>& a, const md_view<const T, 2>& b,
+              const md_view<T, 2>& c, const unsigned threads = 1) {
+        return gemm_detail::run_views<gemm_detail::plus_times<T>>(a, b, c,
+                                                                  threads);
+    }
+
+    template <typename T>
+    bool gemm(const static_multi_dimension_array<T, 2>& a,
+              const static_multi_dimension_array<T, 2>& b,
+              static_multi_dimension_array<T, 2>& c,
+              const unsigned threads = 1) {
+        return gemm(md_view<const T, 2>(a), md_view<const T, 2>(b),
+                    md_view<T, 2>(c), threads);
+    }
+
+    /**
+     * (min, +)矩阵乘法 C[i][j] = min_k(A[i][k] + B[k][j])，
+     * 与`gemm()`共用分块、打包和线程划分，只是把乘加换成加法和取最小值。
+     *
+     * 以A为邻接矩阵反复平方log2(V)次即得到所有点对之间的最短路径。
+     * 浮点数用无穷大表示不可达；int32用INT_MAX（即`graph::dist::infinity`）
+     * 表示不可达，A和B中有限值的绝对值必须小于2^29，结果不小于2^29时
+     * 视为不可达，写为INT_MAX。
+     *
+     * @return 维度不匹配、行不连续，或int32的输入中有不是INT_MAX且绝对值
+     *         不小于2^29的元素时不做任何事并返回false
+     */
+    template <typename T>
+    bool min_plus(const md_view<const T, 2>& a, const md_view<const T, 2>& b,
+                  const md_view<T, 2>& c, const unsigned threads = 1) {
+        if constexpr (std::is_integral<T>::value) {
+            if (!gemm_detail::in_min_plus_range(a) ||
+                !gemm_detail::in_min_plus_range(b)) {
+                return false;
+            }
+        }
+        return gemm_detail::run_views<gemm_detail::min_plus_ops<T>>(a, b, c,
+                                                                    threads);
+    }
+
+    template <typename T>
+    bool min_plus(const static_multi_dimension_array<T, 2>& a,
+                  const static_multi_dimension_array<T, 2>& b,
+                  static_multi_dimension_array<T, 2>& c,
+                  const unsigned threads = 1) {
+        return min_plus(md_view<const T, 2>(a), md_view<const T, 2>(b),
+                        md_view<T, 2>(c), threads);
+    }
+
+    namespace fw_detail {
+
+        /**
+         * 分块的边长。三个64×64的int32块共48KB，第三阶段的一个C块和
+         * 对应的A、B块可以同时留在L1/L2中。
+         */
+        constexpr size_t block = 64;
+
+        /**
+         * 计算过程中表示不可达的值。权值非负，两个不大于inf的数相加不会溢出，
+         * `min(c, a + b)`的结果也不会超过inf，相当于饱和加法。
+         */
+        constexpr int32_t inf = (1 << 30) - 1;
+
+        /**
+         * 对`rows`行中的每一行i和[0, depth)中的每个k，用a[i][k] + b[k][j]
+         * 更新c[i][j]，j取[0, cols)。`next_c`和`next_a`的行距分别与`c`和`a`相同，
+         * 更新c[i][j]时，如果给出了`next`，同时令next_c[i][j] = next_a[i][k]。
+         */
+        template <bool with_next>
+        void relax_scalar(int32_t* c, int32_t* next_c, const size_t ldc,
+                          const int32_t* a, const int32_t* next_a,
+                          const size_t lda, const int32_t* b, const size_t ldb,
+                          const size_t rows, const size_t depth,
+                          const size_t cols) {
+            for (size_t i = 0; i < rows; ++i) {
+                int32_t* c_row = c + i * ldc;
+                for (size_t k = 0; k < depth; ++k) {
+                    const int32_t aik = a[i * lda + k];
+                    if (aik >= inf) {
+                        continue;
+                    }
+                    const int32_t* b_row = b + k * ldb;
+                    for (size_t j = 0; j < cols; ++j) {
+                        const int32_t sum = aik + b_row[j];
+                        if (sum < c_row[j]) {
+                            c_row[j] = sum;
+                            if constexpr (with_next) {
+                                next_c[i * ldc + j] = next_a[i * lda + k];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+#if CYM_SIMD_X86
+        /**
+         * `relax_scalar`的AVX2版本，`cols`必须是64的倍数。
+         * 每次把c的一行中的64个元素（带next时为32个）保存在寄存器中，
+         * 对所有k累积更新后再写回；外层按列分条，同一条b在处理各行时留在L1中。
+         */
+        template <bool with_next>
+        CYM_TARGET_AVX2 void
+        relax_avx2(int32_t* c, int32_t* next_c, const size_t ldc,
+                   const int32_t* a, const int32_t* next_a, const size_t lda,
+                   const int32_t* b, const size_t ldb, const size_t rows,
+                   const size_t depth, const size_t cols) {
+            using V = simd_detail::avx2_vec<int32_t>;
+            constexpr size_t regs = with_next ? 4 : 8;
+            constexpr size_t chunk = regs * V::width;
+            for (size_t j0 = 0; j0 < cols; j0 += chunk) {
+                for (size_t i = 0; i < rows; ++i) {
+                    int32_t* c_row = c + i * ldc;
+                    __m256i acc[regs];
+                    __m256i nxt[regs];
+#pragma GCC unroll 8
+                    for (size_t r = 0; r < regs; ++r) {
+                        acc[r] = V::load(c_row + j0 + r * V::width);
+                        if constexpr (with_next) {
+                            nxt[r] = V::load(next_c + i * ldc + j0 +
+                                             r * V::width);
+                        }
+                    }
+                    for (size_t k = 0; k < depth; ++k) {
+                        const int32_t aik = a[i * lda + k];
+                        if (aik >= inf) {
+                            continue;
+                        }
+                        const __m256i av = V::set1(aik);
+                        const int32_t* b_row = b + k * ldb + j0;
+                        if constexpr (with_next) {
+                            const __m256i nv = V::set1(next_a[i * lda + k]);
+#pragma GCC unroll 8
+                            for (size_t r = 0; r < regs; ++r) {
+                                const __m256i sum =
+                                    V::add(av, V::load(b_row + r * V::width));
+                                const __m256i less =
+                                    _mm256_cmpgt_epi32(acc[r], sum);
+                                acc[r] = _mm256_blendv_epi8(acc[r], sum, less);
+                                nxt[r] = _mm256_blendv_epi8(nxt[r], nv, less);
+                            }
+                        } else {
+#pragma GCC unroll 8
+                            for (size_t r = 0; r < regs; ++r) {
+                                acc[r] = V::min(
+                                    acc[r],
+                                    V::add(av, V::load(b_row + r * V::width)));
+                            }
+                        }
+                    }
+#pragma GCC unroll 8
+                    for (size_t r = 0; r < regs; ++r) {
+                        V::store(c_row + j0 + r * V::width, acc[r]);
+                        if constexpr (with_next) {
+                            V::store(next_c + i * ldc + j0 + r * V::width,
+                                     nxt[r]);
+                        }
+                    }
+                }
+            }
+        }
+#endif
+
+        template <bool with_next>
+        using relax_t = void (*)(int32_t*, int32_t*, size_t, const int32_t*,
+                                 const int32_t*, size_t, const int32_t*,
+                                 size_t, size_t, size_t, size_t);
+
+        template <bool with_next>
+        relax_t<with_next> select_relax() {
+#if CYM_SIMD_X86
+            if (simd_detail::has_avx2()) {
+                return relax_avx2<with_next>;
+            }
+#endif
+            return relax_scalar<with_next>;
+        }
+
+        /**
+         * 把n×n矩阵中第`bi`行的各个块（`row`为true时）或第`bi`列的各个块
+         * 复制为连续存放的block×block块，`m`为空时不做任何事。
+         */
+        inline void pack_panel(const int32_t* m, const size_t n, const size_t bi,
+                               const bool row, int32_t* out) {
+            if (m == nullptr) {
+                return;
+            }
+            const size_t blocks = n / block;
+            for (size_t b = 0; b < blocks; ++b) {
+                const int32_t* src = row ? m + bi * block * n + b * block
+                                         : m + b * block * n + bi * block;
+                for (size_t r = 0; r < block; ++r) {
+                    memcpy(out + (b * block + r) * block, src + r * n,
+                           sizeof(int32_t) * block);
+                }
+            }
+        }
+
+        /**
+         * 三阶段分块Floyd–Warshall，`d`为n×n、行距为n的矩阵，n是`block`的倍数。
+         *
+         * 对第kb个对角块：
+         * 1. 在对角块内部做Floyd–Warshall，k在最外层；
+         * 2. 用对角块更新第kb行和第kb列的其他块，它们互不依赖；
+         * 3. 用第kb列和第kb行的块更新其余所有块，它们也互不依赖，
+         *    相当于min-plus矩阵乘法，由多个线程分别处理。
+         *
+         * 矩阵的行距较大时，同一块中的各行落在L1的同一组中，
+         * 因此第三阶段前先把第kb行和第kb列的块复制为连续存放的块。
+         */
+        template <bool with_next>
+        void run(int32_t* d, int32_t* next, const size_t n,
+                 task_pool& pool) {
+            const relax_t<with_next> relax = select_relax<with_next>();
+            const size_t blocks = n / block;
+            const size_t panel_size = block * n;
+            int32_t* row_panel = new int32_t[panel_size];
+            int32_t* col_panel = new int32_t[panel_size];
+            int32_t* next_panel = with_next ? new int32_t[panel_size] : nullptr;
+            auto at = [](int32_t* m, const size_t offset) {
+                return m == nullptr ? nullptr : m + offset;
+            };
+            auto tile = [&](int32_t* m, const size_t bi, const size_t bj) {
+                return at(m, bi * block * n + bj * block);
+            };
+            for (size_t kb = 0; kb < blocks; ++kb) {
+                int32_t* diag = tile(d, kb, kb);
+                int32_t* diag_next = tile(next, kb, kb);
+                for (size_t k = 0; k < block; ++k) {
+                    relax(diag, diag_next, n, diag + k, at(diag_next, k), n,
+                          diag + k * n, n, block, 1, block);
+                }
+                pool.parallel_for(0, 2 * blocks, 1, [&](size_t lo, size_t hi) {
+                    for (size_t t = lo; t < hi; ++t) {
+                        const size_t b = t / 2;
+                        if (b == kb) {
+                            continue;
+                        }
+                        if (t % 2 == 0) {
+                            // 第kb行的块：c[k][j] = min(d[k][m] + c[m][j])
+                            relax(tile(d, kb, b), tile(next, kb, b), n, diag,
+                                  diag_next, n, tile(d, kb, b), n, block, block,
+                                  block);
+                        } else {
+                            // 第kb列的块：c[i][k] = min(c[i][m] + d[m][k])
+                            relax(tile(d, b, kb), tile(next, b, kb), n,
+                                  tile(d, b, kb), tile(next, b, kb), n, diag, n,
+                                  block, block, block);
+                        }
+                    }
+                });
+                pack_panel(d, n, kb, true, row_panel);
+                pack_panel(d, n, kb, false, col_panel);
+                pack_panel(next, n, kb, false, next_panel);
+                pool.parallel_for(
+                    0, blocks * blocks, 1, [&](size_t lo, size_t hi) {
+                        for (size_t t = lo; t < hi; ++t) {
+                            const size_t bi = t / blocks;
+                            const size_t bj = t % blocks;
+                            if (bi == kb || bj == kb) {
+                                continue;
+                            }
+                            const size_t a_off = bi * block * block;
+                            relax(tile(d, bi, bj), tile(next, bi, bj), n,
+                                  col_panel + a_off, at(next_panel, a_off),
+                                  block, row_panel + bj * block * block, block,
+                                  block, block, block);
+                        }
+                    });
+            }
+            delete[] row_panel;
+            delete[] col_panel;
+            delete[] next_panel;
+        }
+
+        /**
+         * 最短路径长度可能达到inf时使用的标量版本，距离用int64计算，
+         * 长度不小于INT_MAX的路径与Dijkstra一样按不可达处理。
+         * 对每个k，各行的更新互不依赖，由多个线程处理。
+         */
+        inline void run_wide(const md_view<int32_t, 2>& dist,
+                             const md_view<int32_t, 2>& next,
+                             const bool with_next, task_pool& pool) {
+            const size_t n = dist.extent(0);
+            const int64_t unreachable = INT_MAX;
+            int64_t* d = new int64_t[n * n];
+            int32_t* nx = with_next ? new int32_t[n * n] : nullptr;
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t j = 0; j < n; ++j) {
+                    const int32_t w = dist(i, j);
+                    d[i * n + j] = i == j ? (w < 0 ? w : 0) : w;
+                    if (with_next) {
+                        nx[i * n + j] =
+                            d[i * n + j] < unreachable ? static_cast<int32_t>(j)
+                                                       : -1;
+                    }
+                }
+            }
+            for (size_t k = 0; k < n; ++k) {
+                const int64_t* d_k = d + k * n;
+                pool.parallel_for(0, n, 16, [&](size_t lo, size_t hi) {
+                    for (size_t i = lo; i < hi; ++i) {
+                        int64_t* d_i = d + i * n;
+                        const int64_t dik = d_i[k];
+                        if (dik >= unreachable) {
+                            continue;
+                        }
+                        for (size_t j = 0; j < n; ++j) {
+                            const int64_t sum = dik + d_k[j];
+                            if (sum < d_i[j]) {
+                                d_i[j] = sum;
+                                if (with_next) {
+                                    nx[i * n + j] = nx[i * n + k];
+                                }
+                            }
+                        }
+                    }
+                });
+            }
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t j = 0; j < n; ++j) {
+                    const int64_t v = d[i * n + j];
+                    if (with_next) {
+                        next(i, j) = v < unreachable ? nx[i * n + j] : -1;
+                    }
+                    dist(i, j) = v < unreachable ? static_cast<int32_t>(v)
+                                                 : INT_MAX;
+                }
+            }
+            delete[] d;
+            delete[] nx;
+        }
+    } // namespace fw_detail
+
+    /**
+     * 所有点对之间的最短路径（Floyd–Warshall），结果写回`dist`。
+     *
+     * 输入的`dist[i][j]`为边i→j的权值，INT_MAX（即`graph::dist::infinity`）表示没有边，
+     * 权值必须非负；对角线上的自环被忽略，按0处理。
+     * 输出中不可达的点对，以及最短路径长度不小于INT_MAX的点对为INT_MAX，
+     * 与`directed_graph::shortest_path(from)`相同。
+     *
+     * 采用B×B分块的三阶段算法（见`fw_detail::run`），块内用AVX2做min-plus更新，
+     * 第二、三阶段中互不依赖的块由`threads`个线程处理。
+     * 边长不是64的倍数时，矩阵先被复制到补齐后的缓冲区中，计算完再复制回来。
+     *
+     * 分块算法用int32计算，长度达到2^30 - 1的路径会被当作不可达。最大权值与
+     * n - 1之积小于该值时结果一定精确；否则在缓冲区中计算，若某个有限的结果
+     * 加上最大权值可能达到该值，就改用int64的标量版本`fw_detail::run_wide`。
+     *
+     * @param next 可选的路径矩阵，与`dist`同样大小。输出中`next[i][j]`为从i到j
+     *             的最短路径上i之后的顶点，i到自身为i，不可达时为-1。
+     *             依次沿`next[v][j]`前进即可还原路径。
+     * @param threads 线程数，为0时使用硬件线程数
+     * @return `dist`不是方阵、行不连续或者`next`的大小不同时返回false
+     */
+    inline bool floyd_warshall(const md_view<int32_t, 2>& dist,
+                               const md_view<int32_t, 2>& next,
+                               const unsigned threads = 1) {
+        const size_t n = dist.extent(0);
+        const bool with_next = next.data() != nullptr;
+        if (dist.extent(1) != n || (n > 1 && dist.stride(1) != 1)) {
+            return false;
+        }
+        if (with_next && (next.extent(0) != n || next.extent(1) != n ||
+                          (n > 1 && next.stride(1) != 1))) {
+            return false;
+        }
+        if (n == 0) {
+            return true;
+        }
+        using fw_detail::inf;
+        task_pool pool(threads);
+        // 一条最短路径至多有n - 1条边，长度不超过最大权值的n - 1倍
+        int64_t max_weight = 0;
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                const int32_t w = dist(i, j);
+                if (i != j && w != INT_MAX && w > max_weight) {
+                    max_weight = w;
+                }
+            }
+        }
+        const bool exact = max_weight * static_cast<int64_t>(n - 1) < inf;
+        const size_t padded = (n + fw_detail::block - 1) / fw_detail::block *
+                              fw_detail::block;
+        // 边长已是64的倍数且连续存放时直接在`dist`和`next`上计算，
+        // 结果可能不精确时保留输入，以便改用int64计算
+        const bool in_place = exact && padded == n && dist.is_contiguous() &&
+                              (!with_next || next.is_contiguous());
+        int32_t* d = in_place ? dist.data() : new int32_t[padded * padded];
+        int32_t* nx = !with_next ? nullptr
+                      : in_place ? next.data()
+                                 : new int32_t[padded * padded];
+        pool.parallel_for(0, padded, 16, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) {
+                int32_t* row = d + i * padded;
+                for (size_t j = 0; j < padded; ++j) {
+                    const int32_t w = i < n && j < n ? dist(i, j) : inf;
+                    // 自环不会缩短路径，对角线为min(w, 0)，与Dijkstra一致
+                    row[j] = i == j ? (w < 0 ? w : 0) : w < inf ? w : inf;
+                    if (with_next) {
+                        nx[i * padded + j] =
+                            row[j] < inf ? static_cast<int32_t>(j) : -1;
+                    }
+                }
+            }
+        });
+        if (with_next) {
+            fw_detail::run<true>(d, nx, padded, pool);
+        } else {
+            fw_detail::run<false>(d, nullptr, padded, pool);
+        }
+        if (!exact) {
+            // 真实长度不小于inf的最短路径上，第一个这样的顶点的前驱的距离是精确的，
+            // 且加上一条边后不小于inf。所有有限的结果加上最大权值都小于inf时，
+            // 这样的路径不存在
+            int64_t max_finite = 0;
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t j = 0; j < n; ++j) {
+                    const int32_t v = d[i * padded + j];
+                    if (v < inf && v > max_finite) {
+                        max_finite = v;
+                    }
+                }
+            }
+            if (max_finite + max_weight >= inf) {
+                delete[] d;
+                delete[] nx;
+                fw_detail::run_wide(dist, next, with_next, pool);
+                return true;
+            }
+        }
+        pool.parallel_for(0, n, 16, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) {
+                for (size_t j = 0; j < n; ++j) {
+                    const int32_t v = d[i * padded + j];
+                    if (with_next) {
+                        next(i, j) = v < inf ? nx[i * padded + j] : -1;
+                    }
+                    dist(i, j) = v < inf ? v : INT_MAX;
+                }
+            }
+        });
+        if (!in_place) {
+            delete[] d;
+            delete[] nx;
+        }
+        return true;
+    }
+
+    inline bool floyd_warshall(const md_view<int32_t, 2>& dist,
+                               const unsigned threads = 1) {
+        return floyd_warshall(dist, md_view<int32_t, 2>(), threads);
+    }
+} // namespace cym
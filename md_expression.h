@@ -0,0 +1,793 @@
+#pragma once
+
+#include "multi_dimension_array.h"
+#include "parallel.h"
+#include "simd.h"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace cym {
+
+    /**
+     * 多维数组逐元素运算的表达式模板。
+     *
+     * `A + alpha * B`之类的表达式只构造一棵轻量的表达式树，不计算也不分配内存；
+     * 赋值给数组（`C = expr`或`C.assign(expr, threads)`）时才在一次遍历中
+     * 计算每个元素，中间结果不会写回内存。支持AVX2的CPU上以8个int32/float或
+     * 4个double为一组计算。
+     *
+     * 运算在存储上逐元素进行，参与运算的数组必须各维长度相同、布局相同，
+     * 布局不同时编译报错；维数或某一维的长度不同时表达式的`size()`为
+     * `size_mismatch`，赋值返回false，归约视为空表达式，都不会读取任何元素。
+     * 分块、Z序等布局中补齐的元素不参与运算。
+     * 标量按元素类型参与运算，整数数组与浮点数标量运算时编译报错，
+     * 而不是把标量截断为整数。归约（`sum()`、`min_value()`、`argmin()`等）
+     * 只能用于没有补齐元素的布局，浮点数中不能含有NaN。
+     */
+    template <typename E>
+    class md_expr {
+      public:
+        const E& self() const { return static_cast<const E&>(*this); }
+    };
+
+    /**
+     * 操作数的形状不同的表达式的`size()`。
+     */
+    constexpr size_t size_mismatch = SIZE_MAX;
+
+    /**
+     * 表达式中数组的形状，`extent`指向数组布局中的各维长度。
+     * 标量的维数为0，可以与任何形状运算。
+     */
+    struct md_shape {
+        const size_t* extent;
+        size_t dimension;
+    };
+
+    template <size_t dimension>
+    md_shape shape_of(const size_t (&extents)[dimension]) {
+        return md_shape{extents, dimension};
+    }
+
+    inline bool same_shape(const md_shape& a, const md_shape& b) {
+        if (a.dimension != b.dimension) {
+            return false;
+        }
+        for (size_t i = 0; i < a.dimension; ++i) {
+            if (a.extent[i] != b.extent[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    namespace expr_detail {
+
+        /**
+         * 两个操作数的布局，标量的布局为void。
+         */
+        template <typename A, typename B>
+        struct common_layout {
+            static_assert(std::is_void<A>::value || std::is_void<B>::value ||
+                              std::is_same<A, B>::value,
+                          "operands must have the same layout");
+            using type = typename std::conditional<std::is_void<A>::value, B,
+                                                   A>::type;
+        };
+
+#if CYM_SIMD_X86
+#define CYM_EXPR_PACKET_OP(name, scalar_expr, packet_expr)                     \
+    struct name {                                                              \
+        template <typename T>                                                  \
+        static T apply(const T a, const T b) {                                 \
+            return scalar_expr;                                                \
+        }                                                                      \
+        template <typename V>                                                  \
+        static CYM_TARGET_AVX2 typename V::reg                                 \
+        apply_packet(typename V::reg a, typename V::reg b) {                   \
+            return packet_expr;                                                \
+        }                                                                      \
+    };
+#else
+#define CYM_EXPR_PACKET_OP(name, scalar_expr, packet_expr)                     \
+    struct name {                                                              \
+        template <typename T>                                                  \
+        static T apply(const T a, const T b) {                                 \
+            return scalar_expr;                                                \
+        }                                                                      \
+    };
+#endif
+
+        CYM_EXPR_PACKET_OP(op_add, a + b, V::add(a, b))
+        CYM_EXPR_PACKET_OP(op_sub, a - b, V::sub(a, b))
+        CYM_EXPR_PACKET_OP(op_mul, a * b, V::mul(a, b))
+        CYM_EXPR_PACKET_OP(op_div, a / b, V::div(a, b))
+        CYM_EXPR_PACKET_OP(op_min, b < a ? b : a, V::min(a, b))
+        CYM_EXPR_PACKET_OP(op_max, a < b ? b : a, V::max(a, b))
+
+#undef CYM_EXPR_PACKET_OP
+
+        struct op_neg {
+            template <typename T>
+            static T apply(const T a) {
+                return -a;
+            }
+#if CYM_SIMD_X86
+            template <typename V>
+            static CYM_TARGET_AVX2 typename V::reg
+            apply_packet(typename V::reg a) {
+                return V::sub(V::set1(0), a);
+            }
+#endif
+        };
+    } // namespace expr_detail
+
+    /**
+     * 表达式的叶子，引用数组的存储。
+     */
+    template <typename T, typename Layout>
+    class md_terminal : public md_expr<md_terminal<T, Layout>> {
+      private:
+        const T* _data;
+        size_t _size;
+        md_shape _shape;
+
+      public:
+        using value_type = T;
+        using layout_type = Layout;
+
+        /**
+         * @param size 存储大小
+         */
+        md_terminal(const T* data, const size_t size, const md_shape& shape)
+            : _data(data), _size(size), _shape(shape) {}
+
+        size_t size() const { return _size; }
+
+        md_shape shape() const { return _shape; }
+
+        T eval(const size_t i) const { return _data[i]; }
+
+#if CYM_SIMD_X86
+        template <typename V>
+        CYM_TARGET_AVX2 typename V::reg packet(const size_t i) const {
+            return V::load(_data + i);
+        }
+#endif
+    };
+
+    /**
+     * 标量，参与运算时广播到每个元素。
+     */
+    template <typename T>
+    class md_scalar : public md_expr<md_scalar<T>> {
+      private:
+        T _value;
+
+      public:
+        using value_type = T;
+        using layout_type = void;
+
+        explicit md_scalar(const T value) : _value(value) {}
+
+        size_t size() const { return 0; }
+
+        md_shape shape() const { return md_shape{nullptr, 0}; }
+
+        T eval(size_t) const { return _value; }
+
+#if CYM_SIMD_X86
+        template <typename V>
+        CYM_TARGET_AVX2 typename V::reg packet(size_t) const {
+            return V::set1(_value);
+        }
+#endif
+    };
+
+    template <typename Op, typename L, typename R>
+    class md_binary : public md_expr<md_binary<Op, L, R>> {
+        static_assert(std::is_same<typename L::value_type,
+                                   typename R::value_type>::value,
+                      "operands must have the same element type");
+
+      private:
+        L _lhs;
+        R _rhs;
+
+      public:
+        using value_type = typename L::value_type;
+        using layout_type =
+            typename expr_detail::common_layout<typename L::layout_type,
+                                                typename R::layout_type>::type;
+
+        md_binary(const L& lhs, const R& rhs) : _lhs(lhs), _rhs(rhs) {}
+
+        /**
+         * 标量的大小为0，可以与任何操作数运算；两侧都不是标量且形状不同时
+         * 为`size_mismatch`。
+         */
+        size_t size() const {
+            const size_t lhs = _lhs.size();
+            const size_t rhs = _rhs.size();
+            if (lhs == 0 || rhs == 0) {
+                return lhs == 0 ? rhs : lhs;
+            }
+            return lhs == rhs && same_shape(_lhs.shape(), _rhs.shape())
+                       ? lhs
+                       : size_mismatch;
+        }
+
+        md_shape shape() const {
+            const md_shape lhs = _lhs.shape();
+            return lhs.dimension == 0 ? _rhs.shape() : lhs;
+        }
+
+        value_type eval(const size_t i) const {
+            return Op::apply(_lhs.eval(i), _rhs.eval(i));
+        }
+
+#if CYM_SIMD_X86
+        template <typename V>
+        CYM_TARGET_AVX2 typename V::reg packet(const size_t i) const {
+            return Op::template apply_packet<V>(
+                _lhs.template packet<V>(i), _rhs.template packet<V>(i));
+        }
+#endif
+    };
+
+    template <typename Op, typename E>
+    class md_unary : public md_expr<md_unary<Op, E>> {
+      private:
+        E _operand;
+
+      public:
+        using value_type = typename E::value_type;
+        using layout_type = typename E::layout_type;
+
+        explicit md_unary(const E& operand) : _operand(operand) {}
+
+        size_t size() const { return _operand.size(); }
+
+        md_shape shape() const { return _operand.shape(); }
+
+        value_type eval(const size_t i) const {
+            return Op::apply(_operand.eval(i));
+        }
+
+#if CYM_SIMD_X86
+        template <typename V>
+        CYM_TARGET_AVX2 typename V::reg packet(const size_t i) const {
+            return Op::template apply_packet<V>(_operand.template packet<V>(i));
+        }
+#endif
+    };
+
+    namespace expr_detail {
+
+        /**
+         * 可以作为表达式操作数的类型：表达式和数组。
+         */
+        template <typename X, typename = void>
+        struct operand {
+            static constexpr bool value = false;
+        };
+
+        template <typename X>
+        struct operand<X, typename std::enable_if<std::is_base_of<
+                              md_expr<X>, X>::value>::type> {
+            static constexpr bool value = true;
+            using type = X;
+            static type make(const X& x) { return x; }
+        };
+
+        template <typename T, size_t dimension, typename Layout>
+        struct operand<static_multi_dimension_array<T, dimension, Layout>> {
+            static constexpr bool value = true;
+            using type = md_terminal<T, Layout>;
+            static type
+            make(const static_multi_dimension_array<T, dimension, Layout>& x) {
+                return type(x.data(), x.storage_size(),
+                            shape_of(x.mapping().extents()));
+            }
+        };
+
+        template <typename T, typename Layout, size_t... extents>
+        struct operand<basic_md_array<T, Layout, extents...>> {
+            static constexpr bool value = true;
+            using type = md_terminal<T, Layout>;
+            static type make(const basic_md_array<T, Layout, extents...>& x) {
+                return type(x.data(), x.storage_size(),
+                            shape_of(x.mapping().extents()));
+            }
+        };
+
+        /**
+         * 把操作数转换为表达式，算术类型的标量转换为元素类型`T`的`md_scalar`。
+         * 浮点数标量不能转换为整数，否则`A * 0.5`会变成`A * 0`。
+         */
+        template <typename T, typename X>
+        auto lift(const X& x) {
+            if constexpr (operand<X>::value) {
+                return operand<X>::make(x);
+            } else {
+                static_assert(!std::is_floating_point<X>::value ||
+                                  std::is_floating_point<T>::value,
+                              "floating-point scalar with an integer array");
+                return md_scalar<T>(static_cast<T>(x));
+            }
+        }
+
+        template <typename X>
+        struct value_of {
+            using type = typename operand<X>::type::value_type;
+        };
+
+        /**
+         * 至少一侧是数组或表达式，另一侧是数组、表达式或算术类型。
+         */
+        template <typename L, typename R>
+        struct binary_operands
+            : std::integral_constant<
+                  bool, (operand<L>::value &&
+                         (operand<R>::value || std::is_arithmetic<R>::value)) ||
+                            (operand<R>::value &&
+                             std::is_arithmetic<L>::value)> {};
+
+        template <typename L, typename R>
+        using element_t = typename std::conditional<operand<L>::value,
+                                                    value_of<L>,
+                                                    value_of<R>>::type::type;
+
+        template <typename Op, typename L, typename R>
+        auto make_binary(const L& lhs, const R& rhs) {
+            using T = element_t<L, R>;
+            auto l = lift<T>(lhs);
+            auto r = lift<T>(rhs);
+            return md_binary<Op, decltype(l), decltype(r)>(l, r);
+        }
+    } // namespace expr_detail
+
+#define CYM_EXPR_BINARY_FUNCTION(name, op)                                     \
+    template <typename L, typename R,                                          \
+              typename = typename std::enable_if<                              \
+                  expr_detail::binary_operands<L, R>::value>::type>            \
+    auto name(const L& lhs, const R& rhs) {                                    \
+        return expr_detail::make_binary<expr_detail::op>(lhs, rhs);            \
+    }
+
+    CYM_EXPR_BINARY_FUNCTION(operator+, op_add)
+    CYM_EXPR_BINARY_FUNCTION(operator-, op_sub)
+    CYM_EXPR_BINARY_FUNCTION(operator*, op_mul)
+    CYM_EXPR_BINARY_FUNCTION(operator/, op_div)
+
+    /**
+     * 逐元素取较小值。
+     */
+    CYM_EXPR_BINARY_FUNCTION(min, op_min)
+
+    /**
+     * 逐元素取较大值。
+     */
+    CYM_EXPR_BINARY_FUNCTION(max, op_max)
+
+#undef CYM_EXPR_BINARY_FUNCTION
+
+    template <typename X, typename = typename std::enable_if<
+                              expr_detail::operand<X>::value>::type>
+    auto operator-(const X& x) {
+        using E = typename expr_detail::operand<X>::type;
+        return md_unary<expr_detail::op_neg, E>(
+            expr_detail::operand<X>::make(x));
+    }
+
+    /**
+     * 把每个元素限制在[lo, hi]内。
+     */
+    template <typename X, typename = typename std::enable_if<
+                              expr_detail::operand<X>::value>::type>
+    auto clamp(const X& x, const typename expr_detail::value_of<X>::type lo,
+               const typename expr_detail::value_of<X>::type hi) {
+        return min(max(x, lo), hi);
+    }
+
+    namespace expr_detail {
+
+        /**
+         * 多线程时每个任务至少处理的元素个数，太小时线程调度的开销超过收益。
+         */
+        constexpr size_t parallel_grain = 1 << 16;
+
+        inline size_t grain_size(const size_t size, const unsigned threads) {
+            if (threads <= 1) {
+                return size;
+            }
+            const size_t grain = size / (threads * 4);
+            // 保持向量化的块边界对齐
+            return grain < parallel_grain ? parallel_grain : grain & ~size_t(63);
+        }
+
+#if CYM_SIMD_X86
+        template <typename T, typename E>
+        CYM_TARGET_AVX2 void eval_avx2(T* dst, const E& e, const size_t lo,
+                                       const size_t hi) {
+            using V = simd_detail::avx2_vec<T>;
+            size_t i = lo;
+            for (; i + V::width <= hi; i += V::width) {
+                V::store(dst + i, e.template packet<V>(i));
+            }
+            for (; i < hi; ++i) {
+                dst[i] = e.eval(i);
+            }
+        }
+#endif
+
+        template <typename T, typename E>
+        void eval_range(T* dst, const E& e, const size_t lo, const size_t hi) {
+#if CYM_SIMD_X86
+            if constexpr (simd_detail::avx2_vec<T>::supported) {
+                if (simd_detail::has_avx2()) {
+                    eval_avx2(dst, e, lo, hi);
+                    return;
+                }
+            }
+#endif
+            for (size_t i = lo; i < hi; ++i) {
+                dst[i] = e.eval(i);
+            }
+        }
+
+        /**
+         * 只计算布局中真实的元素：按存储顺序枚举元素，相邻的偏移量合并为
+         * 连续的区间再交给`eval_range()`，分块布局中完整的块仍然向量化计算。
+         */
+        template <typename T, typename Mapping, typename E>
+        void eval_mapping(T* dst, const Mapping& mapping, const E& e) {
+            size_t lo = 0;
+            size_t hi = 0;
+            mapping.for_each([&](const size_t offset, const auto&) {
+                if (offset != hi) {
+                    eval_range(dst, e, lo, hi);
+                    lo = offset;
+                }
+                hi = offset + 1;
+            });
+            eval_range(dst, e, lo, hi);
+        }
+
+        template <typename T>
+        using sum_t = typename std::conditional<std::is_integral<T>::value,
+                                                int64_t, T>::type;
+
+        template <typename E>
+        sum_t<typename E::value_type> sum_range(const E& e, const size_t lo,
+                                                const size_t hi) {
+            sum_t<typename E::value_type> acc = 0;
+            for (size_t i = lo; i < hi; ++i) {
+                acc += e.eval(i);
+            }
+            return acc;
+        }
+
+        template <bool is_max, typename E>
+        typename E::value_type extreme_range(const E& e, const size_t lo,
+                                             const size_t hi) {
+            typename E::value_type best = e.eval(lo);
+            for (size_t i = lo + 1; i < hi; ++i) {
+                const typename E::value_type val = e.eval(i);
+                if (is_max ? best < val : val < best) {
+                    best = val;
+                }
+            }
+            return best;
+        }
+
+#if CYM_SIMD_X86
+        /**
+         * int32求和时扩展为int64累加，不会溢出。
+         */
+        template <typename E>
+        CYM_TARGET_AVX2 int64_t sum_avx2(const E& e, const size_t lo,
+                                         const size_t hi, int32_t) {
+            using V = simd_detail::avx2_vec<int32_t>;
+            __m256i acc = _mm256_setzero_si256();
+            size_t i = lo;
+            for (; i + V::width <= hi; i += V::width) {
+                const __m256i v = e.template packet<V>(i);
+                acc = _mm256_add_epi64(
+                    acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+                acc = _mm256_add_epi64(
+                    acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+            }
+            alignas(32) int64_t lanes[4];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+            return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+                   sum_range(e, i, hi);
+        }
+
+        /**
+         * 浮点数求和使用两个累加器，隐藏加法的延迟。
+         */
+        template <typename E, typename T>
+        CYM_TARGET_AVX2 T sum_avx2(const E& e, const size_t lo,
+                                   const size_t hi, T) {
+            using V = simd_detail::avx2_vec<T>;
+            typename V::reg acc0 = V::set1(0);
+            typename V::reg acc1 = V::set1(0);
+            size_t i = lo;
+            for (; i + 2 * V::width <= hi; i += 2 * V::width) {
+                acc0 = V::add(acc0, e.template packet<V>(i));
+                acc1 = V::add(acc1, e.template packet<V>(i + V::width));
+            }
+            alignas(32) T lanes[V::width];
+            V::store(lanes, V::add(acc0, acc1));
+            T acc = 0;
+            for (size_t k = 0; k < V::width; ++k) {
+                acc += lanes[k];
+            }
+            return acc + sum_range(e, i, hi);
+        }
+
+        template <bool is_max, typename E>
+        CYM_TARGET_AVX2 typename E::value_type
+        extreme_avx2(const E& e, const size_t lo, const size_t hi) {
+            using T = typename E::value_type;
+            using V = simd_detail::avx2_vec<T>;
+            if (hi - lo < V::width) {
+                return extreme_range<is_max>(e, lo, hi);
+            }
+            typename V::reg best = e.template packet<V>(lo);
+            size_t i = lo + V::width;
+            for (; i + V::width <= hi; i += V::width) {
+                const typename V::reg v = e.template packet<V>(i);
+                best = is_max ? V::max(best, v) : V::min(best, v);
+            }
+            alignas(32) T lanes[V::width];
+            V::store(lanes, best);
+            T result = lanes[0];
+            for (size_t k = 1; k < V::width; ++k) {
+                if (is_max ? result < lanes[k] : lanes[k] < result) {
+                    result = lanes[k];
+                }
+            }
+            if (i < hi) {
+                const T tail = extreme_range<is_max>(e, i, hi);
+                if (is_max ? result < tail : tail < result) {
+                    result = tail;
+                }
+            }
+            return result;
+        }
+#endif
+
+        template <typename E>
+        sum_t<typename E::value_type> sum_dispatch(const E& e, const size_t lo,
+                                                   const size_t hi) {
+            using T = typename E::value_type;
+#if CYM_SIMD_X86
+            if constexpr (simd_detail::avx2_vec<T>::supported) {
+                if (simd_detail::has_avx2()) {
+                    return sum_avx2(e, lo, hi, T());
+                }
+            }
+#endif
+            return sum_range(e, lo, hi);
+        }
+
+        template <bool is_max, typename E>
+        typename E::value_type extreme_dispatch(const E& e, const size_t lo,
+                                                const size_t hi) {
+            using T = typename E::value_type;
+#if CYM_SIMD_X86
+            if constexpr (simd_detail::avx2_vec<T>::supported) {
+                if (simd_detail::has_avx2()) {
+                    return extreme_avx2<is_max>(e, lo, hi);
+                }
+            }
+#endif
+            return extreme_range<is_max>(e, lo, hi);
+        }
+
+        /**
+         * 对表达式的每个块求部分结果，再用`combine`合并。
+         * 单线程时只有一个块。表达式为空或操作数大小不同时返回`empty`。
+         */
+        template <typename R, typename E, typename Partial, typename Combine>
+        R reduce(const E& e, const unsigned threads, Partial partial,
+                 Combine combine, const R empty) {
+            static_assert(std::is_void<typename E::layout_type>::value ||
+                              !E::layout_type::padded,
+                          "reduction over a padded layout");
+            const size_t size = e.size();
+            if (size == 0 || size == size_mismatch) {
+                return empty;
+            }
+            const size_t grain = grain_size(size, threads);
+            const size_t chunks = (size + grain - 1) / grain;
+            if (chunks <= 1) {
+                return partial(size_t(0), size);
+            }
+            R* results = new R[chunks];
+            parallel_for(0, chunks, 1, threads, [&](size_t lo, size_t hi) {
+                for (size_t c = lo; c < hi; ++c) {
+                    const size_t end =
+                        size - c * grain < grain ? size : (c + 1) * grain;
+                    results[c] = partial(c * grain, end);
+                }
+            });
+            R result = results[0];
+            for (size_t c = 1; c < chunks; ++c) {
+                result = combine(result, results[c]);
+            }
+            delete[] results;
+            return result;
+        }
+
+        template <typename T>
+        struct indexed {
+            T value;
+            size_t index;
+        };
+
+        /**
+         * 按4096个元素分块，先用向量化的min/max求出每块的最值，只记录最值最优
+         * 的块，最后在该块中找到最值第一次出现的位置。表达式只多计算一个块。
+         */
+        template <bool is_max, typename E>
+        indexed<typename E::value_type> arg_extreme(const E& e, size_t lo,
+                                                    const size_t hi) {
+            using T = typename E::value_type;
+            constexpr size_t block = 4096;
+            indexed<T> best{extreme_dispatch<is_max>(
+                                e, lo, hi - lo < block ? hi : lo + block),
+                            lo};
+            for (lo += block; lo < hi; lo += block) {
+                const T val = extreme_dispatch<is_max>(
+                    e, lo, hi - lo < block ? hi : lo + block);
+                if (is_max ? best.value < val : val < best.value) {
+                    best.value = val;
+                    best.index = lo;
+                }
+            }
+            while (e.eval(best.index) != best.value) {
+                best.index++;
+            }
+            return best;
+        }
+    } // namespace expr_detail
+
+    /**
+     * 把表达式的结果写入布局映射为`mapping`的存储`dst`。
+     *
+     * 存储中没有补齐的元素时直接遍历整个存储，`threads`大于1时分块交给多个
+     * 线程计算；有补齐时只计算真实的元素，补齐的部分既不读取也不写入，
+     * 此时只用一个线程。
+     *
+     * @return 表达式中数组的形状与`mapping`不同时不做任何事并返回false
+     */
+    template <typename T, typename Mapping, typename E>
+    bool evaluate(T* dst, const Mapping& mapping, const md_expr<E>& expr,
+                  const unsigned threads = 1) {
+        static_assert(std::is_same<T, typename E::value_type>::value,
+                      "element type mismatch");
+        const E& e = expr.self();
+        const md_shape shape = shape_of(mapping.extents());
+        const size_t size = mapping.required_size();
+        if (e.size() != 0 &&
+            (e.size() != size || !same_shape(e.shape(), shape))) {
+            return false;
+        }
+        size_t total = 1;
+        for (size_t i = 0; i < shape.dimension; ++i) {
+            total *= shape.extent[i];
+        }
+        if (total != size) {
+            expr_detail::eval_mapping(dst, mapping, e);
+            return true;
+        }
+        parallel_for(0, size, expr_detail::grain_size(size, threads), threads,
+                     [&](size_t lo, size_t hi) {
+                         expr_detail::eval_range(dst, e, lo, hi);
+                     });
+        return true;
+    }
+
+    /**
+     * 元素之和，整数类型的结果为int64_t。表达式为空或操作数大小不同时为0。
+     */
+    template <typename X, typename = typename std::enable_if<
+                              expr_detail::operand<X>::value>::type>
+    auto sum(const X& x, const unsigned threads = 1) {
+        using E = typename expr_detail::operand<X>::type;
+        using R = expr_detail::sum_t<typename E::value_type>;
+        const E e = expr_detail::operand<X>::make(x);
+        return expr_detail::reduce<R>(
+            e, threads,
+            [&](size_t lo, size_t hi) {
+                return expr_detail::sum_dispatch(e, lo, hi);
+            },
+            [](const R a, const R b) { return a + b; }, R(0));
+    }
+
+    /**
+     * 最小的元素。表达式为空或操作数大小不同时为`numeric_limits<T>::max()`。
+     */
+    template <typename X, typename = typename std::enable_if<
+                              expr_detail::operand<X>::value>::type>
+    auto min_value(const X& x, const unsigned threads = 1) {
+        using E = typename expr_detail::operand<X>::type;
+        using T = typename E::value_type;
+        const E e = expr_detail::operand<X>::make(x);
+        return expr_detail::reduce<T>(
+            e, threads,
+            [&](size_t lo, size_t hi) {
+                return expr_detail::extreme_dispatch<false>(e, lo, hi);
+            },
+            [](const T a, const T b) { return b < a ? b : a; },
+            std::numeric_limits<T>::max());
+    }
+
+    /**
+     * 最大的元素。表达式为空或操作数大小不同时为`numeric_limits<T>::lowest()`。
+     */
+    template <typename X, typename = typename std::enable_if<
+                              expr_detail::operand<X>::value>::type>
+    auto max_value(const X& x, const unsigned threads = 1) {
+        using E = typename expr_detail::operand<X>::type;
+        using T = typename E::value_type;
+        const E e = expr_detail::operand<X>::make(x);
+        return expr_detail::reduce<T>(
+            e, threads,
+            [&](size_t lo, size_t hi) {
+                return expr_detail::extreme_dispatch<true>(e, lo, hi);
+            },
+            [](const T a, const T b) { return a < b ? b : a; },
+            std::numeric_limits<T>::lowest());
+    }
+
+    /**
+     * 最小元素在存储中的位置，有多个最小元素时返回第一个。
+     * 对于行优先的数组即为按行展开后的下标。表达式为空或操作数大小不同时
+     * 为`size_mismatch`。
+     */
+    template <typename X, typename = typename std::enable_if<
+                              expr_detail::operand<X>::value>::type>
+    size_t argmin(const X& x, const unsigned threads = 1) {
+        using E = typename expr_detail::operand<X>::type;
+        using R = expr_detail::indexed<typename E::value_type>;
+        const E e = expr_detail::operand<X>::make(x);
+        return expr_detail::reduce<R>(
+                   e, threads,
+                   [&](size_t lo, size_t hi) {
+                       return expr_detail::arg_extreme<false>(e, lo, hi);
+                   },
+                   [](const R& a, const R& b) {
+                       return b.value < a.value ? b : a;
+                   },
+                   R{typename E::value_type(), size_mismatch})
+            .index;
+    }
+
+    /**
+     * 最大元素在存储中的位置，有多个最大元素时返回第一个。
+     * 表达式为空或操作数大小不同时为`size_mismatch`。
+     */
+    template <typename X, typename = typename std::enable_if<
+                              expr_detail::operand<X>::value>::type>
+    size_t argmax(const X& x, const unsigned threads = 1) {
+        using E = typename expr_detail::operand<X>::type;
+        using R = expr_detail::indexed<typename E::value_type>;
+        const E e = expr_detail::operand<X>::make(x);
+        return expr_detail::reduce<R>(
+                   e, threads,
+                   [&](size_t lo, size_t hi) {
+                       return expr_detail::arg_extreme<true>(e, lo, hi);
+                   },
+                   [](const R& a, const R& b) {
+                       return a.value < b.value ? b : a;
+                   },
+                   R{typename E::value_type(), size_mismatch})
+            .index;
+    }
+} // namespace cym
@@ -0,0 +1,361 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cym {
+
+    /**
+     * 多维数组的布局策略。
+     *
+     * 每个布局提供`mapping<dimension>`，把下标映射为存储中的偏移量：
+     * - `required_size()` 需要分配的元素个数，可能因为补齐而大于元素总数；
+     * - `extents()` 各维长度组成的数组；
+     * - `operator()(loc)` 下标`loc`对应的偏移量；
+     * - `for_each(fn)` 按存储顺序枚举每个元素，调用`fn(offset, loc)`，
+     *   顺序访问内存，适合遍历整个数组。
+     *
+     * `padded`表示存储中是否可能有补齐的元素。补齐的元素没有初始化，
+     * 逐元素运算跳过它们，归约只能用于不补齐的布局。
+     *
+     * 长度为0的维度按1处理。mapping的成员函数都是constexpr的，
+     * 各维长度在编译期确定时偏移量的计算可以完全展开。
+     */
+
+    /**
+     * 行优先（C风格），最后一维连续。
+     */
+    struct row_major {
+        static constexpr bool padded = false;
+
+        template <size_t dimension>
+        class mapping {
+          private:
+            size_t _extent[dimension];
+            size_t _stride[dimension];
+
+          public:
+            using extents_type = size_t[dimension];
+
+            constexpr mapping() : _extent(), _stride() {}
+
+            constexpr explicit mapping(const size_t (&extents)[dimension])
+                : _extent(), _stride() {
+                size_t stride = 1;
+                for (size_t i = dimension; i > 0; --i) {
+                    _extent[i - 1] = extents[i - 1] > 0 ? extents[i - 1] : 1;
+                    _stride[i - 1] = stride;
+                    stride *= _extent[i - 1];
+                }
+            }
+
+            constexpr size_t extent(const size_t i) const { return _extent[i]; }
+
+            constexpr const extents_type& extents() const { return _extent; }
+
+            constexpr size_t stride(const size_t i) const { return _stride[i]; }
+
+            constexpr size_t required_size() const {
+                return _stride[0] * _extent[0];
+            }
+
+            constexpr size_t operator()(const size_t (&loc)[dimension]) const {
+                size_t ind = loc[dimension - 1];
+                for (size_t i = 0; i + 1 < dimension; ++i) {
+                    ind += loc[i] * _stride[i];
+                }
+                return ind;
+            }
+
+            template <typename F>
+            void for_each(F fn) const {
+                size_t loc[dimension] = {0};
+                const size_t total = required_size();
+                for (size_t offset = 0; offset < total; ++offset) {
+                    fn(offset, loc);
+                    for (size_t i = dimension; i > 0; --i) {
+                        if (++loc[i - 1] < _extent[i - 1]) {
+                            break;
+                        }
+                        loc[i - 1] = 0;
+                    }
+                }
+            }
+        };
+    };
+
+    /**
+     * 列优先（Fortran风格），第一维连续。
+     */
+    struct column_major {
+        static constexpr bool padded = false;
+
+        template <size_t dimension>
+        class mapping {
+          private:
+            size_t _extent[dimension];
+            size_t _stride[dimension];
+
+          public:
+            using extents_type = size_t[dimension];
+
+            constexpr mapping() : _extent(), _stride() {}
+
+            constexpr explicit mapping(const size_t (&extents)[dimension])
+                : _extent(), _stride() {
+                size_t stride = 1;
+                for (size_t i = 0; i < dimension; ++i) {
+                    _extent[i] = extents[i] > 0 ? extents[i] : 1;
+                    _stride[i] = stride;
+                    stride *= _extent[i];
+                }
+            }
+
+            constexpr size_t extent(const size_t i) const { return _extent[i]; }
+
+            constexpr const extents_type& extents() const { return _extent; }
+
+            constexpr size_t stride(const size_t i) const { return _stride[i]; }
+
+            constexpr size_t required_size() const {
+                return _stride[dimension - 1] * _extent[dimension - 1];
+            }
+
+            constexpr size_t operator()(const size_t (&loc)[dimension]) const {
+                size_t ind = loc[0];
+                for (size_t i = 1; i < dimension; ++i) {
+                    ind += loc[i] * _stride[i];
+                }
+                return ind;
+            }
+
+            template <typename F>
+            void for_each(F fn) const {
+                size_t loc[dimension] = {0};
+                const size_t total = required_size();
+                for (size_t offset = 0; offset < total; ++offset) {
+                    fn(offset, loc);
+                    for (size_t i = 0; i < dimension; ++i) {
+                        if (++loc[i] < _extent[i]) {
+                            break;
+                        }
+                        loc[i] = 0;
+                    }
+                }
+            }
+        };
+    };
+
+    /**
+     * 分块布局：数组被划分为边长为`B`的块，块之间按行优先排列，
+     * 每个块内部也按行优先连续存放。任意一维的相邻元素大多位于同一个块中，
+     * 按行和按列访问的局部性相同。各维长度向上补齐到`B`的倍数。
+     *
+     * @tparam B 块的边长，必须是2的幂
+     */
+    template <size_t B>
+    struct tiled {
+        static_assert(B > 0 && (B & (B - 1)) == 0, "B must be a power of 2");
+
+        static constexpr bool padded = true;
+
+        template <size_t dimension>
+        class mapping {
+          private:
+            size_t _extent[dimension];
+            // 块网格按行优先排列时每一维的步长，已乘上块的大小
+            size_t _tile_stride[dimension];
+            // 块内每一维的步长
+            size_t _inner_stride[dimension];
+            size_t _total;
+
+          public:
+            using extents_type = size_t[dimension];
+
+            constexpr mapping()
+                : _extent(), _tile_stride(), _inner_stride(), _total(0) {}
+
+            constexpr explicit mapping(const size_t (&extents)[dimension])
+                : _extent(), _tile_stride(), _inner_stride(), _total(0) {
+                size_t tile_size = 1;
+                for (size_t i = dimension; i > 0; --i) {
+                    _inner_stride[i - 1] = tile_size;
+                    tile_size *= B;
+                }
+                size_t stride = tile_size;
+                for (size_t i = dimension; i > 0; --i) {
+                    _extent[i - 1] = extents[i - 1] > 0 ? extents[i - 1] : 1;
+                    _tile_stride[i - 1] = stride;
+                    stride *= (_extent[i - 1] + B - 1) / B;
+                }
+                _total = stride;
+            }
+
+            constexpr size_t extent(const size_t i) const { return _extent[i]; }
+
+            constexpr const extents_type& extents() const { return _extent; }
+
+            constexpr size_t required_size() const { return _total; }
+
+            constexpr size_t operator()(const size_t (&loc)[dimension]) const {
+                size_t ind = 0;
+                for (size_t i = 0; i < dimension; ++i) {
+                    ind += loc[i] / B * _tile_stride[i] +
+                           loc[i] % B * _inner_stride[i];
+                }
+                return ind;
+            }
+
+            /**
+             * 逐块遍历，块内按行优先遍历，跳过补齐的部分。
+             */
+            template <typename F>
+            void for_each(F fn) const {
+                size_t tile[dimension] = {0};
+                size_t loc[dimension];
+                for (;;) {
+                    size_t inner[dimension] = {0};
+                    for (;;) {
+                        bool inside = true;
+                        for (size_t i = 0; i < dimension; ++i) {
+                            loc[i] = tile[i] * B + inner[i];
+                            inside = inside && loc[i] < _extent[i];
+                        }
+                        if (inside) {
+                            fn((*this)(loc), loc);
+                        }
+                        size_t i = dimension;
+                        for (; i > 0; --i) {
+                            if (++inner[i - 1] < B) {
+                                break;
+                            }
+                            inner[i - 1] = 0;
+                        }
+                        if (i == 0) {
+                            break;
+                        }
+                    }
+                    size_t i = dimension;
+                    for (; i > 0; --i) {
+                        if (++tile[i - 1] * B < _extent[i - 1]) {
+                            break;
+                        }
+                        tile[i - 1] = 0;
+                    }
+                    if (i == 0) {
+                        break;
+                    }
+                }
+            }
+        };
+    };
+
+    /**
+     * Z序（Morton序）布局，只用于二维数组：把行号和列号的二进制位交错得到偏移量，
+     * 任意大小为2的幂的对齐方块在内存中都是连续的，对行、列以及分块访问都有较好的
+     * 局部性。
+     *
+     * 两维长度各自补齐到2的幂。较短一维的位数为b时，低2b位交错存放两维的低b位，
+     * 较长一维多出的高位放在更高的位置上，因此长方形数组不需要补齐成正方形。
+     */
+    struct morton {
+        static constexpr bool padded = true;
+
+        template <size_t dimension>
+        class mapping {
+            static_assert(dimension == 2, "morton layout is 2-dimensional");
+
+          private:
+            size_t _extent[2];
+            size_t _padded[2];
+            unsigned _bits;
+
+            static constexpr size_t ceil_pow2(const size_t n) {
+                size_t p = 1;
+                while (p < n) {
+                    p *= 2;
+                }
+                return p;
+            }
+
+            /**
+             * 把低32位分散到偶数位上。
+             */
+            static constexpr uint64_t spread(uint64_t x) {
+                x &= 0xffffffffull;
+                x = (x | x << 16) & 0x0000ffff0000ffffull;
+                x = (x | x << 8) & 0x00ff00ff00ff00ffull;
+                x = (x | x << 4) & 0x0f0f0f0f0f0f0f0full;
+                x = (x | x << 2) & 0x3333333333333333ull;
+                x = (x | x << 1) & 0x5555555555555555ull;
+                return x;
+            }
+
+            /**
+             * `spread()`的逆运算，取出偶数位。
+             */
+            static constexpr uint64_t compact(uint64_t x) {
+                x &= 0x5555555555555555ull;
+                x = (x | x >> 1) & 0x3333333333333333ull;
+                x = (x | x >> 2) & 0x0f0f0f0f0f0f0f0full;
+                x = (x | x >> 4) & 0x00ff00ff00ff00ffull;
+                x = (x | x >> 8) & 0x0000ffff0000ffffull;
+                x = (x | x >> 16) & 0x00000000ffffffffull;
+                return x;
+            }
+
+          public:
+            using extents_type = size_t[dimension];
+
+            constexpr mapping() : _extent(), _padded(), _bits(0) {}
+
+            constexpr explicit mapping(const size_t (&extents)[2])
+                : _extent(), _padded(), _bits(0) {
+                for (size_t i = 0; i < 2; ++i) {
+                    _extent[i] = extents[i] > 0 ? extents[i] : 1;
+                    _padded[i] = ceil_pow2(_extent[i]);
+                }
+                const size_t side =
+                    _padded[0] < _padded[1] ? _padded[0] : _padded[1];
+                while ((size_t(1) << _bits) < side) {
+                    _bits++;
+                }
+            }
+
+            constexpr size_t extent(const size_t i) const { return _extent[i]; }
+
+            constexpr const extents_type& extents() const { return _extent; }
+
+            constexpr size_t required_size() const {
+                return _padded[0] * _padded[1];
+            }
+
+            constexpr size_t operator()(const size_t (&loc)[2]) const {
+                const size_t mask = (size_t(1) << _bits) - 1;
+                const size_t high = ((loc[0] >> _bits) * (_padded[1] >> _bits) +
+                                     (loc[1] >> _bits))
+                                    << (2 * _bits);
+                return high | static_cast<size_t>(spread(loc[0] & mask) << 1 |
+                                                  spread(loc[1] & mask));
+            }
+
+            template <typename F>
+            void for_each(F fn) const {
+                const size_t total = required_size();
+                const size_t mask = (size_t(1) << 2 * _bits) - 1;
+                const size_t high_cols = _padded[1] >> _bits;
+                size_t loc[2];
+                for (size_t offset = 0; offset < total; ++offset) {
+                    const size_t high = offset >> 2 * _bits;
+                    loc[0] = (high / high_cols) << _bits |
+                             static_cast<size_t>(compact((offset & mask) >> 1));
+                    loc[1] = (high % high_cols) << _bits |
+                             static_cast<size_t>(compact(offset & mask));
+                    if (loc[0] < _extent[0] && loc[1] < _extent[1]) {
+                        fn(offset, loc);
+                    }
+                }
+            }
+        };
+    };
+} // namespace cym
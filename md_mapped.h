@@ -0,0 +1,422 @@
+#pragma once
+
+#include "mapped_file.h"
+#include "md_expression.h"
+#include "md_layout.h"
+#include "md_view.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <type_traits>
+
+namespace cym {
+
+    namespace mapped_detail {
+
+        constexpr char magic[8] = {'C', 'Y', 'M', 'M', 'D', 'A', 'R', 'R'};
+        constexpr uint32_t version = 1;
+
+        /**
+         * 元素数据在文件中的起始位置按4096字节对齐，映射后数据按页对齐。
+         */
+        constexpr size_t data_alignment = 4096;
+
+        /**
+         * 文件头，后面紧跟`dimension`个uint64_t表示各维长度。
+         * 所有字段按本机字节序存放。
+         */
+        struct file_header {
+            char magic[8];
+            uint32_t version;
+            uint32_t dtype;
+            uint32_t element_size;
+            uint32_t dimension;
+            uint32_t layout;
+            uint32_t reserved;
+            uint64_t data_offset;
+        };
+
+        /**
+         * 元素类型的编号，其他可平凡复制的类型记为0，只检查元素大小。
+         */
+        template <typename T>
+        constexpr uint32_t dtype_code() {
+            if constexpr (std::is_same<T, int8_t>::value) {
+                return 1;
+            } else if constexpr (std::is_same<T, uint8_t>::value) {
+                return 2;
+            } else if constexpr (std::is_same<T, int16_t>::value) {
+                return 3;
+            } else if constexpr (std::is_same<T, uint16_t>::value) {
+                return 4;
+            } else if constexpr (std::is_same<T, int32_t>::value) {
+                return 5;
+            } else if constexpr (std::is_same<T, uint32_t>::value) {
+                return 6;
+            } else if constexpr (std::is_same<T, int64_t>::value) {
+                return 7;
+            } else if constexpr (std::is_same<T, uint64_t>::value) {
+                return 8;
+            } else if constexpr (std::is_same<T, float>::value) {
+                return 9;
+            } else if constexpr (std::is_same<T, double>::value) {
+                return 10;
+            } else {
+                return 0;
+            }
+        }
+
+        template <typename Layout>
+        struct layout_code;
+
+        template <>
+        struct layout_code<row_major> {
+            static constexpr uint32_t value = 1;
+        };
+
+        template <>
+        struct layout_code<column_major> {
+            static constexpr uint32_t value = 2;
+        };
+
+        template <size_t B>
+        struct layout_code<tiled<B>> {
+            static constexpr uint32_t value = 3 | static_cast<uint32_t>(B << 8);
+        };
+
+        template <>
+        struct layout_code<morton> {
+            static constexpr uint32_t value = 4;
+        };
+
+        /**
+         * 各维长度之积，有长度为0或乘积溢出时返回false。
+         */
+        inline bool checked_product(const size_t* extents,
+                                    const size_t dimension, size_t& product) {
+            product = 1;
+            for (size_t i = 0; i < dimension; ++i) {
+                if (extents[i] == 0 ||
+                    __builtin_mul_overflow(product, extents[i], &product)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        constexpr size_t header_size(const size_t dimension) {
+            const size_t size = sizeof(file_header) + dimension * sizeof(uint64_t);
+            return (size + data_alignment - 1) / data_alignment * data_alignment;
+        }
+    } // namespace mapped_detail
+
+    /**
+     * 存放在文件中的多维数组，通过mmap访问，接口与`static_multi_dimension_array`
+     * 相同。
+     *
+     * 文件由一个记录各维长度、元素类型和布局的文件头和紧随其后的元素数据组成。
+     * `open()`只读取文件头并建立映射，元素所在的页在第一次访问时才读入，
+     * 重新打开任意大小的数组都是瞬间完成的；内存不足时内核把页换出到文件本身，
+     * 因此可以计算比内存大的数组。按访问方式调用`advise()`可以减少缺页：
+     * 逐行扫描用`sequential`，随机访问用`random`，即将访问的区域用`will_need`。
+     *
+     * 只读模式下通过`data()`或`operator()`写入元素会导致段错误。
+     */
+    template <typename T, size_t dimension, typename Layout = row_major>
+    class mapped_multi_dimension_array {
+        static_assert(dimension > 0, "dimension must be positive");
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "element type must be trivially copyable");
+
+      public:
+        using layout_type = Layout;
+        using mapping_type = typename Layout::template mapping<dimension>;
+
+      private:
+        mapped_file _file;
+        mapping_type _mapping;
+        size_t _total;
+        T* _val_arr;
+        using index_ty = const size_t (&)[dimension];
+
+        void init(index_ty sizes) {
+            _mapping = mapping_type(sizes);
+            _total = 1;
+            for (size_t i = 0; i < dimension; ++i) {
+                _total *= _mapping.extent(i);
+            }
+            _val_arr = reinterpret_cast<T*>(_file.data() +
+                                            mapped_detail::header_size(dimension));
+        }
+
+        template <typename... Index>
+        size_t offset(const Index... locations) const {
+            static_assert(sizeof...(Index) == dimension,
+                          "number of indices must equal dimension");
+            const size_t loc[] = {static_cast<size_t>(locations)...};
+            return _mapping(loc);
+        }
+
+      public:
+        mapped_multi_dimension_array()
+            : _mapping(), _total(0), _val_arr(nullptr) {}
+
+        mapped_multi_dimension_array(mapped_multi_dimension_array&& rhs) noexcept
+            : _file(std::move(rhs._file)), _mapping(rhs._mapping),
+              _total(rhs._total), _val_arr(rhs._val_arr) {
+            rhs._total = 0;
+            rhs._val_arr = nullptr;
+        }
+
+        mapped_multi_dimension_array&
+        operator=(mapped_multi_dimension_array&& rhs) noexcept {
+            std::swap(_file, rhs._file);
+            std::swap(_mapping, rhs._mapping);
+            std::swap(_total, rhs._total);
+            std::swap(_val_arr, rhs._val_arr);
+            return *this;
+        }
+
+        /**
+         * 创建（或覆盖）数组文件并以读写模式打开，元素全为0。
+         * 文件是稀疏的，只有写入过的页占用磁盘空间。
+         * @return 文件无法创建时返回false
+         */
+        bool create(const char* path, index_ty sizes) {
+            close();
+            const mapping_type mapping(sizes);
+            const size_t data_offset = mapped_detail::header_size(dimension);
+            if (!_file.create(path, data_offset +
+                                        sizeof(T) * mapping.required_size())) {
+                return false;
+            }
+            mapped_detail::file_header header;
+            memcpy(header.magic, mapped_detail::magic, sizeof(header.magic));
+            header.version = mapped_detail::version;
+            header.dtype = mapped_detail::dtype_code<T>();
+            header.element_size = sizeof(T);
+            header.dimension = dimension;
+            header.layout = mapped_detail::layout_code<Layout>::value;
+            header.reserved = 0;
+            header.data_offset = data_offset;
+            memcpy(_file.data(), &header, sizeof(header));
+            for (size_t i = 0; i < dimension; ++i) {
+                const uint64_t extent = mapping.extent(i);
+                memcpy(_file.data() + sizeof(header) + i * sizeof(uint64_t),
+                       &extent, sizeof(extent));
+            }
+            init(sizes);
+            return true;
+        }
+
+        bool create(const char* path, std::initializer_list<size_t>&& size_list) {
+            size_t sizes[dimension] = {0};
+            size_t index = 0;
+            for (const auto& s : size_list) {
+                if (index == dimension) {
+                    break;
+                }
+                sizes[index++] = s;
+            }
+            return create(path, sizes);
+        }
+
+        /**
+         * 打开`create()`创建的数组文件。
+         * @return 文件不存在，或者元素类型、维数、布局与本类型不符，
+         *         或者文件头中的长度为0、乘积溢出，或者文件长度不足时返回false
+         */
+        bool open(const char* path, const map_mode mode = map_mode::read_only) {
+            close();
+            if (!_file.open(path, mode)) {
+                return false;
+            }
+            mapped_detail::file_header header;
+            const size_t data_offset = mapped_detail::header_size(dimension);
+            bool ok = _file.size() >= data_offset;
+            if (ok) {
+                memcpy(&header, _file.data(), sizeof(header));
+                ok = memcmp(header.magic, mapped_detail::magic,
+                            sizeof(header.magic)) == 0 &&
+                     header.version == mapped_detail::version &&
+                     header.dtype == mapped_detail::dtype_code<T>() &&
+                     header.element_size == sizeof(T) &&
+                     header.dimension == dimension &&
+                     header.layout == mapped_detail::layout_code<Layout>::value &&
+                     header.data_offset == data_offset;
+            }
+            size_t sizes[dimension];
+            for (size_t i = 0; ok && i < dimension; ++i) {
+                uint64_t extent;
+                memcpy(&extent,
+                       _file.data() + sizeof(header) + i * sizeof(uint64_t),
+                       sizeof(extent));
+                sizes[i] = static_cast<size_t>(extent);
+            }
+            size_t total = 0;
+            ok = ok && mapped_detail::checked_product(sizes, dimension, total);
+            if (ok) {
+                // 先确认元素总数不超过文件的长度，补齐后的大小才不会溢出
+                const size_t available =
+                    (_file.size() - data_offset) / sizeof(T);
+                const mapping_type mapping(sizes);
+                ok = total <= available && mapping.required_size() >= total &&
+                     mapping.required_size() <= available;
+            }
+            if (!ok) {
+                _file.unmap();
+                return false;
+            }
+            init(sizes);
+            return true;
+        }
+
+        /**
+         * 解除映射。读写模式下的修改由内核在之后写回文件，需要立即落盘时先调用`sync()`。
+         */
+        void close() {
+            _file.unmap();
+            _mapping = mapping_type();
+            _total = 0;
+            _val_arr = nullptr;
+        }
+
+        bool is_open() const { return _file.is_open(); }
+
+        map_mode mode() const { return _file.mode(); }
+
+        /**
+         * 对整个数组给出访问提示。
+         */
+        bool advise(const map_advice advice) const {
+            return advise(advice, 0, storage_size());
+        }
+
+        /**
+         * 对存储中从`first`开始的`count`个元素给出访问提示，
+         * 例如处理下一个行块之前对它调用`will_need`，在后台预读。
+         */
+        bool advise(const map_advice advice, const size_t first,
+                    const size_t count) const {
+            return _file.advise(advice,
+                                mapped_detail::header_size(dimension) +
+                                    first * sizeof(T),
+                                count * sizeof(T));
+        }
+
+        /**
+         * 把修改过的页写回文件，`wait`为false时只发起写回不等待完成。
+         */
+        bool sync(const bool wait = true) const { return _file.sync(wait); }
+
+        /**
+         * 把每个元素设为`value`，会访问并修改所有的页。
+         */
+        void fill(const T& value) {
+            const size_t storage = storage_size();
+            for (size_t i = 0; i < storage; ++i) {
+                _val_arr[i] = value;
+            }
+        }
+
+        /**
+         * 计算表达式并写入本数组，见md_expression.h。
+         * @return 未打开，或者表达式中数组的形状与本数组不同时返回false
+         */
+        template <typename E>
+        bool assign(const md_expr<E>& expr, const unsigned threads = 1) {
+            using layout = typename E::layout_type;
+            static_assert(std::is_void<layout>::value ||
+                              std::is_same<layout, Layout>::value,
+                          "operands must have the same layout");
+            return is_open() && evaluate(_val_arr, _mapping, expr, threads);
+        }
+
+        size_t extent(const size_t i) const { return _mapping.extent(i); }
+
+        size_t stride(const size_t i) const { return _mapping.stride(i); }
+
+        size_t size() const { return _total; }
+
+        size_t storage_size() const {
+            return is_open() ? _mapping.required_size() : 0;
+        }
+
+        const mapping_type& mapping() const { return _mapping; }
+
+        T* data() { return _val_arr; }
+
+        const T* data() const { return _val_arr; }
+
+        /**
+         * 整个数组的视图，只有行优先和列优先布局提供，可以传给`gemm()`等函数。
+         */
+        md_view<T, dimension> view() {
+            size_t extents[dimension];
+            size_t strides[dimension];
+            for (size_t i = 0; i < dimension; ++i) {
+                extents[i] = extent(i);
+                strides[i] = stride(i);
+            }
+            return md_view<T, dimension>(_val_arr, extents, strides);
+        }
+
+        md_view<const T, dimension> view() const {
+            size_t extents[dimension];
+            size_t strides[dimension];
+            for (size_t i = 0; i < dimension; ++i) {
+                extents[i] = extent(i);
+                strides[i] = stride(i);
+            }
+            return md_view<const T, dimension>(_val_arr, extents, strides);
+        }
+
+        template <typename... Index>
+        T& operator()(const Index... locations) {
+            return _val_arr[offset(locations...)];
+        }
+
+        template <typename... Index>
+        const T& operator()(const Index... locations) const {
+            return _val_arr[offset(locations...)];
+        }
+
+        T& visit(index_ty locations) { return _val_arr[_mapping(locations)]; }
+
+        const T& visit(index_ty locations) const {
+            return _val_arr[_mapping(locations)];
+        }
+
+        /**
+         * 按存储顺序遍历每个元素，调用`fn(element, loc)`，文件按顺序读入。
+         */
+        template <typename F>
+        void for_each(F fn) {
+            _mapping.for_each([&](const size_t offset, index_ty loc) {
+                fn(_val_arr[offset], loc);
+            });
+        }
+
+        template <typename F>
+        void for_each(F fn) const {
+            _mapping.for_each([&](const size_t offset, index_ty loc) {
+                fn(static_cast<const T&>(_val_arr[offset]), loc);
+            });
+        }
+    };
+
+    namespace expr_detail {
+
+        template <typename T, size_t dimension, typename Layout>
+        struct operand<mapped_multi_dimension_array<T, dimension, Layout>> {
+            static constexpr bool value = true;
+            using type = md_terminal<T, Layout>;
+            static type
+            make(const mapped_multi_dimension_array<T, dimension, Layout>& x) {
+                return type(x.data(), x.storage_size(),
+                            shape_of(x.mapping().extents()));
+            }
+        };
+    } // namespace expr_detail
+} // namespace cym
@@ -0,0 +1,326 @@
+#pragma once
+
+#include "multi_dimension_array.h"
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+namespace cym {
+
+    /**
+     * 多维数组的非拥有视图，由数据指针、各维长度和各维步长描述。
+     *
+     * 视图不分配也不释放内存，复制视图只复制描述信息。`row()`、`col()`、
+     * `slice()`、`subblock()`和`transpose()`都只修改指针、长度和步长，
+     * 得到的视图仍然指向原来的元素，可以把一个矩阵的不同子区域交给不同线程处理。
+     *
+     * 只能从行优先或列优先（即有步长的）布局的数组构造。
+     * 只读视图使用`md_view<const T, rank>`。
+     */
+    template <typename T, size_t rank>
+    class md_view {
+        static_assert(rank > 0, "rank must be positive");
+
+        template <typename, size_t>
+        friend class md_view;
+
+      private:
+        T* _data;
+        size_t _extent[rank];
+        size_t _stride[rank];
+
+        template <typename Array>
+        void init_from(Array& arr) {
+            _data = arr.data();
+            for (size_t i = 0; i < rank; ++i) {
+                _extent[i] = arr.extent(i);
+                _stride[i] = arr.stride(i);
+            }
+        }
+
+      public:
+        using value_type = typename std::remove_const<T>::type;
+
+        md_view() : _data(nullptr), _extent(), _stride() {}
+
+        md_view(T* data, const size_t (&extents)[rank],
+                const size_t (&strides)[rank])
+            : _data(data), _extent(), _stride() {
+            for (size_t i = 0; i < rank; ++i) {
+                _extent[i] = extents[i];
+                _stride[i] = strides[i];
+            }
+        }
+
+        /**
+         * 行优先的连续视图。
+         */
+        md_view(T* data, const size_t (&extents)[rank])
+            : _data(data), _extent(), _stride() {
+            size_t stride = 1;
+            for (size_t i = rank; i > 0; --i) {
+                _extent[i - 1] = extents[i - 1];
+                _stride[i - 1] = stride;
+                stride *= extents[i - 1];
+            }
+        }
+
+        template <typename Layout>
+        md_view(static_multi_dimension_array<value_type, rank, Layout>& arr) {
+            init_from(arr);
+        }
+
+        template <typename Layout, typename U = T,
+                  typename = typename std::enable_if<
+                      std::is_const<U>::value>::type>
+        md_view(const static_multi_dimension_array<value_type, rank, Layout>&
+                    arr) {
+            init_from(arr);
+        }
+
+        template <typename Layout, size_t... extents,
+                  typename = typename std::enable_if<sizeof...(extents) ==
+                                                     rank>::type>
+        md_view(basic_md_array<value_type, Layout, extents...>& arr) {
+            init_from(arr);
+        }
+
+        /**
+         * 可写视图可以隐式转换为只读视图。
+         */
+        template <typename U, typename = typename std::enable_if<
+                                  std::is_same<const U, T>::value>::type>
+        md_view(const md_view<U, rank>& rhs) : _data(rhs._data) {
+            for (size_t i = 0; i < rank; ++i) {
+                _extent[i] = rhs._extent[i];
+                _stride[i] = rhs._stride[i];
+            }
+        }
+
+        size_t extent(const size_t i) const { return _extent[i]; }
+
+        size_t stride(const size_t i) const { return _stride[i]; }
+
+        /**
+         * 元素总数。
+         */
+        size_t size() const {
+            size_t total = 1;
+            for (size_t i = 0; i < rank; ++i) {
+                total *= _extent[i];
+            }
+            return total;
+        }
+
+        bool empty() const { return size() == 0; }
+
+        T* data() const { return _data; }
+
+        /**
+         * 元素是否按行优先紧密排列，此时可以把`data()`当作一维数组使用。
+         */
+        bool is_contiguous() const {
+            size_t stride = 1;
+            for (size_t i = rank; i > 0; --i) {
+                if (_extent[i - 1] != 1 && _stride[i - 1] != stride) {
+                    return false;
+                }
+                stride *= _extent[i - 1];
+            }
+            return true;
+        }
+
+        template <typename... Index>
+        T& operator()(const Index... locations) const {
+            static_assert(sizeof...(Index) == rank,
+                          "number of indices must equal rank");
+            const size_t loc[] = {static_cast<size_t>(locations)...};
+            size_t ind = 0;
+            for (size_t i = 0; i < rank; ++i) {
+                ind += loc[i] * _stride[i];
+            }
+            return _data[ind];
+        }
+
+        T& visit(const size_t (&loc)[rank]) const {
+            size_t ind = 0;
+            for (size_t i = 0; i < rank; ++i) {
+                ind += loc[i] * _stride[i];
+            }
+            return _data[ind];
+        }
+
+        /**
+         * 固定第`dim`维的下标为`index`，得到低一维的视图。
+         */
+        md_view<T, rank - 1> slice(const size_t dim, const size_t index) const {
+            static_assert(rank > 1, "cannot slice a 1-dimensional view");
+            md_view<T, rank - 1> result;
+            result._data = _data + index * _stride[dim];
+            for (size_t i = 0, j = 0; i < rank; ++i) {
+                if (i == dim) {
+                    continue;
+                }
+                result._extent[j] = _extent[i];
+                result._stride[j] = _stride[i];
+                j++;
+            }
+            return result;
+        }
+
+        /**
+         * 第`i`行，即固定第一维。
+         */
+        md_view<T, rank - 1> row(const size_t i) const { return slice(0, i); }
+
+        /**
+         * 第`j`列，即固定最后一维。对于行优先的矩阵，列视图的步长为行长。
+         */
+        md_view<T, rank - 1> col(const size_t j) const {
+            return slice(rank - 1, j);
+        }
+
+        /**
+         * 以`first`为起点、各维长度为`extents`的子块。
+         */
+        md_view subblock(const size_t (&first)[rank],
+                         const size_t (&extents)[rank]) const {
+            md_view result(*this);
+            for (size_t i = 0; i < rank; ++i) {
+                result._data += first[i] * _stride[i];
+                result._extent[i] = extents[i];
+            }
+            return result;
+        }
+
+        /**
+         * 交换第`a`维和第`b`维。
+         */
+        md_view transpose(const size_t a, const size_t b) const {
+            md_view result(*this);
+            result._extent[a] = _extent[b];
+            result._extent[b] = _extent[a];
+            result._stride[a] = _stride[b];
+            result._stride[b] = _stride[a];
+            return result;
+        }
+
+        /**
+         * 反转各维的顺序，二维时即为矩阵转置。
+         */
+        md_view transpose() const {
+            md_view result(*this);
+            for (size_t i = 0; i < rank; ++i) {
+                result._extent[i] = _extent[rank - 1 - i];
+                result._stride[i] = _stride[rank - 1 - i];
+            }
+            return result;
+        }
+
+        /**
+         * 按下标的字典序遍历每个元素，调用`fn(element, loc)`。
+         * 最后一维在最内层循环中以指针步进，行优先视图的行是顺序访问的。
+         */
+        template <typename F>
+        void for_each(F fn) const {
+            if (empty()) {
+                return;
+            }
+            size_t loc[rank] = {0};
+            const size_t inner = _extent[rank - 1];
+            const size_t inner_stride = _stride[rank - 1];
+            for (;;) {
+                T* p = &visit(loc);
+                for (loc[rank - 1] = 0; loc[rank - 1] < inner;
+                     ++loc[rank - 1], p += inner_stride) {
+                    fn(*p, loc);
+                }
+                loc[rank - 1] = 0;
+                size_t i = rank - 1;
+                for (; i > 0; --i) {
+                    if (++loc[i - 1] < _extent[i - 1]) {
+                        break;
+                    }
+                    loc[i - 1] = 0;
+                }
+                if (i == 0) {
+                    return;
+                }
+            }
+        }
+
+        /**
+         * 按下标字典序访问元素的前向迭代器，可以用于范围for循环。
+         * 迭代器引用产生它的视图，视图必须比迭代器存活得更久。
+         */
+        class iterator {
+          private:
+            const md_view* _view;
+            T* _ptr;
+            size_t _loc[rank];
+
+          public:
+            using value_type = typename md_view::value_type;
+            using reference = T&;
+            using pointer = T*;
+            using difference_type = std::ptrdiff_t;
+            using iterator_category = std::forward_iterator_tag;
+
+            iterator() : _view(nullptr), _ptr(nullptr), _loc() {}
+
+            iterator(const md_view* view, const bool end)
+                : _view(view), _ptr(nullptr), _loc() {
+                if (!end && !view->empty()) {
+                    _ptr = view->_data;
+                }
+            }
+
+            T& operator*() const { return *_ptr; }
+
+            T* operator->() const { return _ptr; }
+
+            const size_t (&index() const)[rank] { return _loc; }
+
+            iterator& operator++() {
+                for (size_t i = rank; i > 0; --i) {
+                    _ptr += _view->_stride[i - 1];
+                    if (++_loc[i - 1] < _view->_extent[i - 1]) {
+                        return *this;
+                    }
+                    _ptr -= _loc[i - 1] * _view->_stride[i - 1];
+                    _loc[i - 1] = 0;
+                }
+                _ptr = nullptr;
+                return *this;
+            }
+
+            iterator operator++(int) {
+                iterator tmp(*this);
+                ++*this;
+                return tmp;
+            }
+
+            bool operator==(const iterator& rhs) const {
+                return _ptr == rhs._ptr;
+            }
+
+            bool operator!=(const iterator& rhs) const {
+                return _ptr != rhs._ptr;
+            }
+        };
+
+        iterator begin() const { return iterator(this, false); }
+
+        iterator end() const { return iterator(this, true); }
+
+        /**
+         * 把视图中的元素复制到`dst`，两者各维长度必须相同。
+         */
+        template <typename U>
+        void copy_to(const md_view<U, rank>& dst) const {
+            for_each([&](T& val, const size_t (&loc)[rank]) {
+                dst.visit(loc) = val;
+            });
+        }
+    };
+} // namespace cym
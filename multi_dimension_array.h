@@ -1,21 +1,45 @@
 #pragma once
 
+#include "md_layout.h"
+#include <cstddef>
 #include <cstring>
 #include <initializer_list>
+#include <type_traits>
+#include <utility>
 
 namespace cym {
 
-    template <typename T, size_t dimension>
+    template <typename E>
+    class md_expr;
+
+    /**
+     * 多维数组，各维的长度在构造时确定。
+     *
+     * 元素的排列方式由`Layout`决定（见md_layout.h），默认行优先。
+     * 构造时预先计算好布局的参数，`operator()(i, j, ...)`直接由下标计算偏移量，
+     * 不需要构造临时数组。
+     */
+    template <typename T, size_t dimension, typename Layout = row_major>
     class static_multi_dimension_array {
+        static_assert(dimension > 0, "dimension must be positive");
+
+        template <typename, size_t, typename>
+        friend class static_multi_dimension_array;
+
+      public:
+        using layout_type = Layout;
+        using mapping_type = typename Layout::template mapping<dimension>;
+
       private:
         size_t _total;
-        size_t* _size_arr;
+        mapping_type _mapping;
         T* _val_arr;
         using arr_ty = size_t (&)[dimension];
+        using index_ty = const size_t (&)[dimension];
 
         static void copy_to_array(std::initializer_list<size_t>& list,
                                   arr_ty container) {
-            int index = 0;
+            size_t index = 0;
             for (const auto& l : list) {
                 container[index++] = l;
                 if (index == dimension) {
@@ -27,38 +51,41 @@ namespace cym {
             }
         }
 
-        void delegate_init(arr_ty size_array) {
-            _size_arr = new size_t[dimension];
-            memcpy(_size_arr, size_array, sizeof(size_t) * dimension);
-            _total = _size_arr[0];
-            for (size_t i = 1; i < dimension; ++i) {
-                if (_size_arr[i] <= 0) {
-                    continue;
-                }
-                _total *= _size_arr[i];
+        /**
+         * 长度为0的维度（初始化列表中未给出的维度）按1计算。
+         */
+        void delegate_init(index_ty size_array) {
+            _mapping = mapping_type(size_array);
+            _total = 1;
+            for (size_t i = 0; i < dimension; ++i) {
+                _total *= _mapping.extent(i);
             }
-            _val_arr = new T[_total];
+            _val_arr = new T[_mapping.required_size()];
         }
 
-      public:
-        explicit static_multi_dimension_array(arr_ty sizes) {
-            _size_arr = new size_t[dimension];
-            memcpy(_size_arr, sizes, sizeof(size_t) * dimension);
-            _total = _size_arr[0];
-            for (size_t i = 1; i < dimension; ++i) {
-                if (_size_arr[i] <= 0) {
-                    continue;
-                }
-                _total *= _size_arr[i];
+        void fill(const T& value) {
+            const size_t storage = _mapping.required_size();
+            for (size_t i = 0; i < storage; ++i) {
+                _val_arr[i] = value;
             }
-            _val_arr = new T[_total];
         }
 
-        explicit static_multi_dimension_array(arr_ty sizes, T init_value)
+        template <typename... Index>
+        size_t offset(const Index... locations) const {
+            static_assert(sizeof...(Index) == dimension,
+                          "number of indices must equal dimension");
+            const size_t loc[] = {static_cast<size_t>(locations)...};
+            return _mapping(loc);
+        }
+
+      public:
+        explicit static_multi_dimension_array(index_ty sizes) {
+            delegate_init(sizes);
+        }
+
+        explicit static_multi_dimension_array(index_ty sizes, T init_value)
             : static_multi_dimension_array(sizes) {
-            for (int i = 0; i < _total; ++i) {
-                _val_arr[i] = init_value;
-            }
+            fill(init_value);
         }
 
         static_multi_dimension_array(
@@ -73,29 +100,147 @@ namespace cym {
             size_t arr[dimension];
             copy_to_array(size_list, arr);
             delegate_init(arr);
-            for (int i = 0; i < _total; ++i) {
-                _val_arr[i] = init_value;
-            }
+            fill(init_value);
         }
 
-        static_multi_dimension_array(
-            const static_multi_dimension_array&& rhs) noexcept {
-            _total = rhs._total;
-            _size_arr = new size_t[dimension];
-            memcpy(_size_arr, rhs._size_arr, sizeof(size_t) * dimension);
-            _val_arr = new T[_total];
-            memcpy(_val_arr, rhs._val_arr, sizeof(T) * _total);
+        static_multi_dimension_array(static_multi_dimension_array&& rhs) noexcept
+            : _total(rhs._total), _mapping(rhs._mapping),
+              _val_arr(rhs._val_arr) {
+            rhs._total = 0;
+            rhs._val_arr = nullptr;
         }
 
         static_multi_dimension_array(const static_multi_dimension_array& rhs)
-            : static_multi_dimension_array(std::move(rhs)) {}
+            : _total(rhs._total), _mapping(rhs._mapping) {
+            _val_arr = new T[_mapping.required_size()];
+            memcpy(_val_arr, rhs._val_arr,
+                   sizeof(T) * _mapping.required_size());
+        }
 
-        T& visit(arr_ty locations) {
-            size_t ind = locations[dimension - 1];
-            for (int i = 0; i < dimension - 1; ++i) {
-                ind += locations[i] * _size_arr[i + 1];
+        /**
+         * 从另一种布局的数组复制，各维长度与`rhs`相同。
+         */
+        template <typename OtherLayout>
+        explicit static_multi_dimension_array(
+            const static_multi_dimension_array<T, dimension, OtherLayout>& rhs)
+            : _total(rhs._total) {
+            size_t sizes[dimension];
+            for (size_t i = 0; i < dimension; ++i) {
+                sizes[i] = rhs.extent(i);
             }
-            return _val_arr[ind];
+            _mapping = mapping_type(sizes);
+            _val_arr = new T[_mapping.required_size()];
+            assign(rhs);
+        }
+
+        static_multi_dimension_array&
+        operator=(static_multi_dimension_array rhs) noexcept {
+            std::swap(_total, rhs._total);
+            std::swap(_mapping, rhs._mapping);
+            std::swap(_val_arr, rhs._val_arr);
+            return *this;
+        }
+
+        ~static_multi_dimension_array() { delete[] _val_arr; }
+
+        /**
+         * 计算表达式并写入本数组，见md_expression.h。
+         */
+        template <typename E>
+        static_multi_dimension_array& operator=(const md_expr<E>& expr) {
+            assign(expr);
+            return *this;
+        }
+
+        /**
+         * 计算表达式并写入本数组，`threads`大于1时多线程计算。
+         * 分块、Z序等布局中补齐的元素不会被计算。
+         * @return 表达式中数组的形状与本数组不同时不做任何事并返回false
+         */
+        template <typename E>
+        bool assign(const md_expr<E>& expr, const unsigned threads = 1) {
+            using layout = typename E::layout_type;
+            static_assert(std::is_void<layout>::value ||
+                              std::is_same<layout, Layout>::value,
+                          "operands must have the same layout");
+            return evaluate(_val_arr, _mapping, expr, threads);
+        }
+
+        /**
+         * 复制`rhs`中的元素，两个数组各维长度必须相同，布局可以不同。
+         *
+         * 布局相同时直接复制整块内存。二维数组按64×64的块复制，
+         * 例如行优先与列优先之间的转换，读写都只在两个小块内跳跃；
+         * 更高维的数组按本数组的存储顺序写入。
+         */
+        template <typename OtherLayout>
+        void assign(
+            const static_multi_dimension_array<T, dimension, OtherLayout>& rhs) {
+            if constexpr (std::is_same<Layout, OtherLayout>::value) {
+                memcpy(_val_arr, rhs._val_arr,
+                       sizeof(T) * _mapping.required_size());
+            } else if constexpr (dimension == 2) {
+                constexpr size_t block = 64;
+                const size_t rows = extent(0);
+                const size_t cols = extent(1);
+                for (size_t bi = 0; bi < rows; bi += block) {
+                    const size_t ei = rows - bi < block ? rows : bi + block;
+                    for (size_t bj = 0; bj < cols; bj += block) {
+                        const size_t ej = cols - bj < block ? cols : bj + block;
+                        for (size_t i = bi; i < ei; ++i) {
+                            for (size_t j = bj; j < ej; ++j) {
+                                (*this)(i, j) = rhs(i, j);
+                            }
+                        }
+                    }
+                }
+            } else {
+                _mapping.for_each([&](const size_t offset, index_ty loc) {
+                    _val_arr[offset] = rhs.visit(loc);
+                });
+            }
+        }
+
+        /**
+         * 第`i`维的长度。
+         */
+        size_t extent(const size_t i) const { return _mapping.extent(i); }
+
+        /**
+         * 第`i`维下标加1时偏移量的增量，只有行优先和列优先布局提供。
+         */
+        size_t stride(const size_t i) const { return _mapping.stride(i); }
+
+        /**
+         * 元素总数。
+         */
+        size_t size() const { return _total; }
+
+        /**
+         * 存储占用的元素个数，分块和Z序布局补齐后可能大于`size()`。
+         */
+        size_t storage_size() const { return _mapping.required_size(); }
+
+        const mapping_type& mapping() const { return _mapping; }
+
+        T* data() { return _val_arr; }
+
+        const T* data() const { return _val_arr; }
+
+        template <typename... Index>
+        T& operator()(const Index... locations) {
+            return _val_arr[offset(locations...)];
+        }
+
+        template <typename... Index>
+        const T& operator()(const Index... locations) const {
+            return _val_arr[offset(locations...)];
+        }
+
+        T& visit(index_ty locations) { return _val_arr[_mapping(locations)]; }
+
+        const T& visit(index_ty locations) const {
+            return _val_arr[_mapping(locations)];
         }
 
         T& visit(std::initializer_list<size_t>&& locations) {
@@ -103,5 +248,122 @@ namespace cym {
             copy_to_array(locations, arr);
             return visit(arr);
         }
+
+        /**
+         * 按存储顺序遍历每个元素，调用`fn(element, loc)`，`loc`为元素的下标数组。
+         * 无论采用哪种布局，内存都是顺序访问的。
+         */
+        template <typename F>
+        void for_each(F fn) {
+            _mapping.for_each([&](const size_t offset, index_ty loc) {
+                fn(_val_arr[offset], loc);
+            });
+        }
+
+        template <typename F>
+        void for_each(F fn) const {
+            _mapping.for_each([&](const size_t offset, index_ty loc) {
+                fn(static_cast<const T&>(_val_arr[offset]), loc);
+            });
+        }
+    };
+
+    /**
+     * 各维长度在编译期确定的多维数组，布局由`Layout`决定。
+     *
+     * 布局参数是编译期常量，行优先时`operator()(i, j)`编译后就是`i * 1024 + j`。
+     * 元素仍然分配在堆上，对象本身只有一个指针大小。
+     */
+    template <typename T, typename Layout, size_t... extents>
+    class basic_md_array {
+      public:
+        static constexpr size_t dimension = sizeof...(extents);
+        using layout_type = Layout;
+        using mapping_type = typename Layout::template mapping<dimension>;
+
+      private:
+        static_assert(dimension > 0, "dimension must be positive");
+
+        static constexpr size_t _extents[dimension] = {extents...};
+
+        static constexpr size_t _total = (extents * ...);
+
+        static constexpr mapping_type _mapping = mapping_type(_extents);
+
+        static constexpr size_t _storage = _mapping.required_size();
+
+        T* _val_arr;
+
+        template <typename... Index>
+        static constexpr size_t offset(const Index... locations) {
+            static_assert(sizeof...(Index) == dimension,
+                          "number of indices must equal dimension");
+            const size_t loc[] = {static_cast<size_t>(locations)...};
+            return _mapping(loc);
+        }
+
+      public:
+        basic_md_array() : _val_arr(new T[_storage]) {}
+
+        explicit basic_md_array(const T& init_value) : basic_md_array() {
+            for (size_t i = 0; i < _storage; ++i) {
+                _val_arr[i] = init_value;
+            }
+        }
+
+        basic_md_array(const basic_md_array& rhs) : basic_md_array() {
+            memcpy(_val_arr, rhs._val_arr, sizeof(T) * _storage);
+        }
+
+        basic_md_array(basic_md_array&& rhs) noexcept : _val_arr(rhs._val_arr) {
+            rhs._val_arr = nullptr;
+        }
+
+        basic_md_array& operator=(basic_md_array rhs) noexcept {
+            std::swap(_val_arr, rhs._val_arr);
+            return *this;
+        }
+
+        ~basic_md_array() { delete[] _val_arr; }
+
+        static constexpr size_t extent(const size_t i) { return _extents[i]; }
+
+        static constexpr size_t stride(const size_t i) {
+            return _mapping.stride(i);
+        }
+
+        static constexpr size_t size() { return _total; }
+
+        static constexpr size_t storage_size() { return _storage; }
+
+        static constexpr const mapping_type& mapping() { return _mapping; }
+
+        T* data() { return _val_arr; }
+
+        const T* data() const { return _val_arr; }
+
+        template <typename... Index>
+        T& operator()(const Index... locations) {
+            return _val_arr[offset(locations...)];
+        }
+
+        template <typename... Index>
+        const T& operator()(const Index... locations) const {
+            return _val_arr[offset(locations...)];
+        }
+
+        template <typename F>
+        void for_each(F fn) {
+            _mapping.for_each(
+                [&](const size_t offset, const size_t (&loc)[dimension]) {
+                    fn(_val_arr[offset], loc);
+                });
+        }
     };
-} // namespace cym
\ No newline at end of file
+
+    /**
+     * 行优先、各维长度在编译期确定的多维数组，例如`md_array<int, 1024, 1024>`。
+     */
+    template <typename T, size_t... extents>
+    using md_array = basic_md_array<T, row_major, extents...>;
+} // namespace cym
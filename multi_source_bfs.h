@@ -0,0 +1,328 @@
+#pragma once
+
+#include "csr_graph.h"
+#include "graph.h"
+#include "parallel.h"
+#include "simd.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace cym {
+
+    namespace ms_bfs_detail {
+        /**
+         * 扩展一层：本层每个顶点的位并入它所有邻居在下一层的位，并把本层清零，
+         * 使它可以作为再下一层的`next`。
+         *
+         * 位的宽度是编译期常量，内层循环会被展开，在带`CYM_TARGET_AVX2`的
+         * 包装中还会被向量化。
+         */
+        template <size_t Words>
+        __attribute__((always_inline)) inline void
+        expand(const size_t* offsets, const unsigned int* targets,
+               const size_t v_count, uint64_t* visit, uint64_t* next) {
+            for (size_t v = 0; v < v_count; ++v) {
+                uint64_t* bits = visit + v * Words;
+                uint64_t any = 0;
+                for (size_t w = 0; w < Words; ++w) {
+                    any |= bits[w];
+                }
+                if (any == 0) {
+                    continue;
+                }
+                for (size_t k = offsets[v]; k < offsets[v + 1]; ++k) {
+                    uint64_t* dst = next + size_t(targets[k]) * Words;
+                    for (size_t w = 0; w < Words; ++w) {
+                        dst[w] |= bits[w];
+                    }
+                }
+                for (size_t w = 0; w < Words; ++w) {
+                    bits[w] = 0;
+                }
+            }
+        }
+
+        template <size_t Words>
+        void expand_scalar(const size_t* offsets, const unsigned int* targets,
+                           const size_t v_count, uint64_t* visit,
+                           uint64_t* next) {
+            expand<Words>(offsets, targets, v_count, visit, next);
+        }
+
+#if CYM_SIMD_X86
+        template <size_t Words>
+        CYM_TARGET_AVX2 void expand_avx2(const size_t* offsets,
+                                         const unsigned int* targets,
+                                         const size_t v_count, uint64_t* visit,
+                                         uint64_t* next) {
+            expand<Words>(offsets, targets, v_count, visit, next);
+        }
+#endif
+
+        template <size_t Words>
+        using expand_t = void (*)(const size_t*, const unsigned int*, size_t,
+                                  uint64_t*, uint64_t*);
+
+        template <size_t Words>
+        expand_t<Words> select_expand() {
+#if CYM_SIMD_X86
+            if (simd_detail::has_avx2()) {
+                return expand_avx2<Words>;
+            }
+#endif
+            return expand_scalar<Words>;
+        }
+
+        /**
+         * 按位的计数器：第p个字的第b位是第b个计数的第p位。加上一个字相当于
+         * 把它的每一位分别加到对应的计数上，平摊只需处理两个字。
+         */
+        constexpr size_t planes = 40;
+
+        inline void add(uint64_t* counter, uint64_t carry) {
+            for (size_t p = 0; carry != 0 && p < planes; ++p) {
+                const uint64_t c = counter[p] & carry;
+                counter[p] ^= carry;
+                carry = c;
+            }
+        }
+    } // namespace ms_bfs_detail
+
+    /**
+     * 多源的位并行广度优先搜索（MS-BFS）：一次遍历同时完成至多`Width`个源点的
+     * 广度优先搜索，每个顶点用`Width`位记录哪些源点已经到达它。
+     *
+     * 一层的扩展对每条边只做一次`Width`位的或运算，因此各个源点共享对邻接表
+     * 的访问，源点在图中相距越近，共享越多。每层新到达的顶点数用按位的计数器
+     * 统计，不必逐位遍历，只在需要距离矩阵时才逐位写出距离。
+     *
+     * 边的方向为出边，权重被忽略，与`csr_graph::breadth_first_search()`相同。
+     * 同一个对象可以反复调用`run()`，缓冲区只分配一次；不同线程应使用不同的对象。
+     *
+     * @tparam Width 一次搜索的源点数，必须是64的倍数且不超过512
+     */
+    template <size_t Width = 256>
+    class multi_source_bfs {
+        static_assert(Width % 64 == 0 && Width >= 64 && Width <= 512,
+                      "Width must be a multiple of 64 in [64, 512]");
+
+      public:
+        static constexpr size_t words = Width / 64;
+
+      private:
+        const csr_graph& _graph;
+        size_t _v_count;
+        uint64_t* _seen;
+        uint64_t* _visit;
+        uint64_t* _next;
+        size_t _count;
+        unsigned int _levels;
+        size_t _reached[Width];
+        uint64_t _distance_sum[Width];
+
+      public:
+        explicit multi_source_bfs(const csr_graph& graph)
+            : _graph(graph), _v_count(graph.vertex_count()),
+              _seen(new uint64_t[_v_count * words]),
+              _visit(new uint64_t[_v_count * words]()),
+              _next(new uint64_t[_v_count * words]()), _count(0), _levels(0),
+              _reached(), _distance_sum() {}
+
+        multi_source_bfs(const multi_source_bfs&) = delete;
+        multi_source_bfs& operator=(const multi_source_bfs&) = delete;
+
+        ~multi_source_bfs() {
+            delete[] _seen;
+            delete[] _visit;
+            delete[] _next;
+        }
+
+        /**
+         * 从`sources`中的`count`个源点同时进行广度优先搜索，第i个源点的结果
+         * 由`reached(i)`等查询。源点可以重复。
+         *
+         * @param distances 不为空时被赋值为count×V的矩阵，第i行为第i个源点到
+         *                  各个顶点的跳数，不可达为`graph::dist::infinity`
+         * @return `count`超过`Width`或有源点不存在时返回false，不做任何事
+         */
+        bool run(const unsigned int* sources, const size_t count,
+                 matrix_t* distances = nullptr) {
+            if (count > Width) {
+                return false;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                if (sources[i] >= _v_count) {
+                    return false;
+                }
+            }
+            using namespace ms_bfs_detail;
+            _count = count;
+            _levels = 0;
+            memset(_seen, 0, sizeof(uint64_t) * _v_count * words);
+            for (size_t i = 0; i < Width; ++i) {
+                _reached[i] = i < count ? 1 : 0;
+                _distance_sum[i] = 0;
+            }
+            int* dist = nullptr;
+            if (distances != nullptr) {
+                *distances =
+                    matrix_t({count, _v_count}, graph::dist::infinity);
+                dist = distances->data();
+            }
+            for (size_t i = 0; i < count; ++i) {
+                const size_t s = sources[i];
+                const uint64_t bit = uint64_t(1) << (i % 64);
+                _seen[s * words + i / 64] |= bit;
+                _visit[s * words + i / 64] |= bit;
+                if (dist != nullptr) {
+                    dist[i * _v_count + s] = 0;
+                }
+            }
+
+            const expand_t<words> step = select_expand<words>();
+            uint64_t counter[words][planes];
+            unsigned int level = 0;
+            bool frontier = count > 0;
+            while (frontier) {
+                step(_graph.offsets(), _graph.targets(), _v_count, _visit,
+                     _next);
+                ++level;
+                memset(counter, 0, sizeof(counter));
+                frontier = false;
+                for (size_t v = 0; v < _v_count; ++v) {
+                    uint64_t* seen = _seen + v * words;
+                    uint64_t* next = _next + v * words;
+                    for (size_t w = 0; w < words; ++w) {
+                        const uint64_t fresh = next[w] & ~seen[w];
+                        next[w] = fresh;
+                        if (fresh == 0) {
+                            continue;
+                        }
+                        seen[w] |= fresh;
+                        frontier = true;
+                        add(counter[w], fresh);
+                        for (uint64_t b = fresh; dist != nullptr && b != 0;
+                             b &= b - 1) {
+                            const size_t i = w * 64 + __builtin_ctzll(b);
+                            dist[i * _v_count + v] = static_cast<int>(level);
+                        }
+                    }
+                }
+                for (size_t w = 0; w < words; ++w) {
+                    for (size_t p = 0; p < planes; ++p) {
+                        for (uint64_t b = counter[w][p]; b != 0; b &= b - 1) {
+                            const size_t i = w * 64 + __builtin_ctzll(b);
+                            _reached[i] += size_t(1) << p;
+                            _distance_sum[i] += uint64_t(level) << p;
+                        }
+                    }
+                }
+                if (frontier) {
+                    _levels = level;
+                }
+                uint64_t* t = _visit;
+                _visit = _next;
+                _next = t;
+            }
+            return true;
+        }
+
+        /**
+         * 上一次`run()`的源点数。
+         */
+        size_t source_count() const { return _count; }
+
+        /**
+         * 上一次`run()`中最远的源点的离心率，即最大的有限跳数。
+         */
+        unsigned int levels() const { return _levels; }
+
+        /**
+         * 第i个源点可达的顶点数，包括它自己。
+         */
+        size_t reached(const size_t i) const { return _reached[i]; }
+
+        /**
+         * 第i个源点到所有可达顶点的跳数之和。
+         */
+        uint64_t distance_sum(const size_t i) const { return _distance_sum[i]; }
+
+        /**
+         * 第i个源点的接近中心性，用Wasserman–Faust的形式处理不连通的图：
+         * 可达顶点数为r、跳数之和为s时为((r - 1) / (V - 1)) * ((r - 1) / s)，
+         * 不能到达任何其它顶点时为0。
+         */
+        double closeness(const size_t i) const {
+            const size_t r = _reached[i];
+            if (r <= 1 || _distance_sum[i] == 0) {
+                return 0.0;
+            }
+            const double others = static_cast<double>(r - 1);
+            return others / static_cast<double>(_v_count - 1) * others /
+                   static_cast<double>(_distance_sum[i]);
+        }
+    };
+
+    /**
+     * 求所有顶点的接近中心性（按出边的跳数），见`multi_source_bfs::closeness()`。
+     *
+     * 顶点按`Width`个一批交给`multi_source_bfs`，各批之间由多个线程并行，
+     * 每个线程有自己的搜索对象，额外内存为每线程3×V×Width位。
+     *
+     * @param threads 线程数，为0时使用`default_thread_count()`
+     * @param reached 不为空时被赋值为各个顶点可达的顶点数（包括自己）
+     */
+    template <size_t Width = 256>
+    static_multi_dimension_array<double, 1>
+    closeness_centrality(const csr_graph& graph, unsigned threads = 1,
+                         vector_t* reached = nullptr) {
+        const size_t v_count = graph.vertex_count();
+        static_multi_dimension_array<double, 1> result({v_count});
+        if (reached != nullptr) {
+            *reached = vector_t({v_count});
+        }
+        if (v_count == 0) {
+            return result;
+        }
+        threads = threads == 0 ? default_thread_count() : threads;
+        const size_t batches = (v_count + Width - 1) / Width;
+        if (threads > batches) {
+            threads = static_cast<unsigned>(batches);
+        }
+        task_pool pool(threads);
+        const unsigned workers = pool.size();
+        multi_source_bfs<Width>** engines =
+            new multi_source_bfs<Width>*[workers]();
+        double* closeness = result.data();
+        int* reach = reached == nullptr ? nullptr : reached->data();
+        pool.parallel_for(0, batches, 1, [&](size_t lo, size_t hi) {
+            const unsigned w = pool.current_index();
+            if (engines[w] == nullptr) {
+                engines[w] = new multi_source_bfs<Width>(graph);
+            }
+            unsigned int sources[Width];
+            for (size_t b = lo; b < hi; ++b) {
+                const size_t first = b * Width;
+                const size_t count =
+                    v_count - first < Width ? v_count - first : Width;
+                for (size_t i = 0; i < count; ++i) {
+                    sources[i] = static_cast<unsigned int>(first + i);
+                }
+                engines[w]->run(sources, count);
+                for (size_t i = 0; i < count; ++i) {
+                    closeness[first + i] = engines[w]->closeness(i);
+                    if (reach != nullptr) {
+                        reach[first + i] =
+                            static_cast<int>(engines[w]->reached(i));
+                    }
+                }
+            }
+        });
+        for (unsigned w = 0; w < workers; ++w) {
+            delete engines[w];
+        }
+        delete[] engines;
+        return result;
+    }
+} // namespace cym
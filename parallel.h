@@ -0,0 +1,277 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace cym {
+
+    /**
+     * 默认线程数，即硬件线程数，至少为1。
+     */
+    inline unsigned default_thread_count() {
+        const unsigned n = std::thread::hardware_concurrency();
+        return n == 0 ? 1 : n;
+    }
+
+    /**
+     * 工作窃取线程池。
+     *
+     * 每个工作线程有自己的任务队列，从队尾取出自己提交的任务（后进先出，局部性好），
+     * 自己的队列为空时从其他线程的队首窃取任务。池外线程提交的任务放在0号队列中。
+     * 通过`task_group`实现fork-join：`wait()`在等待期间会帮忙执行任务，
+     * 因此任务内部可以再创建`task_group`并等待，不会死锁。
+     */
+    class task_pool {
+      public:
+        using task = std::function<void()>;
+
+      private:
+        class task_deque {
+          private:
+            std::mutex _lock;
+            task** _el;
+            size_t _capacity;
+            size_t _head;
+            size_t _count;
+
+            void double_space() {
+                task** new_el = new task*[_capacity * 2];
+                for (size_t i = 0; i < _count; ++i) {
+                    new_el[i] = _el[(_head + i) % _capacity];
+                }
+                delete[] _el;
+                _el = new_el;
+                _head = 0;
+                _capacity *= 2;
+            }
+
+          public:
+            task_deque() : _capacity(64), _head(0), _count(0) {
+                _el = new task*[_capacity];
+            }
+
+            ~task_deque() {
+                for (size_t i = 0; i < _count; ++i) {
+                    delete _el[(_head + i) % _capacity];
+                }
+                delete[] _el;
+            }
+
+            void push_back(task* t) {
+                std::lock_guard<std::mutex> guard(_lock);
+                if (_count == _capacity) {
+                    double_space();
+                }
+                _el[(_head + _count) % _capacity] = t;
+                _count++;
+            }
+
+            task* pop_back() {
+                std::lock_guard<std::mutex> guard(_lock);
+                if (_count == 0) {
+                    return nullptr;
+                }
+                _count--;
+                return _el[(_head + _count) % _capacity];
+            }
+
+            task* pop_front() {
+                std::lock_guard<std::mutex> guard(_lock);
+                if (_count == 0) {
+                    return nullptr;
+                }
+                task* t = _el[_head];
+                _head = (_head + 1) % _capacity;
+                _count--;
+                return t;
+            }
+        };
+
+        unsigned _size;
+        task_deque* _queues;
+        std::thread* _threads;
+        std::atomic<size_t> _queued;
+        std::atomic<bool> _stop;
+        std::mutex _sleep_lock;
+        std::condition_variable _wake;
+
+        static inline thread_local task_pool* _current_pool = nullptr;
+        static inline thread_local unsigned _current_index = 0;
+
+        void submit(task* t) {
+            _queues[current_index()].push_back(t);
+            _queued.fetch_add(1);
+            {
+                std::lock_guard<std::mutex> guard(_sleep_lock);
+            }
+            _wake.notify_one();
+        }
+
+        task* take() {
+            const unsigned index = current_index();
+            task* t = _queues[index].pop_back();
+            for (unsigned i = 1; t == nullptr && i < _size; ++i) {
+                t = _queues[(index + i) % _size].pop_front();
+            }
+            return t;
+        }
+
+        void worker_loop(const unsigned index) {
+            _current_pool = this;
+            _current_index = index;
+            while (!_stop.load()) {
+                if (run_one()) {
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(_sleep_lock);
+                _wake.wait(lock,
+                           [this] { return _stop.load() || _queued.load() > 0; });
+            }
+        }
+
+      public:
+        /**
+         * @param threads 线程总数，包括调用`wait()`的线程。为0时使用硬件线程数。
+         */
+        explicit task_pool(unsigned threads = 0)
+            : _queued(0), _stop(false) {
+            _size = threads == 0 ? default_thread_count() : threads;
+            _queues = new task_deque[_size];
+            _threads = new std::thread[_size - 1];
+            for (unsigned i = 1; i < _size; ++i) {
+                _threads[i - 1] = std::thread([this, i] { worker_loop(i); });
+            }
+        }
+
+        task_pool(const task_pool&) = delete;
+
+        task_pool& operator=(const task_pool&) = delete;
+
+        ~task_pool() {
+            {
+                std::lock_guard<std::mutex> guard(_sleep_lock);
+                _stop.store(true);
+            }
+            _wake.notify_all();
+            for (unsigned i = 0; i + 1 < _size; ++i) {
+                _threads[i].join();
+            }
+            delete[] _threads;
+            delete[] _queues;
+        }
+
+        unsigned size() const { return _size; }
+
+        /**
+         * 当前线程在池中的编号：工作线程为1到`size() - 1`，池外的线程为0。
+         * 只有一个池外线程使用这个池时，`parallel_for()`的各个任务可以按编号
+         * 使用线程私有的缓冲区。
+         */
+        unsigned current_index() const {
+            return _current_pool == this ? _current_index : 0;
+        }
+
+        /**
+         * 取出并执行一个任务。
+         * @return 没有可执行的任务时返回false
+         */
+        bool run_one() {
+            task* t = take();
+            if (t == nullptr) {
+                return false;
+            }
+            _queued.fetch_sub(1);
+            (*t)();
+            delete t;
+            return true;
+        }
+
+        class task_group {
+          private:
+            task_pool& _pool;
+            std::atomic<size_t> _pending;
+
+          public:
+            explicit task_group(task_pool& pool) : _pool(pool), _pending(0) {}
+
+            task_group(const task_group&) = delete;
+
+            task_group& operator=(const task_group&) = delete;
+
+            ~task_group() { wait(); }
+
+            template <typename F>
+            void run(F f) {
+                _pending.fetch_add(1);
+                _pool.submit(new task([this, f]() mutable {
+                    f();
+                    _pending.fetch_sub(1, std::memory_order_release);
+                }));
+            }
+
+            void wait() {
+                while (_pending.load(std::memory_order_acquire) != 0) {
+                    if (!_pool.run_one()) {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+        };
+
+        /**
+         * 把[begin, end)划分为大小为`grain`的块，由池中所有线程动态领取执行
+         * `fn(lo, hi)`，调用线程也参与执行，返回时所有块都已完成。
+         */
+        template <typename F>
+        void parallel_for(const size_t begin, const size_t end, size_t grain,
+                          F fn) {
+            if (end <= begin) {
+                return;
+            }
+            if (grain == 0) {
+                grain = 1;
+            }
+            const size_t chunks = (end - begin + grain - 1) / grain;
+            if (_size == 1 || chunks == 1) {
+                fn(begin, end);
+                return;
+            }
+            std::atomic<size_t> next(0);
+            auto worker = [&] {
+                for (size_t c = next.fetch_add(1); c < chunks;
+                     c = next.fetch_add(1)) {
+                    const size_t lo = begin + c * grain;
+                    const size_t hi = end - lo < grain ? end : lo + grain;
+                    fn(lo, hi);
+                }
+            };
+            task_group group(*this);
+            const size_t helpers = chunks < _size ? chunks - 1 : _size - 1;
+            for (size_t i = 0; i < helpers; ++i) {
+                group.run(worker);
+            }
+            worker();
+            group.wait();
+        }
+    };
+
+    /**
+     * 使用临时创建的`task_pool`执行`task_pool::parallel_for()`。
+     */
+    template <typename F>
+    void parallel_for(const size_t begin, const size_t end, const size_t grain,
+                      const unsigned threads, F fn) {
+        if (threads == 1 || end - begin <= grain) {
+            if (begin < end) {
+                fn(begin, end);
+            }
+            return;
+        }
+        task_pool pool(threads);
+        pool.parallel_for(begin, end, grain, fn);
+    }
+} // namespace cym
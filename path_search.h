@@ -0,0 +1,363 @@
+#pragma once
+
+#include "csr_graph.h"
+#include "heap.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace cym {
+
+    /**
+     * 点对点最短路径查询，在`csr_graph`上多次查询时复用同一份临时状态。
+     *
+     * 每个顶点的距离和前驱按方向各存一份，另有一个查询编号：编号不等于当前查询的
+     * 顶点视为未访问，因此开始一次查询不需要清空数组，代价只与访问到的顶点数有关。
+     * 查询到达终点后立即停止，`path()`给出最近一次查询的路径。
+     * 与`csr_graph::shortest_path()`一样，权值为负的边被忽略。
+     *
+     * 同一个对象不能被多个线程同时使用，每个线程应当有自己的`path_search`。
+     */
+    class path_search {
+      private:
+        const csr_graph& _graph;
+        const csr_graph* _reverse;
+        size_t _v_count;
+        int* _dist[2];
+        unsigned int* _pred[2];
+        unsigned int* _stamp[2];
+        unsigned int _epoch;
+        indexed_heap<int64_t> _forward_queue;
+        indexed_heap<int64_t> _backward_queue;
+        unsigned int* _path;
+        size_t _path_size;
+        size_t _settled;
+
+        static constexpr unsigned int npos = UINT32_MAX;
+
+        void begin_query() {
+            _forward_queue.clear();
+            _backward_queue.clear();
+            _path_size = 0;
+            _settled = 0;
+            if (++_epoch == 0) {
+                memset(_stamp[0], 0, sizeof(unsigned int) * _v_count);
+                memset(_stamp[1], 0, sizeof(unsigned int) * _v_count);
+                _epoch = 1;
+            }
+        }
+
+        bool visited(const int side, const size_t v) const {
+            return _stamp[side][v] == _epoch;
+        }
+
+        int distance(const int side, const size_t v) const {
+            return visited(side, v) ? _dist[side][v] : graph::dist::infinity;
+        }
+
+        void visit(const int side, const size_t v, const int len,
+                   const unsigned int pre) {
+            _stamp[side][v] = _epoch;
+            _dist[side][v] = len;
+            _pred[side][v] = pre;
+        }
+
+        /**
+         * 沿正向的前驱从`v`走回起点，得到起点到`v`的路径。
+         */
+        void trace_forward(const size_t v) {
+            _path_size = 0;
+            for (unsigned int u = static_cast<unsigned int>(v); u != npos;
+                 u = _pred[0][u]) {
+                _path[_path_size++] = u;
+            }
+            for (size_t i = 0, j = _path_size - 1; i < j; ++i, --j) {
+                const unsigned int t = _path[i];
+                _path[i] = _path[j];
+                _path[j] = t;
+            }
+        }
+
+        /**
+         * 沿反向的前驱从`v`走到终点，接在已有路径的后面，`v`本身不重复加入。
+         */
+        void trace_backward(const size_t v) {
+            for (unsigned int u = _pred[1][v]; u != npos; u = _pred[1][u]) {
+                _path[_path_size++] = u;
+            }
+        }
+
+      public:
+        /**
+         * @param graph 查询的图，生存期必须长于本对象
+         * @param reverse 反向图（`graph.transpose()`），双向搜索需要；无向图可以传入`graph`本身
+         */
+        explicit path_search(const csr_graph& graph,
+                             const csr_graph* reverse = nullptr)
+            : _graph(graph), _reverse(reverse),
+              _v_count(graph.vertex_count()), _epoch(0),
+              _forward_queue(graph.vertex_count()),
+              _backward_queue(graph.vertex_count()),
+              _path(new unsigned int[graph.vertex_count()]), _path_size(0),
+              _settled(0) {
+            for (int side = 0; side < 2; ++side) {
+                _dist[side] = new int[_v_count];
+                _pred[side] = new unsigned int[_v_count];
+                _stamp[side] = new unsigned int[_v_count]();
+            }
+        }
+
+        path_search(const path_search&) = delete;
+
+        path_search& operator=(const path_search&) = delete;
+
+        ~path_search() {
+            for (int side = 0; side < 2; ++side) {
+                delete[] _dist[side];
+                delete[] _pred[side];
+                delete[] _stamp[side];
+            }
+            delete[] _path;
+        }
+
+        /**
+         * 最近一次查询的路径，从起点到终点（都包含在内），不可达时为空。
+         * 下一次查询后失效。
+         */
+        const unsigned int* path() const { return _path; }
+
+        size_t path_size() const { return _path_size; }
+
+        /**
+         * 最近一次查询中出堆的顶点数，用于衡量搜索空间的大小。
+         */
+        size_t settled() const { return _settled; }
+
+        /**
+         * 单向Dijkstra，终点出堆时停止。
+         * @return 最短路径长度，不可达时为`dist::infinity`
+         */
+        int dijkstra(const size_t from, const size_t to) {
+            return a_star(from, to, [](size_t, size_t) { return 0; });
+        }
+
+        /**
+         * A*搜索：优先级为已知距离加上`heuristic(v, to)`，即`v`到`to`距离的估计。
+         *
+         * 估计值不能超过真实距离（可采纳），否则结果可能不是最短路径。
+         * 估计值还满足三角不等式（一致）时每个顶点最多出堆一次；
+         * 只满足可采纳性时已出堆的顶点可能再次入堆，结果仍然正确。
+         * 坐标距离和`landmark_heuristic`都是一致的。
+         *
+         * @return 最短路径长度，不可达时为`dist::infinity`
+         */
+        template <typename Heuristic>
+        int a_star(const size_t from, const size_t to,
+                   const Heuristic& heuristic) {
+            begin_query();
+            const size_t* offsets = _graph.offsets();
+            const unsigned int* targets = _graph.targets();
+            const int* weights = _graph.weights();
+            visit(0, from, 0, npos);
+            _forward_queue.push_or_decrease(from, heuristic(from, to));
+            while (!_forward_queue.empty()) {
+                const size_t v = _forward_queue.top();
+                _forward_queue.pop();
+                _settled++;
+                const int len = _dist[0][v];
+                if (v == to) {
+                    trace_forward(to);
+                    return len;
+                }
+                for (size_t e = offsets[v]; e < offsets[v + 1]; ++e) {
+                    if (weights[e] < 0) {
+                        continue;
+                    }
+                    const unsigned int u = targets[e];
+                    const int64_t candidate =
+                        static_cast<int64_t>(len) + weights[e];
+                    if (candidate < distance(0, u)) {
+                        visit(0, u, static_cast<int>(candidate),
+                              static_cast<unsigned int>(v));
+                        _forward_queue.push_or_decrease(
+                            u, candidate + heuristic(u, to));
+                    }
+                }
+            }
+            return graph::dist::infinity;
+        }
+
+        /**
+         * 双向Dijkstra：从起点沿正向、从终点沿反向同时搜索，每次扩展堆顶较小的一侧。
+         *
+         * 松弛一条边时，若终点已被另一侧访问，就用两侧距离之和更新已知的最短长度`best`；
+         * 两个堆顶之和不小于`best`时，任何更短的路径都必须经过两侧都未出堆的顶点，
+         * 而这样的路径长度不小于两个堆顶之和，因此`best`就是答案。
+         * 两侧大约各搜索到一半的距离，在道路网这样的图上访问的顶点远少于单向搜索。
+         *
+         * 构造时没有提供反向图时退化为`dijkstra()`。
+         *
+         * @return 最短路径长度，不可达时为`dist::infinity`
+         */
+        int bidirectional(const size_t from, const size_t to) {
+            if (_reverse == nullptr) {
+                return dijkstra(from, to);
+            }
+            begin_query();
+            const csr_graph* graphs[2] = {&_graph, _reverse};
+            indexed_heap<int64_t>* queues[2] = {&_forward_queue,
+                                                &_backward_queue};
+            visit(0, from, 0, npos);
+            visit(1, to, 0, npos);
+            queues[0]->push_or_decrease(from, 0);
+            queues[1]->push_or_decrease(to, 0);
+            int64_t best = from == to ? 0 : graph::dist::infinity;
+            size_t meet = from == to ? from : npos;
+            while (!queues[0]->empty() && !queues[1]->empty() &&
+                   queues[0]->top_key() + queues[1]->top_key() < best) {
+                const int side =
+                    queues[0]->top_key() <= queues[1]->top_key() ? 0 : 1;
+                const size_t v = queues[side]->top();
+                queues[side]->pop();
+                _settled++;
+                const int len = _dist[side][v];
+                const size_t* offsets = graphs[side]->offsets();
+                const unsigned int* targets = graphs[side]->targets();
+                const int* weights = graphs[side]->weights();
+                for (size_t e = offsets[v]; e < offsets[v + 1]; ++e) {
+                    if (weights[e] < 0) {
+                        continue;
+                    }
+                    const unsigned int u = targets[e];
+                    const int64_t candidate =
+                        static_cast<int64_t>(len) + weights[e];
+                    if (candidate < distance(side, u)) {
+                        visit(side, u, static_cast<int>(candidate),
+                              static_cast<unsigned int>(v));
+                        queues[side]->push_or_decrease(u, candidate);
+                    }
+                    if (visited(1 - side, u)) {
+                        const int64_t through =
+                            static_cast<int64_t>(_dist[side][u]) +
+                            _dist[1 - side][u];
+                        if (through < best) {
+                            best = through;
+                            meet = u;
+                        }
+                    }
+                }
+            }
+            if (meet == npos) {
+                return graph::dist::infinity;
+            }
+            trace_forward(meet);
+            trace_backward(meet);
+            return static_cast<int>(best);
+        }
+    };
+
+    /**
+     * ALT（A*、地标、三角不等式）使用的启发函数。
+     *
+     * 预先求出每个地标`l`到所有顶点的距离d(l, v)和所有顶点到它的距离d(v, l)，
+     * 由三角不等式，d(v, t) ≥ d(l, t) - d(l, v)且d(v, t) ≥ d(v, l) - d(t, l)，
+     * 对所有地标取最大值即为`v`到`t`距离的下界，这个下界是一致的。
+     * 地标离查询的两端越“远”，下界越紧，因此依次选择离已选地标最远的顶点。
+     * 内存为2 · count · V个整数。
+     */
+    class landmark_heuristic {
+      private:
+        size_t _v_count;
+        size_t _count;
+        unsigned int* _landmarks;
+        int* _from_landmark;
+        int* _to_landmark;
+
+      public:
+        /**
+         * @param graph 图
+         * @param reverse 反向图（`graph.transpose()`），无向图可以传入`graph`本身
+         * @param count 地标的数量
+         * @param first 第一个地标，之后的地标自动选择
+         * @param threads 求距离时使用的线程数，为0时使用硬件线程数
+         */
+        landmark_heuristic(const csr_graph& graph, const csr_graph& reverse,
+                           const size_t count, const size_t first = 0,
+                           const unsigned threads = 1)
+            : _v_count(graph.vertex_count()), _count(0),
+              _landmarks(new unsigned int[count]),
+              _from_landmark(new int[count * graph.vertex_count()]),
+              _to_landmark(new int[count * graph.vertex_count()]) {
+            // 每个顶点到已选地标的最小距离，不可达的顶点不会被选中
+            int* nearest = new int[_v_count];
+            for (size_t v = 0; v < _v_count; ++v) {
+                nearest[v] = graph::dist::infinity;
+            }
+            size_t next = first;
+            while (_count < count && next < _v_count) {
+                const vector_t forward =
+                    threads == 1 ? graph.shortest_path(next)
+                                 : graph.shortest_path(next, threads);
+                const vector_t backward =
+                    threads == 1 ? reverse.shortest_path(next)
+                                 : reverse.shortest_path(next, threads);
+                int* from = _from_landmark + _count * _v_count;
+                int* to = _to_landmark + _count * _v_count;
+                memcpy(from, forward.data(), sizeof(int) * _v_count);
+                memcpy(to, backward.data(), sizeof(int) * _v_count);
+                _landmarks[_count++] = static_cast<unsigned int>(next);
+
+                next = _v_count;
+                int farthest = 0;
+                for (size_t v = 0; v < _v_count; ++v) {
+                    nearest[v] = from[v] < nearest[v] ? from[v] : nearest[v];
+                    if (nearest[v] != graph::dist::infinity &&
+                        nearest[v] > farthest) {
+                        farthest = nearest[v];
+                        next = v;
+                    }
+                }
+            }
+            delete[] nearest;
+        }
+
+        landmark_heuristic(const landmark_heuristic&) = delete;
+
+        landmark_heuristic& operator=(const landmark_heuristic&) = delete;
+
+        ~landmark_heuristic() {
+            delete[] _landmarks;
+            delete[] _from_landmark;
+            delete[] _to_landmark;
+        }
+
+        /**
+         * 实际选出的地标数量，图中可达的顶点不足时可能少于构造时的`count`。
+         */
+        size_t count() const { return _count; }
+
+        const unsigned int* landmarks() const { return _landmarks; }
+
+        /**
+         * `v`到`target`距离的下界。
+         */
+        int operator()(const size_t v, const size_t target) const {
+            int bound = 0;
+            for (size_t l = 0; l < _count; ++l) {
+                const int* from = _from_landmark + l * _v_count;
+                const int* to = _to_landmark + l * _v_count;
+                if (from[target] != graph::dist::infinity &&
+                    from[v] != graph::dist::infinity) {
+                    const int d = from[target] - from[v];
+                    bound = d > bound ? d : bound;
+                }
+                if (to[v] != graph::dist::infinity &&
+                    to[target] != graph::dist::infinity) {
+                    const int d = to[v] - to[target];
+                    bound = d > bound ? d : bound;
+                }
+            }
+            return bound;
+        }
+    };
+} // namespace cym
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if (defined(__GNUC__) || defined(__clang__)) &&                               \
+    (defined(__x86_64__) || defined(__i386__))
+#define CYM_SIMD_X86 1
+#include <immintrin.h>
+#define CYM_TARGET_AVX2 __attribute__((target("avx2")))
+#define CYM_TARGET_AVX2_FMA __attribute__((target("avx2,fma")))
+#else
+#define CYM_SIMD_X86 0
+#endif
+
+namespace cym {
+
+#if CYM_SIMD_X86
+
+    namespace simd_detail {
+
+        /**
+         * 运行时检测CPU是否支持AVX2。使用AVX2的函数都带有`CYM_TARGET_AVX2`，
+         * 不需要用-mavx2编译，调用前必须先检查。
+         */
+        inline bool has_avx2() {
+            static const bool supported = __builtin_cpu_supports("avx2");
+            return supported;
+        }
+
+        inline bool has_fma() {
+            static const bool supported = __builtin_cpu_supports("avx2") &&
+                                          __builtin_cpu_supports("fma");
+            return supported;
+        }
+
+        /**
+         * 256位寄存器上的逐元素运算，支持int32_t、float和double。
+         * 没有对应指令的运算（例如整数除法）逐个元素计算。
+         */
+        template <typename T>
+        struct avx2_vec {
+            static constexpr bool supported = false;
+        };
+
+        template <>
+        struct avx2_vec<int32_t> {
+            static constexpr bool supported = true;
+            static constexpr size_t width = 8;
+            using reg = __m256i;
+
+            static CYM_TARGET_AVX2 reg load(const int32_t* p) {
+                return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            }
+            static CYM_TARGET_AVX2 void store(int32_t* p, reg v) {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+            }
+            static CYM_TARGET_AVX2 reg set1(const int32_t x) {
+                return _mm256_set1_epi32(x);
+            }
+            static CYM_TARGET_AVX2 reg add(reg a, reg b) {
+                return _mm256_add_epi32(a, b);
+            }
+            static CYM_TARGET_AVX2 reg sub(reg a, reg b) {
+                return _mm256_sub_epi32(a, b);
+            }
+            static CYM_TARGET_AVX2 reg mul(reg a, reg b) {
+                return _mm256_mullo_epi32(a, b);
+            }
+            static CYM_TARGET_AVX2 reg div(reg a, reg b) {
+                alignas(32) int32_t x[8];
+                alignas(32) int32_t y[8];
+                _mm256_store_si256(reinterpret_cast<__m256i*>(x), a);
+                _mm256_store_si256(reinterpret_cast<__m256i*>(y), b);
+                for (size_t i = 0; i < 8; ++i) {
+                    x[i] /= y[i];
+                }
+                return _mm256_load_si256(reinterpret_cast<const __m256i*>(x));
+            }
+            static CYM_TARGET_AVX2 reg min(reg a, reg b) {
+                return _mm256_min_epi32(a, b);
+            }
+            static CYM_TARGET_AVX2 reg max(reg a, reg b) {
+                return _mm256_max_epi32(a, b);
+            }
+            /**
+             * 每个元素是否等于`b`中对应的元素，结果的每一位对应一个元素。
+             */
+            static CYM_TARGET_AVX2 unsigned eq_mask(reg a, reg b) {
+                return static_cast<unsigned>(_mm256_movemask_ps(
+                    _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b))));
+            }
+        };
+
+        template <>
+        struct avx2_vec<float> {
+            static constexpr bool supported = true;
+            static constexpr size_t width = 8;
+            using reg = __m256;
+
+            static CYM_TARGET_AVX2 reg load(const float* p) {
+                return _mm256_loadu_ps(p);
+            }
+            static CYM_TARGET_AVX2 void store(float* p, reg v) {
+                _mm256_storeu_ps(p, v);
+            }
+            static CYM_TARGET_AVX2 reg set1(const float x) {
+                return _mm256_set1_ps(x);
+            }
+            static CYM_TARGET_AVX2 reg add(reg a, reg b) {
+                return _mm256_add_ps(a, b);
+            }
+            static CYM_TARGET_AVX2 reg sub(reg a, reg b) {
+                return _mm256_sub_ps(a, b);
+            }
+            static CYM_TARGET_AVX2 reg mul(reg a, reg b) {
+                return _mm256_mul_ps(a, b);
+            }
+            static CYM_TARGET_AVX2 reg div(reg a, reg b) {
+                return _mm256_div_ps(a, b);
+            }
+            static CYM_TARGET_AVX2 reg min(reg a, reg b) {
+                return _mm256_min_ps(a, b);
+            }
+            static CYM_TARGET_AVX2 reg max(reg a, reg b) {
+                return _mm256_max_ps(a, b);
+            }
+            static CYM_TARGET_AVX2 unsigned eq_mask(reg a, reg b) {
+                return static_cast<unsigned>(
+                    _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ)));
+            }
+        };
+
+        template <>
+        struct avx2_vec<double> {
+            static constexpr bool supported = true;
+            static constexpr size_t width = 4;
+            using reg = __m256d;
+
+            static CYM_TARGET_AVX2 reg load(const double* p) {
+                return _mm256_loadu_pd(p);
+            }
+            static CYM_TARGET_AVX2 void store(double* p, reg v) {
+                _mm256_storeu_pd(p, v);
+            }
+            static CYM_TARGET_AVX2 reg set1(const double x) {
+                return _mm256_set1_pd(x);
+            }
+            static CYM_TARGET_AVX2 reg add(reg a, reg b) {
+                return _mm256_add_pd(a, b);
+            }
+            static CYM_TARGET_AVX2 reg sub(reg a, reg b) {
+                return _mm256_sub_pd(a, b);
+            }
+            static CYM_TARGET_AVX2 reg mul(reg a, reg b) {
+                return _mm256_mul_pd(a, b);
+            }
+            static CYM_TARGET_AVX2 reg div(reg a, reg b) {
+                return _mm256_div_pd(a, b);
+            }
+            static CYM_TARGET_AVX2 reg min(reg a, reg b) {
+                return _mm256_min_pd(a, b);
+            }
+            static CYM_TARGET_AVX2 reg max(reg a, reg b) {
+                return _mm256_max_pd(a, b);
+            }
+            static CYM_TARGET_AVX2 unsigned eq_mask(reg a, reg b) {
+                return static_cast<unsigned>(
+                    _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_EQ_OQ)));
+            }
+        };
+    } // namespace simd_detail
+
+#endif
+} // namespace cym
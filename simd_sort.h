@@ -0,0 +1,350 @@
+#pragma once
+
+#include "simd.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace cym {
+
+    /**
+     * 判断T是否可以使用向量化排序：32位和64位的整数与浮点数。
+     */
+    template <typename T>
+    struct simd_sortable
+        : std::integral_constant<bool, std::is_arithmetic<T>::value &&
+                                           !std::is_same<T, bool>::value &&
+                                           (sizeof(T) == 4 || sizeof(T) == 8)> {
+    };
+
+    /**
+     * 向量化排序能处理的最大元素数量，超过时由调用者改用其他排序算法。
+     */
+    template <typename T>
+    struct simd_sort_limit
+        : std::integral_constant<size_t, 16384 / sizeof(T)> {};
+
+    /**
+     * `sort::pdq_sort()`对不超过该规模的区间自动使用`simd_sort()`，为0时不使用。
+     * 64位整数缺少AVX2的min/max指令，向量化版本没有优势，因此不自动使用；
+     * double按64位整数排序，同样不自动使用。
+     */
+    template <typename T>
+    struct simd_sort_threshold
+        : std::integral_constant<size_t, simd_sortable<T>::value &&
+                                                 sizeof(T) == 4
+                                             ? simd_sort_limit<T>::value
+                                             : 0> {};
+
+#if CYM_SIMD_X86
+
+    namespace simd_detail {
+
+        /**
+         * AVX2寄存器上的基本操作。置换统一使用`_mm256_permutevar8x32_epi32`，
+         * 64位元素的下标展开为两个32位下标。
+         */
+        template <typename T>
+        struct avx2_ops;
+
+        template <>
+        struct avx2_ops<int32_t> {
+            static CYM_TARGET_AVX2 __m256i min(__m256i a, __m256i b) {
+                return _mm256_min_epi32(a, b);
+            }
+            static CYM_TARGET_AVX2 __m256i max(__m256i a, __m256i b) {
+                return _mm256_max_epi32(a, b);
+            }
+        };
+
+        template <>
+        struct avx2_ops<uint32_t> {
+            static CYM_TARGET_AVX2 __m256i min(__m256i a, __m256i b) {
+                return _mm256_min_epu32(a, b);
+            }
+            static CYM_TARGET_AVX2 __m256i max(__m256i a, __m256i b) {
+                return _mm256_max_epu32(a, b);
+            }
+        };
+
+        template <>
+        struct avx2_ops<int64_t> {
+            static CYM_TARGET_AVX2 __m256i min(__m256i a, __m256i b) {
+                return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+            }
+            static CYM_TARGET_AVX2 __m256i max(__m256i a, __m256i b) {
+                return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b));
+            }
+        };
+
+        template <>
+        struct avx2_ops<uint64_t> {
+            static CYM_TARGET_AVX2 __m256i gt(__m256i a, __m256i b) {
+                const __m256i bias = _mm256_set1_epi64x(INT64_MIN);
+                return _mm256_cmpgt_epi64(_mm256_xor_si256(a, bias),
+                                          _mm256_xor_si256(b, bias));
+            }
+            static CYM_TARGET_AVX2 __m256i min(__m256i a, __m256i b) {
+                return _mm256_blendv_epi8(a, b, gt(a, b));
+            }
+            static CYM_TARGET_AVX2 __m256i max(__m256i a, __m256i b) {
+                return _mm256_blendv_epi8(b, a, gt(a, b));
+            }
+        };
+
+        /**
+         * 同样大小、同样符号的整数类型映射到固定宽度类型，避免long和long long
+         * 这类同宽不同名的类型各自需要特化。浮点数映射到同宽的有符号整数，
+         * 由`flip_keys()`转换后按整数排序。
+         */
+        template <typename T>
+        using lane_t = typename std::conditional<
+            sizeof(T) == 4,
+            typename std::conditional<std::is_signed<T>::value, int32_t,
+                                      uint32_t>::type,
+            typename std::conditional<std::is_signed<T>::value, int64_t,
+                                      uint64_t>::type>::type;
+
+        /**
+         * 把浮点数的位模式原地转换为同宽的有符号整数`Key`：负数翻转符号位以外的所有位，
+         * 转换后整数的大小顺序与浮点数一致。向量的浮点min/max比较+0.0与-0.0时
+         * 总是返回第二个操作数，会让两个输出取到同一个零，整数比较没有这个问题，
+         * -0.0排在+0.0之前。该转换是自身的逆，排序后再调用一次即可还原。
+         */
+        template <typename Key, typename T>
+        void flip_keys(T* arr, const size_t size) {
+            static_assert(sizeof(Key) == sizeof(T), "Key must match T");
+            using bits_t = typename std::make_unsigned<Key>::type;
+            constexpr int shift = sizeof(Key) * 8 - 1;
+            for (size_t i = 0; i < size; ++i) {
+                bits_t bits;
+                memcpy(&bits, arr + i, sizeof(T));
+                bits ^= static_cast<bits_t>(0 - (bits >> shift)) >> 1;
+                memcpy(arr + i, &bits, sizeof(T));
+            }
+        }
+
+        /**
+         * 位于同一寄存器内的双调排序网络。
+         */
+        template <typename T>
+        struct avx2_network {
+            using ops = avx2_ops<T>;
+            static constexpr int lanes = 32 / sizeof(T);
+
+            static constexpr int width = 8 / lanes;
+
+            static constexpr int32_t partner_index(const int i, const int j) {
+                return (i / width ^ j) * width + i % width;
+            }
+
+            static constexpr int32_t reverse_index(const int i) {
+                return (lanes - 1 - i / width) * width + i % width;
+            }
+
+            static constexpr int32_t blend_mask(const int i, const int take_max) {
+                return (take_max >> (i / width)) & 1 ? -1 : 0;
+            }
+
+            /**
+             * 第k段双调序列中，第i个元素是否取较大值：升序段中位于比较对后半部分的
+             * 元素取较大值，降序段相反。
+             */
+            static constexpr int max_mask(const int j, const int k) {
+                int mask = 0;
+                for (int i = 0; i < lanes; ++i) {
+                    const bool ascending = (i & k) == 0;
+                    const bool lower = (i & j) == 0;
+                    if (lower != ascending) {
+                        mask |= 1 << i;
+                    }
+                }
+                return mask;
+            }
+
+            /**
+             * 第i个元素与第i^j个元素比较，`take_max`的第i位为1时该位置取较大值。
+             */
+            template <int j, int take_max>
+            static CYM_TARGET_AVX2 __m256i step(__m256i v) {
+                const __m256i index = _mm256_setr_epi32(
+                    partner_index(0, j), partner_index(1, j),
+                    partner_index(2, j), partner_index(3, j),
+                    partner_index(4, j), partner_index(5, j),
+                    partner_index(6, j), partner_index(7, j));
+                const __m256i mask = _mm256_setr_epi32(
+                    blend_mask(0, take_max), blend_mask(1, take_max),
+                    blend_mask(2, take_max), blend_mask(3, take_max),
+                    blend_mask(4, take_max), blend_mask(5, take_max),
+                    blend_mask(6, take_max), blend_mask(7, take_max));
+                const __m256i partner = _mm256_permutevar8x32_epi32(v, index);
+                return _mm256_blendv_epi8(ops::min(v, partner),
+                                          ops::max(v, partner), mask);
+            }
+
+            template <int k, int j>
+            static CYM_TARGET_AVX2 __m256i sort_stage(__m256i v) {
+                v = step<j, max_mask(j, k)>(v);
+                if constexpr (j > 1) {
+                    return sort_stage<k, j / 2>(v);
+                } else if constexpr (k < lanes) {
+                    return sort_stage<k * 2, k>(v);
+                } else {
+                    return v;
+                }
+            }
+
+            /**
+             * 把一个双调序列整理为升序。
+             */
+            template <int j>
+            static CYM_TARGET_AVX2 __m256i clean(__m256i v) {
+                v = step<j, max_mask(j, 2 * lanes)>(v);
+                if constexpr (j > 1) {
+                    return clean<j / 2>(v);
+                } else {
+                    return v;
+                }
+            }
+
+            static CYM_TARGET_AVX2 __m256i sort(__m256i v) {
+                return sort_stage<2, 1>(v);
+            }
+
+            /**
+             * 输入两个升序寄存器，输出后`a`为其中较小的一半，`b`为较大的一半，
+             * 都是升序。
+             */
+            static CYM_TARGET_AVX2 void merge(__m256i& a, __m256i& b) {
+                const __m256i index = _mm256_setr_epi32(
+                    reverse_index(0), reverse_index(1), reverse_index(2),
+                    reverse_index(3), reverse_index(4), reverse_index(5),
+                    reverse_index(6), reverse_index(7));
+                const __m256i r = _mm256_permutevar8x32_epi32(b, index);
+                const __m256i lo = ops::min(a, r);
+                const __m256i hi = ops::max(a, r);
+                a = clean<lanes / 2>(lo);
+                b = clean<lanes / 2>(hi);
+            }
+
+            static CYM_TARGET_AVX2 __m256i load(const T* p) {
+                return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            }
+
+            static CYM_TARGET_AVX2 void store(T* p, __m256i v) {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+            }
+
+            /**
+             * 归并两个长度为`lanes`整数倍的有序段。寄存器`hi`始终保存已读入元素中
+             * 最大的`lanes`个，每次从队首较小的一侧读入一个寄存器与之归并。
+             */
+            static CYM_TARGET_AVX2 void merge_runs(const T* a,
+                                                   const T* a_end,
+                                                   const T* b,
+                                                   const T* b_end, T* out) {
+                __m256i lo = load(a);
+                __m256i hi = load(b);
+                a += lanes;
+                b += lanes;
+                merge(lo, hi);
+                store(out, lo);
+                out += lanes;
+                while (a != a_end || b != b_end) {
+                    if (b == b_end || (a != a_end && !(*b < *a))) {
+                        lo = load(a);
+                        a += lanes;
+                    } else {
+                        lo = load(b);
+                        b += lanes;
+                    }
+                    merge(lo, hi);
+                    store(out, lo);
+                    out += lanes;
+                }
+                store(out, hi);
+            }
+
+            static CYM_TARGET_AVX2 void sort(T* arr, const size_t size) {
+                constexpr size_t capacity = simd_sort_limit<T>::value;
+                alignas(32) T buffer[2][capacity];
+                const size_t padded = (size + lanes - 1) / lanes * lanes;
+                T* src = buffer[0];
+                T* dst = buffer[1];
+                memcpy(src, arr, sizeof(T) * size);
+                for (size_t i = size; i < padded; ++i) {
+                    src[i] = std::numeric_limits<T>::max();
+                }
+                for (size_t i = 0; i < padded; i += lanes) {
+                    store(src + i, sort(load(src + i)));
+                }
+                for (size_t width = lanes; width < padded; width *= 2) {
+                    for (size_t lo = 0; lo < padded; lo += 2 * width) {
+                        const size_t mid = padded - lo < width ? padded : lo + width;
+                        const size_t hi =
+                            padded - mid < width ? padded : mid + width;
+                        if (mid == hi) {
+                            memcpy(dst + lo, src + lo, sizeof(T) * (mid - lo));
+                        } else {
+                            merge_runs(src + lo, src + mid, src + mid, src + hi,
+                                       dst + lo);
+                        }
+                    }
+                    T* tmp = src;
+                    src = dst;
+                    dst = tmp;
+                }
+                memcpy(arr, src, sizeof(T) * size);
+            }
+        };
+    } // namespace simd_detail
+
+#endif
+
+    /**
+     * 对不超过`simd_sort_limit<T>::value`个32位或64位的整数、浮点数升序排序。
+     *
+     * 先在每个寄存器内用双调排序网络排序，再用寄存器内的双调归并逐层归并有序段。
+     * 运行时检测CPU，支持AVX2时使用向量化实现。
+     *
+     * 浮点数先转换为顺序相同的整数再排序，相等的+0.0与-0.0中-0.0在前。
+     * 转换后的NaN会排在两端，与`less`的语义不符，因此含有NaN的浮点数组返回false。
+     *
+     * @return 类型、规模、CPU或NaN不满足要求时不做任何事并返回false，
+     *         调用者应改用标量排序
+     */
+    template <typename T>
+    bool simd_sort(T arr[], const size_t size) {
+#if CYM_SIMD_X86
+        if constexpr (simd_sortable<T>::value) {
+            using lane = simd_detail::lane_t<T>;
+            if (size > simd_sort_limit<T>::value || !simd_detail::has_avx2()) {
+                return false;
+            }
+            if constexpr (std::is_floating_point<T>::value) {
+                for (size_t i = 0; i < size; ++i) {
+                    if (arr[i] != arr[i]) {
+                        return false;
+                    }
+                }
+            }
+            if (size > 1) {
+                if constexpr (std::is_floating_point<T>::value) {
+                    simd_detail::flip_keys<lane>(arr, size);
+                }
+                simd_detail::avx2_network<lane>::sort(
+                    reinterpret_cast<lane*>(arr), size);
+                if constexpr (std::is_floating_point<T>::value) {
+                    simd_detail::flip_keys<lane>(arr, size);
+                }
+            }
+            return true;
+        }
+#endif
+        (void)arr;
+        (void)size;
+        return false;
+    }
+} // namespace cym
@@ -0,0 +1,699 @@
+#pragma once
+
+#include "csr_graph.h"
+#include "graph.h"
+#include "parallel.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace cym {
+
+    namespace scc_detail {
+        constexpr unsigned int npos = UINT32_MAX;
+
+        /**
+         * `csr_graph`的邻接表，每条弧都是一条边。传入`transpose()`的结果即得到入边。
+         *
+         * 与`matrix_view`一样，`v`的邻居是在[begin(v), end(v))中逐个调用`neighbor()`
+         * 得到的不为`npos`的值，迭代的深度优先搜索只需为每个顶点保存一个位置。
+         */
+        class csr_view {
+          private:
+            const size_t* _offsets;
+            const unsigned int* _targets;
+            size_t _v_count;
+
+          public:
+            explicit csr_view(const csr_graph& graph)
+                : _offsets(graph.offsets()), _targets(graph.targets()),
+                  _v_count(graph.vertex_count()) {}
+
+            size_t vertex_count() const { return _v_count; }
+
+            size_t begin(const size_t v) const { return _offsets[v]; }
+
+            size_t end(const size_t v) const { return _offsets[v + 1]; }
+
+            unsigned int neighbor(size_t, const size_t k) const {
+                return _targets[k];
+            }
+        };
+
+        /**
+         * `directed_graph`的邻接矩阵，权值为负的项表示没有边，对角线被忽略。
+         * `transposed`为true时按列读取，得到入边。
+         */
+        class matrix_view {
+          private:
+            const int* _data;
+            size_t _v_count;
+            bool _transposed;
+
+          public:
+            matrix_view(const directed_graph& graph, const bool transposed)
+                : _data(graph.adjacency_matrix().data()),
+                  _v_count(graph.vertex_count()), _transposed(transposed) {}
+
+            size_t vertex_count() const { return _v_count; }
+
+            size_t begin(size_t) const { return 0; }
+
+            size_t end(size_t) const { return _v_count; }
+
+            unsigned int neighbor(const size_t v, const size_t k) const {
+                const int weight = _transposed ? _data[k * _v_count + v]
+                                               : _data[v * _v_count + k];
+                return weight >= 0 && k != v ? static_cast<unsigned int>(k)
+                                             : npos;
+            }
+        };
+
+        /**
+         * Pearce的迭代算法，见`strongly_connected_components()`。
+         *
+         * `rindex[v]`在访问时取递增的访问序号，之后降为能到达的最小序号；
+         * 序号没有降低的顶点是分量的根，它和栈中序号不小于它的顶点构成一个分量。
+         * 分量的编号从V - 1开始递减，弹出的顶点的序号同时回收，因此编号总是大于
+         * 任何正在使用的序号，已完成的顶点不会影响后续的比较，不需要另外的
+         * 在栈中的标记。每个顶点只需要序号、根标记和一个邻居位置。
+         */
+        template <typename View>
+        vector_t pearce(const View& graph, size_t* count) {
+            const size_t v_count = graph.vertex_count();
+            unsigned int* rindex = new unsigned int[v_count]();
+            unsigned char* root = new unsigned char[v_count];
+            size_t* next = new size_t[v_count];
+            unsigned int* call = new unsigned int[v_count];
+            unsigned int* stack = new unsigned int[v_count];
+            size_t depth = 0;
+            size_t top = 0;
+            unsigned int index = 1;
+            unsigned int c = static_cast<unsigned int>(v_count) - 1;
+            size_t components = 0;
+
+            auto visit = [&](const unsigned int v) {
+                rindex[v] = index++;
+                root[v] = 1;
+                next[v] = graph.begin(v);
+                call[depth++] = v;
+            };
+            for (size_t s = 0; s < v_count; ++s) {
+                if (rindex[s] != 0) {
+                    continue;
+                }
+                visit(static_cast<unsigned int>(s));
+                while (depth > 0) {
+                    const unsigned int u = call[depth - 1];
+                    if (next[u] < graph.end(u)) {
+                        const unsigned int w = graph.neighbor(u, next[u]++);
+                        if (w == npos) {
+                            continue;
+                        }
+                        if (rindex[w] == 0) {
+                            visit(w);
+                        } else if (rindex[w] < rindex[u]) {
+                            rindex[u] = rindex[w];
+                            root[u] = 0;
+                        }
+                        continue;
+                    }
+                    depth--;
+                    if (root[u]) {
+                        index--;
+                        while (top > 0 && rindex[u] <= rindex[stack[top - 1]]) {
+                            rindex[stack[--top]] = c;
+                            index--;
+                        }
+                        rindex[u] = c--;
+                        components++;
+                    } else {
+                        stack[top++] = u;
+                    }
+                    if (depth > 0) {
+                        const unsigned int p = call[depth - 1];
+                        if (rindex[u] < rindex[p]) {
+                            rindex[p] = rindex[u];
+                            root[p] = 0;
+                        }
+                    }
+                }
+            }
+
+            // 先完成的分量编号较大，换算后编号即为缩点图的拓扑序
+            vector_t labels({v_count});
+            for (size_t v = 0; v < v_count; ++v) {
+                labels(v) = static_cast<int>(rindex[v] - (v_count - components));
+            }
+            if (count != nullptr) {
+                *count = components;
+            }
+            delete[] rindex;
+            delete[] root;
+            delete[] next;
+            delete[] call;
+            delete[] stack;
+            return labels;
+        }
+
+        /**
+         * 在剩余的顶点（`remaining[v]`不为0）中用迭代的深度优先搜索找一个环。
+         * Kahn算法结束后剩余的每个顶点都有来自剩余顶点的入边，因此一定有环。
+         */
+        template <typename View>
+        vector_t find_cycle(const View& graph, const unsigned int* remaining) {
+            const size_t v_count = graph.vertex_count();
+            // 0：未访问，1：在搜索栈中，2：已完成或不在剩余的顶点中
+            unsigned char* color = new unsigned char[v_count];
+            for (size_t v = 0; v < v_count; ++v) {
+                color[v] = remaining[v] != 0 ? 0 : 2;
+            }
+            size_t* next = new size_t[v_count];
+            unsigned int* call = new unsigned int[v_count];
+            vector_t cycle({1});
+            bool found = false;
+            for (size_t s = 0; s < v_count && !found; ++s) {
+                if (color[s] != 0) {
+                    continue;
+                }
+                size_t depth = 0;
+                color[s] = 1;
+                next[s] = graph.begin(s);
+                call[depth++] = static_cast<unsigned int>(s);
+                while (depth > 0 && !found) {
+                    const unsigned int u = call[depth - 1];
+                    if (next[u] == graph.end(u)) {
+                        color[u] = 2;
+                        depth--;
+                        continue;
+                    }
+                    const unsigned int w = graph.neighbor(u, next[u]++);
+                    if (w == npos || color[w] == 2) {
+                        continue;
+                    }
+                    if (color[w] == 0) {
+                        color[w] = 1;
+                        next[w] = graph.begin(w);
+                        call[depth++] = w;
+                        continue;
+                    }
+                    // 回边u -> w，栈中从w到u的一段就是环
+                    size_t first = depth - 1;
+                    while (call[first] != w) {
+                        first--;
+                    }
+                    cycle = vector_t({depth - first});
+                    for (size_t i = first; i < depth; ++i) {
+                        cycle(i - first) = static_cast<int>(call[i]);
+                    }
+                    found = true;
+                }
+            }
+            delete[] color;
+            delete[] next;
+            delete[] call;
+            return cycle;
+        }
+
+        /**
+         * Kahn算法，见`topological_sort()`。
+         */
+        template <typename View>
+        bool kahn(const View& graph, vector_t& order, vector_t* cycle) {
+            const size_t v_count = graph.vertex_count();
+            unsigned int* in_degree = new unsigned int[v_count]();
+            for (size_t u = 0; u < v_count; ++u) {
+                for (size_t k = graph.begin(u); k < graph.end(u); ++k) {
+                    const unsigned int w = graph.neighbor(u, k);
+                    if (w != npos) {
+                        in_degree[w]++;
+                    }
+                }
+            }
+            // 结果数组同时作为队列
+            order = vector_t({v_count});
+            int* queue = order.data();
+            size_t head = 0;
+            size_t tail = 0;
+            for (size_t v = 0; v < v_count; ++v) {
+                if (in_degree[v] == 0) {
+                    queue[tail++] = static_cast<int>(v);
+                }
+            }
+            while (head < tail) {
+                const size_t u = queue[head++];
+                for (size_t k = graph.begin(u); k < graph.end(u); ++k) {
+                    const unsigned int w = graph.neighbor(u, k);
+                    if (w != npos && --in_degree[w] == 0) {
+                        queue[tail++] = static_cast<int>(w);
+                    }
+                }
+            }
+            const bool acyclic = tail == v_count;
+            if (!acyclic) {
+                for (size_t i = tail; i < v_count; ++i) {
+                    queue[i] = -1;
+                }
+                if (cycle != nullptr) {
+                    *cycle = find_cycle(graph, in_degree);
+                }
+            }
+            delete[] in_degree;
+            return acyclic;
+        }
+
+        template <typename T>
+        T load(const T& x) {
+            return __atomic_load_n(&x, __ATOMIC_RELAXED);
+        }
+
+        template <typename T>
+        void store(T& x, const T value) {
+            __atomic_store_n(&x, value, __ATOMIC_RELAXED);
+        }
+
+        /**
+         * 从`pivot`出发的多线程逐层搜索，只经过未分配分量的顶点。
+         * 状态为`from_a`（`from_b`）的顶点被访问后变为`to_a`（`to_b`），
+         * 用比较交换保证每个顶点只进入一次前沿。
+         */
+        template <typename View>
+        void reach(const View& graph, const unsigned int pivot, const int* label,
+                   unsigned char* state, const unsigned char from_a,
+                   const unsigned char to_a, const unsigned char from_b,
+                   const unsigned char to_b, unsigned int* frontier,
+                   unsigned int* next, task_pool& pool) {
+            state[pivot] = state[pivot] == from_a ? to_a : to_b;
+            frontier[0] = pivot;
+            size_t size = 1;
+            while (size > 0) {
+                size_t next_size = 0;
+                pool.parallel_for(0, size, 256, [&](size_t lo, size_t hi) {
+                    for (size_t i = lo; i < hi; ++i) {
+                        const unsigned int u = frontier[i];
+                        for (size_t k = graph.begin(u); k < graph.end(u); ++k) {
+                            const unsigned int w = graph.neighbor(u, k);
+                            if (w == npos || label[w] >= 0) {
+                                continue;
+                            }
+                            unsigned char s = load(state[w]);
+                            const unsigned char t = s == from_a   ? to_a
+                                                    : s == from_b ? to_b
+                                                                  : s;
+                            if (t != s &&
+                                __atomic_compare_exchange_n(
+                                    &state[w], &s, t, false, __ATOMIC_RELAXED,
+                                    __ATOMIC_RELAXED)) {
+                                next[__atomic_fetch_add(&next_size, 1,
+                                                        __ATOMIC_RELAXED)] = w;
+                            }
+                        }
+                    }
+                });
+                unsigned int* t = frontier;
+                frontier = next;
+                next = t;
+                size = next_size;
+            }
+        }
+
+        /**
+         * 单线程地划分一段顶点[begin, end)，返回产生的非空段数，段写入`out`。
+         * `scratch`的同一区间用作搜索队列和重排的缓冲区。
+         * 不同的段没有公共顶点，其他线程只会读到本段顶点的`part`不等于自己的段号，
+         * 因此用relaxed的原子操作读写即可。
+         */
+        template <typename Forward, typename Backward, typename NewComponent>
+        size_t split(const Forward& forward, const Backward& backward,
+                     const unsigned int begin, const unsigned int end,
+                     unsigned int* vertices, unsigned int* scratch,
+                     unsigned int* part, unsigned char* state, int* label,
+                     const NewComponent& new_component, unsigned int* out) {
+            if (end - begin == 1) {
+                store(label[vertices[begin]], new_component());
+                store(part[vertices[begin]], npos);
+                return 0;
+            }
+            const unsigned int id = begin;
+            unsigned int* queue = scratch + begin;
+            const unsigned int pivot = vertices[begin + (end - begin) / 2];
+            auto search = [&](const auto& graph, const unsigned char from_a,
+                              const unsigned char to_a,
+                              const unsigned char from_b,
+                              const unsigned char to_b) {
+                size_t head = 0;
+                size_t tail = 0;
+                state[pivot] = state[pivot] == from_a ? to_a : to_b;
+                queue[tail++] = pivot;
+                while (head < tail) {
+                    const unsigned int u = queue[head++];
+                    for (size_t k = graph.begin(u); k < graph.end(u); ++k) {
+                        const unsigned int w = graph.neighbor(u, k);
+                        if (w == npos || load(part[w]) != id) {
+                            continue;
+                        }
+                        if (state[w] == from_a) {
+                            state[w] = to_a;
+                            queue[tail++] = w;
+                        } else if (state[w] == from_b) {
+                            state[w] = to_b;
+                            queue[tail++] = w;
+                        }
+                    }
+                }
+            };
+            search(forward, 0, 1, 0, 1);
+            search(backward, 0, 2, 1, 3);
+
+            const int component = new_component();
+            size_t bucket[4] = {0, 0, 0, 0};
+            for (unsigned int i = begin; i < end; ++i) {
+                bucket[state[vertices[i]]]++;
+            }
+            const unsigned int first[3] = {
+                begin, static_cast<unsigned int>(begin + bucket[1]),
+                static_cast<unsigned int>(begin + bucket[1] + bucket[2])};
+            const unsigned int last =
+                static_cast<unsigned int>(first[2] + bucket[0]);
+            size_t start[4] = {first[2], first[0], first[1], 0};
+            for (unsigned int i = begin; i < end; ++i) {
+                const unsigned int v = vertices[i];
+                const unsigned char s = state[v];
+                state[v] = 0;
+                if (s == 3) {
+                    store(label[v], component);
+                    store(part[v], npos);
+                    continue;
+                }
+                scratch[start[s]++] = v;
+                store(part[v], s == 1 ? first[0] : s == 2 ? first[1] : first[2]);
+            }
+            memcpy(vertices + begin, scratch + begin,
+                   sizeof(unsigned int) * (last - begin));
+            size_t produced = 0;
+            for (int i = 0; i < 3; ++i) {
+                const unsigned int stop = i == 2 ? last : first[i + 1];
+                if (stop > first[i]) {
+                    out[2 * produced] = first[i];
+                    out[2 * produced + 1] = stop;
+                    produced++;
+                }
+            }
+            return produced;
+        }
+
+        /**
+         * 前向-后向算法，见`forward_backward_scc()`。
+         */
+        template <typename Forward, typename Backward>
+        vector_t forward_backward(const Forward& forward,
+                                  const Backward& backward, unsigned threads,
+                                  size_t* count) {
+            threads = threads == 0 ? default_thread_count() : threads;
+            task_pool pool(threads);
+            const size_t v_count = forward.vertex_count();
+            const size_t grain = 1 << 12;
+            vector_t labels({v_count});
+            int* label = labels.data();
+            int components = 0;
+            auto new_component = [&components]() {
+                return __atomic_fetch_add(&components, 1, __ATOMIC_RELAXED);
+            };
+            unsigned char* state = new unsigned char[v_count]();
+            pool.parallel_for(0, v_count, grain, [&](size_t lo, size_t hi) {
+                for (size_t v = lo; v < hi; ++v) {
+                    label[v] = -1;
+                }
+            });
+
+            // 1. 剪枝：入度或出度为0的顶点自成一个分量。度数只计未分配的邻居，
+            //    不计自环；删去一个顶点后邻居的度数减1，降为0的邻居进入下一轮
+            unsigned int* vertices = new unsigned int[v_count];
+            unsigned int* scratch = new unsigned int[v_count];
+            unsigned int* in_degree = new unsigned int[v_count];
+            unsigned int* out_degree = new unsigned int[v_count];
+            auto degree = [](const auto& graph, const size_t v) {
+                unsigned int d = 0;
+                for (size_t k = graph.begin(v); k < graph.end(v); ++k) {
+                    const unsigned int w = graph.neighbor(v, k);
+                    d += w != npos && w != v;
+                }
+                return d;
+            };
+            pool.parallel_for(0, v_count, grain, [&](size_t lo, size_t hi) {
+                for (size_t v = lo; v < hi; ++v) {
+                    out_degree[v] = degree(forward, v);
+                    in_degree[v] = degree(backward, v);
+                    state[v] = out_degree[v] == 0 || in_degree[v] == 0;
+                }
+            });
+            size_t size = 0;
+            for (size_t v = 0; v < v_count; ++v) {
+                if (state[v]) {
+                    vertices[size++] = static_cast<unsigned int>(v);
+                }
+            }
+            while (size > 0) {
+                size_t next_size = 0;
+                pool.parallel_for(0, size, 256, [&](size_t lo, size_t hi) {
+                    auto drop = [&](const auto& graph, const unsigned int v,
+                                    unsigned int* degrees) {
+                        for (size_t k = graph.begin(v); k < graph.end(v); ++k) {
+                            const unsigned int w = graph.neighbor(v, k);
+                            if (w == npos || w == v ||
+                                __atomic_sub_fetch(&degrees[w], 1,
+                                                   __ATOMIC_RELAXED) != 0) {
+                                continue;
+                            }
+                            unsigned char s = 0;
+                            if (__atomic_compare_exchange_n(
+                                    &state[w], &s, 1, false, __ATOMIC_RELAXED,
+                                    __ATOMIC_RELAXED)) {
+                                scratch[__atomic_fetch_add(
+                                    &next_size, 1, __ATOMIC_RELAXED)] = w;
+                            }
+                        }
+                    };
+                    for (size_t i = lo; i < hi; ++i) {
+                        const unsigned int v = vertices[i];
+                        label[v] = new_component();
+                        drop(forward, v, in_degree);
+                        drop(backward, v, out_degree);
+                    }
+                });
+                unsigned int* t = vertices;
+                vertices = scratch;
+                scratch = t;
+                size = next_size;
+            }
+            memset(state, 0, v_count);
+
+            // 2. 以剩余的入度与出度之积最大的顶点为起点，多线程求出最大的分量
+            const unsigned workers = pool.size();
+            size_t* best_score = new size_t[workers]();
+            unsigned int* best_vertex = new unsigned int[workers];
+            for (unsigned w = 0; w < workers; ++w) {
+                best_vertex[w] = npos;
+            }
+            pool.parallel_for(0, v_count, grain, [&](size_t lo, size_t hi) {
+                const unsigned w = pool.current_index();
+                for (size_t v = lo; v < hi; ++v) {
+                    if (label[v] >= 0) {
+                        continue;
+                    }
+                    const size_t score =
+                        static_cast<size_t>(out_degree[v]) * in_degree[v];
+                    if (best_vertex[w] == npos || score > best_score[w]) {
+                        best_score[w] = score;
+                        best_vertex[w] = static_cast<unsigned int>(v);
+                    }
+                }
+            });
+            delete[] in_degree;
+            delete[] out_degree;
+            unsigned int pivot = npos;
+            size_t score = 0;
+            for (unsigned w = 0; w < workers; ++w) {
+                if (best_vertex[w] != npos &&
+                    (pivot == npos || best_score[w] > score)) {
+                    pivot = best_vertex[w];
+                    score = best_score[w];
+                }
+            }
+            delete[] best_score;
+            delete[] best_vertex;
+
+            // 每一段的顶点的`part`为段的起始下标，已分配分量的顶点为npos
+            unsigned int* part = new unsigned int[v_count];
+            unsigned int* segments = new unsigned int[2 * v_count + 2];
+            size_t segment_count = 0;
+            if (pivot != npos) {
+                // 前向可达的顶点状态为1，后向可达的为2，两者都可达的为3
+                reach(forward, pivot, label, state, 0, 1, 0, 1, vertices,
+                      scratch, pool);
+                reach(backward, pivot, label, state, 0, 2, 1, 3, vertices,
+                      scratch, pool);
+                const int giant = new_component();
+                size_t bucket[4] = {0, 0, 0, 0};
+                for (size_t v = 0; v < v_count; ++v) {
+                    if (label[v] < 0) {
+                        bucket[state[v]]++;
+                    }
+                }
+                // 按状态1、2、0分为三段
+                size_t start[4] = {bucket[1] + bucket[2], 0, bucket[1], 0};
+                const unsigned int first[3] = {
+                    0, static_cast<unsigned int>(bucket[1]),
+                    static_cast<unsigned int>(bucket[1] + bucket[2])};
+                for (size_t v = 0; v < v_count; ++v) {
+                    if (label[v] >= 0) {
+                        part[v] = npos;
+                    } else if (state[v] == 3) {
+                        label[v] = giant;
+                        part[v] = npos;
+                    } else {
+                        const unsigned char s = state[v];
+                        vertices[start[s]++] = static_cast<unsigned int>(v);
+                        part[v] = s == 1 ? first[0] : s == 2 ? first[1]
+                                                             : first[2];
+                    }
+                    state[v] = 0;
+                }
+                for (int i = 0; i < 3; ++i) {
+                    const size_t end =
+                        i == 2 ? bucket[1] + bucket[2] + bucket[0]
+                               : first[i + 1];
+                    if (end > first[i]) {
+                        segments[2 * segment_count] = first[i];
+                        segments[2 * segment_count + 1] =
+                            static_cast<unsigned int>(end);
+                        segment_count++;
+                    }
+                }
+            }
+
+            // 3. 其余的段互不相连，每一段由一个线程用单线程的前向-后向算法划分为
+            //    前向可达、后向可达和都不可达的三段，逐轮进行直到没有剩余的段
+            unsigned int* next_segments = new unsigned int[2 * v_count + 2];
+            while (segment_count > 0) {
+                size_t next_count = 0;
+                pool.parallel_for(0, segment_count, 1, [&](size_t lo, size_t hi) {
+                    for (size_t i = lo; i < hi; ++i) {
+                        const unsigned int begin = segments[2 * i];
+                        const unsigned int end = segments[2 * i + 1];
+                        unsigned int out[6];
+                        const size_t produced =
+                            split(forward, backward, begin, end, vertices,
+                                  scratch, part, state, label, new_component,
+                                  out);
+                        if (produced == 0) {
+                            continue;
+                        }
+                        const size_t at = __atomic_fetch_add(
+                            &next_count, produced, __ATOMIC_RELAXED);
+                        memcpy(next_segments + 2 * at, out,
+                               sizeof(unsigned int) * 2 * produced);
+                    }
+                });
+                unsigned int* t = segments;
+                segments = next_segments;
+                next_segments = t;
+                segment_count = next_count;
+            }
+            delete[] state;
+            delete[] vertices;
+            delete[] scratch;
+            delete[] part;
+            delete[] segments;
+            delete[] next_segments;
+            if (count != nullptr) {
+                *count = static_cast<size_t>(components);
+            }
+            return labels;
+        }
+
+    } // namespace scc_detail
+
+    /**
+     * 强连通分量，使用Pearce的迭代算法（Tarjan算法的省空间版本），单线程，O(V + E)。
+     * 深度优先搜索用显式的栈，顶点数很多、路径很长时也不会栈溢出。
+     *
+     * 分量的编号为0到count - 1，并且是缩点图的一个拓扑序：
+     * 对不同分量之间的边u -> v，u的编号小于v的编号。
+     *
+     * @param count 不为空时写入分量的数量
+     * @return 每个顶点所在分量的编号
+     */
+    inline vector_t strongly_connected_components(const csr_graph& graph,
+                                                  size_t* count = nullptr) {
+        return scc_detail::pearce(scc_detail::csr_view(graph), count);
+    }
+
+    /**
+     * 与`csr_graph`的版本相同，矩阵中权值为负的项表示没有边，对角线被忽略。
+     * 遍历一个顶点的邻居需要扫描整行，总代价为O(V²)。
+     */
+    inline vector_t strongly_connected_components(const directed_graph& graph,
+                                                  size_t* count = nullptr) {
+        return scc_detail::pearce(scc_detail::matrix_view(graph, false), count);
+    }
+
+    /**
+     * 多线程的前向-后向（FW-BW）算法求强连通分量，结果与
+     * `strongly_connected_components()`是相同的划分，但编号不是拓扑序。
+     *
+     * 1. 剪枝：没有未分配的入边或出边的顶点自成一个分量，删去后邻居的度数减1，
+     *    逐轮进行直到不再变化，无环的部分在这一步全部完成；
+     * 2. 以入度与出度之积最大的顶点为起点，多线程地分别沿出边和入边逐层搜索，
+     *    两边都能到达的顶点构成一个分量，通常就是最大的分量；
+     * 3. 剩下的顶点分为只有前向可达、只有后向可达和都不可达的三段，不同段之间
+     *    不会有同一个分量，每一段再以中间的顶点为起点递归划分。各段相互独立，
+     *    由不同的线程同时处理。
+     *
+     * 需要入边，`csr_graph`的版本内部调用`transpose(threads)`。
+     *
+     * @param threads 线程数，为0时使用硬件线程数
+     * @param count 不为空时写入分量的数量
+     */
+    inline vector_t forward_backward_scc(const csr_graph& graph,
+                                         const unsigned threads = 1,
+                                         size_t* count = nullptr) {
+        const csr_graph reverse = graph.transpose(threads);
+        return scc_detail::forward_backward(scc_detail::csr_view(graph),
+                                            scc_detail::csr_view(reverse),
+                                            threads, count);
+    }
+
+    /**
+     * 与`csr_graph`的版本相同，入边直接按列读取矩阵。
+     */
+    inline vector_t forward_backward_scc(const directed_graph& graph,
+                                         const unsigned threads = 1,
+                                         size_t* count = nullptr) {
+        return scc_detail::forward_backward(
+            scc_detail::matrix_view(graph, false),
+            scc_detail::matrix_view(graph, true), threads, count);
+    }
+
+    /**
+     * Kahn算法求拓扑序：反复取出入度为0的顶点并删去它的出边，O(V + E)。
+     *
+     * @param order 写入拓扑序。有环时前面是不依赖于环的顶点，其余为-1
+     * @param cycle 不为空且有环时写入一个环上的顶点，
+     *              `(*cycle)(i)`到`(*cycle)(i + 1)`以及最后一个顶点到第一个顶点都有边
+     * @return 图中没有环时返回true
+     */
+    inline bool topological_sort(const csr_graph& graph, vector_t& order,
+                                 vector_t* cycle = nullptr) {
+        return scc_detail::kahn(scc_detail::csr_view(graph), order, cycle);
+    }
+
+    /**
+     * 与`csr_graph`的版本相同，矩阵中权值为负的项表示没有边，对角线被忽略。
+     */
+    inline bool topological_sort(const directed_graph& graph, vector_t& order,
+                                 vector_t* cycle = nullptr) {
+        return scc_detail::kahn(scc_detail::matrix_view(graph, false), order,
+                                cycle);
+    }
+} // namespace cym
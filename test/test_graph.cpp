@@ -0,0 +1,782 @@
+#include "../contraction_hierarchy.h"
+#include "../csr_graph.h"
+#include "../dynamic_shortest_path.h"
+#include "../graph.h"
+#include "../multi_source_bfs.h"
+#include "../path_search.h"
+#include "../strong_components.h"
+#include "../undirected_graph.h"
+#include "../union_find.h"
+#include "test_common.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <tuple>
+#include <vector>
+
+using edge_t = cym::graph::edge;
+
+/**
+ * 生成`v_count`个顶点、`e_count`条有向边的随机图，权值在[1, 100]之间。
+ */
+std::vector<edge_t> random_edges(const size_t v_count, const size_t e_count,
+                                 const unsigned seed) {
+    std::mt19937 gen(seed);
+    std::vector<edge_t> edges;
+    for (size_t i = 0; i < e_count; ++i) {
+        const unsigned int from = gen() % v_count;
+        const unsigned int to = gen() % v_count;
+        if (from != to) {
+            edges.emplace_back(from, to, static_cast<int>(gen() % 100 + 1),
+                               true);
+        }
+    }
+    return edges;
+}
+
+void test_csr_graph() {
+    const edge_t edges[] = {{0, 1, 4, true},  {0, 2, 1, true},
+                            {2, 1, 2, true},  {1, 3, 5, true},
+                            {2, 3, 8, false}, {0, 2, 3, true}};
+    cym::csr_graph g(5, edges, 6, 2);
+    EXPECT_EQ(g.vertex_count(), 5)
+    // 0->2的两条边合并为一条，2-3的无向边存为两条
+    EXPECT_EQ(g.edge_count(), 6)
+    EXPECT_EQ(g.degree(2), 2)
+    EXPECT_EQ(g.get_edge(0, 2).weight(), 1)
+    EXPECT_EQ(g.get_edge(3, 2).weight(), 8)
+    EXPECT_EQ(g.get_edge(3, 0).weight(), -1)
+
+    cym::vector_t dists = g.shortest_path(0);
+    EXPECT_EQ(dists(1), 3)
+    EXPECT_EQ(dists(3), 8)
+    EXPECT_EQ(dists(4), cym::graph::dist::infinity)
+
+    g.set_edge(edge_t(4, 0, 1, true));
+    g.set_edge(edge_t(1, 3, 1, true));
+    g.remove_edge(edge_t(0, 2, true));
+    EXPECT_EQ(g.edge_count(), 6)
+    dists = g.shortest_path(4);
+    EXPECT_EQ(dists(1), 5)
+    EXPECT_EQ(dists(3), 6)
+    EXPECT_EQ(dists(2), 14)
+
+    cym::csr_graph empty(3);
+    empty.set_edge(edge_t(2, 1, 7, true));
+    EXPECT_EQ(empty.get_edge(2, 1).weight(), 7)
+    EXPECT_EQ(empty.shortest_path(2)(1), 7)
+}
+
+void test_csr_dijkstra() {
+    const size_t v_count = 300;
+    const std::vector<edge_t> edges = random_edges(v_count, 1500, 7);
+    cym::directed_graph dense(v_count);
+    for (const edge_t& e : edges) {
+        dense.set_edge(e);
+    }
+    // 重复的边在稠密图中以最后一次为准
+    cym::csr_graph sparse(v_count);
+    for (const edge_t& e : edges) {
+        sparse.set_edge(e);
+    }
+    for (const size_t from : {0, 17, 299}) {
+        const cym::vector_t expected = dense.shortest_path(from);
+        const cym::vector_t actual = sparse.shortest_path(from);
+        for (size_t v = 0; v < v_count; ++v) {
+            EXPECT_EQ(actual(v), expected(v))
+        }
+    }
+
+    cym::csr_graph built(v_count, edges.data(), edges.size(), 4);
+    const cym::vector_t a = built.shortest_path(5);
+    const cym::csr_graph copy(built);
+    const cym::vector_t b = copy.shortest_path(5);
+    for (size_t v = 0; v < v_count; ++v) {
+        EXPECT_EQ(a(v), b(v))
+    }
+}
+
+void test_floyd_warshall() {
+    const size_t v_count = 150;
+    std::vector<edge_t> edges = random_edges(v_count, 600, 11);
+    // 权值为0的边与其他边一样可以经过
+    for (size_t i = 0; i < edges.size(); i += 10) {
+        edges[i].set_weight(0);
+    }
+    cym::directed_graph g(v_count);
+    for (const edge_t& e : edges) {
+        g.set_edge(e);
+    }
+    g.remove_edge(edges[0]);
+    cym::matrix_t next({v_count, v_count});
+    const cym::matrix_t all = g.all_pairs_shortest_path(3, &next);
+    const cym::matrix_t single = g.shortest_path();
+    for (size_t from = 0; from < v_count; ++from) {
+        const cym::vector_t expected = g.shortest_path(from);
+        for (size_t to = 0; to < v_count; ++to) {
+            EXPECT_EQ(all(from, to), expected(to))
+            EXPECT_EQ(single(from, to), expected(to))
+            if (expected(to) == cym::graph::dist::infinity) {
+                EXPECT_EQ(next(from, to), -1)
+                continue;
+            }
+            // 沿next走到终点，路径上的权值之和等于最短路径长度
+            int len = 0;
+            for (size_t v = from; v != to;) {
+                const size_t u = next(v, to);
+                len += g.get_edge(v, u).weight();
+                v = u;
+            }
+            EXPECT_EQ(len, expected(to))
+        }
+    }
+
+    // 0 -> 1的权值为0：Dijkstra、Floyd–Warshall和csr_graph的结果相同
+    cym::directed_graph zero(3);
+    zero.set_edge(edge_t(0, 1, 0, true));
+    zero.set_edge(edge_t(1, 2, 5, true));
+    const std::vector<edge_t> zero_edges = {edge_t(0, 1, 0, true),
+                                            edge_t(1, 2, 5, true)};
+    cym::csr_graph zero_csr(3, zero_edges.data(), zero_edges.size());
+    EXPECT_EQ(zero.shortest_path(0)(2), 5)
+    EXPECT_EQ(zero.all_pairs_shortest_path()(0, 2), 5)
+    EXPECT_EQ(zero_csr.shortest_path(0)(2), 5)
+    EXPECT_EQ(zero.shortest_path(0)(1), 0)
+
+    // 权值为正的自环不改变顶点到自身的距离
+    zero.set_edge(edge_t(1, 1, 7, true));
+    EXPECT_EQ(zero.all_pairs_shortest_path()(1, 1), 0)
+    EXPECT_EQ(zero.shortest_path(1)(1), 0)
+
+    // 长度接近或超过2^30的路径：与Dijkstra的结果相同，不小于INT_MAX时不可达
+    cym::directed_graph heavy(4);
+    heavy.set_edge(edge_t(0, 1, 600000000, true));
+    heavy.set_edge(edge_t(1, 2, 600000000, true));
+    EXPECT_EQ(heavy.shortest_path(0)(2), 1200000000)
+    EXPECT_EQ(heavy.shortest_path()(0, 2), 1200000000)
+    heavy.set_edge(edge_t(2, 0, 1100000000, true));
+    heavy.set_edge(edge_t(2, 3, 2000000000, true));
+    EXPECT_EQ(heavy.shortest_path()(2, 0), 1100000000)
+    EXPECT_EQ(heavy.shortest_path()(1, 0), 1700000000)
+    EXPECT_EQ(heavy.shortest_path(0)(3), cym::graph::dist::infinity)
+    EXPECT_EQ(heavy.shortest_path()(0, 3), cym::graph::dist::infinity)
+    // 一条长链和少数重边，超过一个分块；第二个图只有一条重边，路径都很短
+    for (const int chain_weight : {40000000, 3}) {
+        const size_t n = 70;
+        cym::directed_graph chain(n);
+        for (size_t v = 0; v + 1 < n; ++v) {
+            chain.set_edge(edge_t(v, v + 1, chain_weight, true));
+        }
+        chain.set_edge(edge_t(0, 5, 1100000000, true));
+        chain.set_edge(edge_t(n - 1, 0, 30000000, true));
+        cym::matrix_t next({0, 0});
+        const cym::matrix_t apsp = chain.all_pairs_shortest_path(2, &next);
+        for (size_t from = 0; from < n; ++from) {
+            const cym::vector_t expected = chain.shortest_path(from);
+            for (size_t to = 0; to < n; ++to) {
+                EXPECT_EQ(apsp(from, to), expected(to))
+                if (expected(to) == cym::graph::dist::infinity) {
+                    EXPECT_EQ(next(from, to), -1)
+                    continue;
+                }
+                int64_t len = 0;
+                for (size_t v = from; v != to; v = next(v, to)) {
+                    len += chain.adjacency_matrix()(v, next(v, to));
+                }
+                EXPECT_EQ(len, expected(to))
+            }
+        }
+    }
+}
+
+void test_delta_stepping() {
+    const size_t v_count = 2000;
+    const std::vector<edge_t> edges = random_edges(v_count, 10000, 23);
+    cym::csr_graph g(v_count, edges.data(), edges.size());
+    const cym::vector_t expected = g.shortest_path(3);
+    for (const int delta : {0, 1, 40, 1000}) {
+        cym::vector_t pred({v_count});
+        const cym::vector_t actual = g.shortest_path(3, 4, delta, &pred);
+        for (size_t v = 0; v < v_count; ++v) {
+            EXPECT_EQ(actual(v), expected(v))
+            if (v == 3 || actual(v) == cym::graph::dist::infinity) {
+                EXPECT_EQ(pred(v), -1)
+            } else {
+                // 前驱的距离加上边权等于该顶点的距离
+                const int p = pred(v);
+                EXPECT_EQ(actual(p) + g.get_edge(p, v).weight(), actual(v))
+            }
+        }
+    }
+}
+
+void test_breadth_first_search() {
+    const size_t v_count = 3000;
+    std::vector<edge_t> edges = random_edges(v_count, 12000, 31);
+    for (edge_t& e : edges) {
+        e = edge_t(e.from(), e.to(), 1, true);
+    }
+    cym::csr_graph g(v_count, edges.data(), edges.size());
+    cym::csr_graph reverse = g.transpose(3);
+    const cym::csr_graph* reverses[] = {&reverse, nullptr};
+    EXPECT_EQ(reverse.edge_count(), g.edge_count())
+    EXPECT_EQ(reverse.get_edge(edges[0].to(), edges[0].from()).weight(), 1)
+    for (const size_t from : {0, 1234}) {
+        const cym::vector_t expected = g.shortest_path(from);
+        for (const unsigned threads : {1, 4}) {
+            // 不传入反向图时只使用自顶向下
+            for (const cym::csr_graph* r : reverses) {
+                cym::vector_t parents({v_count});
+                const cym::vector_t levels =
+                    g.breadth_first_search(from, threads, &parents, r);
+                for (size_t v = 0; v < v_count; ++v) {
+                    EXPECT_EQ(levels(v), expected(v))
+                    if (v == from || levels(v) == cym::graph::dist::infinity) {
+                        EXPECT_EQ(parents(v), -1)
+                    } else {
+                        // 父顶点在上一层，且有一条边指向该顶点
+                        const int p = parents(v);
+                        EXPECT_EQ(levels(p) + 1, levels(v))
+                        EXPECT_EQ(g.get_edge(p, v).weight(), 1)
+                    }
+                }
+            }
+        }
+    }
+}
+
+void test_union_find() {
+    cym::union_find sets(6);
+    EXPECT_EQ(sets.count(), 6)
+    EXPECT(sets.unite(0, 1))
+    EXPECT(sets.unite(2, 3))
+    EXPECT(sets.unite(1, 3))
+    EXPECT(!sets.unite(0, 2))
+    EXPECT_EQ(sets.count(), 3)
+    EXPECT(sets.same(0, 3))
+    EXPECT(!sets.same(0, 4))
+    EXPECT_EQ(sets.root(2), sets.find(0))
+    sets.reset();
+    EXPECT_EQ(sets.count(), 6)
+    EXPECT(!sets.same(0, 1))
+}
+
+void test_minimum_spanning_tree() {
+    // 0-1-2-3构成环，4单独一个分量
+    cym::directed_graph g(5);
+    g.set_edge(edge_t(0, 1, 4, true));
+    g.set_edge(edge_t(1, 2, 1, true));
+    g.set_edge(edge_t(2, 3, 2, true));
+    g.set_edge(edge_t(3, 0, 3, true));
+    g.set_edge(edge_t(0, 2, 5, true));
+    cym::directed_graph mst = g.minimum_spanning_tree(0);
+    EXPECT_EQ(mst.get_edge(1, 2).weight(), 1)
+    EXPECT_EQ(mst.get_edge(2, 3).weight(), 2)
+    EXPECT_EQ(mst.get_edge(3, 0).weight(), 3)
+    EXPECT_EQ(mst.get_edge(0, 1).weight(), -1)
+
+    // 权值范围较小，有大量相同的权值、重复的边和自环
+    const size_t v_count = 2000;
+    std::vector<edge_t> edges = random_edges(v_count, 6000, 41);
+    for (size_t i = 0; i < edges.size(); i += 7) {
+        edges[i] = edge_t(edges[i].from(), edges[i].from(), 1, false);
+    }
+    for (edge_t& e : edges) {
+        e = edge_t(e.from(), e.to(), e.weight() % 10 - 2, false);
+    }
+    cym::union_find components(v_count);
+    for (const edge_t& e : edges) {
+        components.unite(e.from(), e.to());
+    }
+    auto sorted = [](const cym::spanning_forest& forest) {
+        std::vector<std::tuple<unsigned, unsigned, int>> result;
+        for (size_t i = 0; i < forest.size(); ++i) {
+            result.emplace_back(forest[i].from(), forest[i].to(),
+                                forest[i].weight());
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    };
+    const cym::spanning_forest expected =
+        cym::kruskal(v_count, edges.data(), edges.size());
+    EXPECT_EQ(expected.size(), v_count - components.count())
+    for (const unsigned threads : {1, 4}) {
+        const cym::spanning_forest actual =
+            cym::boruvka(v_count, edges.data(), edges.size(), threads);
+        EXPECT_EQ(actual.weight(), expected.weight())
+        EXPECT(sorted(actual) == sorted(expected))
+    }
+}
+
+void test_path_search() {
+    const size_t v_count = 1500;
+    std::vector<edge_t> edges = random_edges(v_count, 4500, 53);
+    // 一条权值为负的边，各种查询都应当忽略它
+    edges.emplace_back(0, 1, -5, true);
+    cym::csr_graph g(v_count, edges.data(), edges.size());
+    const cym::csr_graph reverse = g.transpose();
+    const cym::landmark_heuristic alt(g, reverse, 4);
+    EXPECT_EQ(alt.count(), 4)
+    cym::path_search search(g, &reverse);
+
+    // 检查路径从`from`到`to`，每一步都是图中的边，权值之和等于`len`
+    auto check_path = [&](const size_t from, const size_t to, const int len) {
+        if (len == cym::graph::dist::infinity) {
+            EXPECT_EQ(search.path_size(), 0)
+            return;
+        }
+        const unsigned int* path = search.path();
+        EXPECT(search.path_size() > 0)
+        EXPECT_EQ(path[0], from)
+        EXPECT_EQ(path[search.path_size() - 1], to)
+        int sum = 0;
+        for (size_t i = 1; i < search.path_size(); ++i) {
+            const int weight = g.get_edge(path[i - 1], path[i]).weight();
+            EXPECT(weight >= 0)
+            sum += weight;
+        }
+        EXPECT_EQ(sum, len)
+    };
+
+    std::mt19937 gen(59);
+    for (int query = 0; query < 200; ++query) {
+        const size_t from = gen() % v_count;
+        const size_t to = query % 10 == 0 ? from : gen() % v_count;
+        const int expected = g.shortest_path(from)(to);
+        EXPECT(alt(from, to) <= expected)
+        int len = search.dijkstra(from, to);
+        EXPECT_EQ(len, expected)
+        check_path(from, to, len);
+        len = search.bidirectional(from, to);
+        EXPECT_EQ(len, expected)
+        check_path(from, to, len);
+        len = search.a_star(from, to, alt);
+        EXPECT_EQ(len, expected)
+        check_path(from, to, len);
+    }
+
+    // 没有反向图时双向搜索退化为单向
+    cym::path_search forward_only(g);
+    EXPECT_EQ(forward_only.bidirectional(3, 7), g.shortest_path(3)(7))
+}
+
+void test_contraction_hierarchy() {
+    const size_t v_count = 800;
+    std::vector<edge_t> edges = random_edges(v_count, 2400, 61);
+    // 一部分边是无向的
+    for (size_t i = 0; i < edges.size(); i += 3) {
+        edges[i].set_directed(false);
+    }
+    cym::csr_graph g(v_count, edges.data(), edges.size());
+    cym::contraction_hierarchy ch(g);
+    EXPECT_EQ(ch.vertex_count(), v_count)
+    EXPECT(ch.arc_count() >= g.edge_count())
+
+    const char* path = "test_contraction_hierarchy.bin";
+    EXPECT(ch.save(path))
+    cym::contraction_hierarchy loaded;
+    EXPECT(loaded.load(path))
+    EXPECT_EQ(loaded.arc_count(), ch.arc_count())
+    // 把一条向上的捷径的middle改为它的终点：索引在范围内，但无法展开
+    {
+        using cym::ch_detail::arc;
+        FILE* file = fopen(path, "rb");
+        std::vector<char> bytes;
+        char buffer[4096];
+        for (size_t n; (n = fread(buffer, 1, sizeof(buffer), file)) > 0;) {
+            bytes.insert(bytes.end(), buffer, buffer + n);
+        }
+        fclose(file);
+        const size_t up_begin = sizeof(cym::ch_detail::file_header) +
+                                v_count * sizeof(unsigned int) +
+                                2 * v_count * sizeof(uint32_t);
+        bool patched = false;
+        for (size_t at = up_begin; !patched && at + sizeof(arc) <= bytes.size();
+             at += sizeof(arc)) {
+            arc a;
+            memcpy(&a, bytes.data() + at, sizeof(arc));
+            if (a.middle != UINT32_MAX) {
+                a.middle = a.target;
+                memcpy(bytes.data() + at, &a, sizeof(arc));
+                patched = true;
+            }
+        }
+        EXPECT(patched)
+        file = fopen(path, "wb");
+        fwrite(bytes.data(), 1, bytes.size(), file);
+        fclose(file);
+        cym::contraction_hierarchy corrupt;
+        EXPECT(!corrupt.load(path))
+        EXPECT_EQ(corrupt.vertex_count(), 0)
+    }
+    remove(path);
+    // 读取失败时层次被清空
+    cym::contraction_hierarchy missing;
+    EXPECT(!missing.load(path))
+    EXPECT_EQ(missing.vertex_count(), 0)
+
+    std::mt19937 gen(67);
+    for (int query = 0; query < 300; ++query) {
+        const size_t from = gen() % v_count;
+        const size_t to = query % 20 == 0 ? from : gen() % v_count;
+        const int expected = g.shortest_path(from)(to);
+        cym::contraction_hierarchy& h = query % 2 == 0 ? ch : loaded;
+        EXPECT_EQ(h.query(from, to), expected)
+        if (expected == cym::graph::dist::infinity) {
+            EXPECT_EQ(h.path_size(), 0)
+            continue;
+        }
+        // 展开后的路径由原图中的边组成
+        const unsigned int* p = h.path();
+        EXPECT_EQ(p[0], from)
+        EXPECT_EQ(p[h.path_size() - 1], to)
+        int len = 0;
+        for (size_t i = 1; i < h.path_size(); ++i) {
+            len += g.get_edge(p[i - 1], p[i]).weight();
+        }
+        EXPECT_EQ(len, expected)
+    }
+}
+
+void test_dynamic_shortest_path() {
+    const size_t v_count = 600;
+    std::vector<edge_t> edges = random_edges(v_count, 2400, 71);
+    cym::csr_graph g(v_count, edges.data(), edges.size());
+    cym::dynamic_sssp sssp(g, 0);
+    // 与从头计算的结果不同的项数
+    auto mismatches = [](const int* a, const int* b, const size_t n) {
+        size_t count = 0;
+        for (size_t i = 0; i < n; ++i) {
+            count += a[i] != b[i];
+        }
+        return count;
+    };
+    EXPECT_EQ(mismatches(sssp.distances().data(), g.shortest_path(0).data(),
+                         v_count),
+              0)
+
+    cym::directed_graph dense(v_count);
+    for (const edge_t& e : edges) {
+        const int weight = dense.get_edge(e.from(), e.to()).weight();
+        if (e.from() != e.to() && (weight < 0 || e.weight() < weight)) {
+            dense.set_edge(e);
+        }
+    }
+    cym::dynamic_apsp apsp(dense, 2);
+
+    // 每批修改包含加长、缩短、删除和插入，批的大小逐渐增加
+    std::mt19937 gen(73);
+    for (size_t batch = 1; batch <= 64; batch *= 2) {
+        for (int round = 0; round < 3; ++round) {
+            for (size_t k = 0; k < batch; ++k) {
+                const unsigned from = gen() % v_count;
+                unsigned to = gen() % v_count;
+                if (to == from) {
+                    to = (to + 1) % v_count;
+                }
+                const int choice = gen() % 4;
+                if (choice == 0) {
+                    sssp.remove_edge(edge_t(from, to, 0, true));
+                    apsp.remove_edge(edge_t(from, to, 0, true));
+                    continue;
+                }
+                // 修改最短路径树上的边才能触发子树的修复
+                if (choice == 1 && sssp.predecessor(to) >= 0) {
+                    const unsigned pre = sssp.predecessor(to);
+                    const edge_t e(pre, to, 100 + gen() % 100, true);
+                    sssp.set_edge(e);
+                    apsp.set_edge(e);
+                    continue;
+                }
+                const edge_t e(from, to, 1 + gen() % 100, true);
+                sssp.set_edge(e);
+                apsp.set_edge(e);
+            }
+            EXPECT(sssp.pending() > 0)
+            EXPECT_EQ(mismatches(sssp.distances().data(),
+                                 sssp.shortest_path(0).data(), v_count),
+                      0)
+            EXPECT_EQ(sssp.pending(), 0)
+            EXPECT_EQ(mismatches(apsp.distances().data(),
+                                 apsp.all_pairs_shortest_path().data(),
+                                 v_count * v_count),
+                      0)
+            EXPECT_EQ(apsp.pending(), 0)
+        }
+    }
+    // 前驱链的长度之和等于距离
+    for (size_t v = 0; v < v_count; v += 7) {
+        const int len = sssp.distance(v);
+        if (len == cym::graph::dist::infinity) {
+            EXPECT_EQ(sssp.predecessor(v), -1)
+            continue;
+        }
+        int sum = 0;
+        for (size_t u = v; sssp.predecessor(u) >= 0;
+             u = sssp.predecessor(u)) {
+            sum += sssp.get_edge(sssp.predecessor(u), u).weight();
+        }
+        EXPECT_EQ(sum, len)
+    }
+}
+
+void test_undirected_graph() {
+    // 两个三角形0-1-2和2-3-4共享割点2，4-5是桥，6有自环，7孤立
+    const edge_t edges[] = {{0, 1, 1, true}, {1, 2, 1, true}, {2, 0, 1, true},
+                            {2, 3, 1, true}, {3, 4, 1, true}, {4, 2, 1, true},
+                            {4, 5, 1, true}, {6, 6, 1, true}, {1, 0, 3, true}};
+    cym::undirected_graph g(8, edges, 9);
+    EXPECT_EQ(g.edge_count(), 8)
+    EXPECT_EQ(g.arc_count(), 15)
+    EXPECT_EQ(g.get_edge(1, 0).weight(), 1)
+    EXPECT_EQ(g.get_edge(5, 4).weight(), 1)
+
+    size_t count = 0;
+    cym::vector_t labels = g.connected_components(&count);
+    EXPECT_EQ(count, 3)
+    EXPECT_EQ(labels(5), 0)
+    EXPECT_EQ(labels(6), 6)
+    EXPECT_EQ(labels(7), 7)
+
+    cym::vector_t cut({1});
+    const cym::vector_t bcc = g.biconnected_components(&count, &cut);
+    EXPECT_EQ(count, 3)
+    for (size_t v = 0; v < 8; ++v) {
+        EXPECT_EQ(cut(v), v == 2 || v == 4)
+    }
+    const size_t* offsets = g.offsets();
+    const unsigned int* targets = g.targets();
+    auto arc = [&](const size_t u, const size_t v) {
+        for (size_t k = offsets[u]; k < offsets[u + 1]; ++k) {
+            if (targets[k] == v) {
+                return k;
+            }
+        }
+        return g.arc_count();
+    };
+    EXPECT_EQ(bcc(arc(0, 1)), bcc(arc(2, 0)))
+    EXPECT_EQ(bcc(arc(1, 0)), bcc(arc(0, 1)))
+    EXPECT(bcc(arc(0, 1)) != bcc(arc(3, 4)))
+    EXPECT_EQ(bcc(arc(6, 6)), -1)
+    const cym::vector_t bridge = g.bridges(&count);
+    EXPECT_EQ(count, 1)
+    EXPECT_EQ(bridge(arc(4, 5)), 1)
+    EXPECT_EQ(bridge(arc(5, 4)), 1)
+
+    g.remove_edge(edge_t(4, 5, true));
+    g.set_edge(edge_t(7, 7, 2, true));
+    g.set_edge(edge_t(5, 7, 2, true));
+    EXPECT_EQ(g.edge_count(), 9)
+    EXPECT_EQ(g.get_edge(7, 5).weight(), 2)
+    g.connected_components(&count);
+    EXPECT_EQ(count, 3)
+
+    // 随机图：两种连通分量算法的结果相同；删去一条桥会增加一个分量，
+    // 删去非桥的边则不会
+    const size_t v_count = 3000;
+    const std::vector<edge_t> random = random_edges(v_count, 3300, 79);
+    cym::undirected_graph r(v_count, random.data(), random.size(), 2);
+    const cym::vector_t expected = r.connected_components(&count);
+    for (const unsigned threads : {1, 4}) {
+        size_t afforest_count = 0;
+        const cym::vector_t actual =
+            r.connected_components(threads, &afforest_count);
+        EXPECT_EQ(afforest_count, count)
+        for (size_t v = 0; v < v_count; ++v) {
+            EXPECT_EQ(actual(v), expected(v))
+        }
+    }
+    const cym::vector_t flags = r.bridges();
+    std::mt19937 gen(83);
+    for (int trial = 0; trial < 20; ++trial) {
+        const size_t k = gen() % r.arc_count();
+        size_t u = 0;
+        while (r.offsets()[u + 1] <= k) {
+            u++;
+        }
+        cym::undirected_graph copy(r);
+        copy.remove_edge(edge_t(u, r.targets()[k], true));
+        size_t after = 0;
+        copy.connected_components(&after);
+        EXPECT_EQ(after, count + flags(k))
+    }
+}
+
+void test_strong_components() {
+    // 两个分量的编号相同当且仅当两个顶点互相可达，用Floyd–Warshall的结果检查
+    const size_t v_count = 400;
+    std::vector<edge_t> edges = random_edges(v_count, 520, 89);
+    edges.emplace_back(7, 7, 1, true);
+    cym::csr_graph sparse(v_count, edges.data(), edges.size());
+    cym::directed_graph dense(v_count);
+    for (const edge_t& e : edges) {
+        dense.set_edge(e);
+    }
+    const cym::matrix_t reach = dense.all_pairs_shortest_path();
+    size_t count = 0;
+    const cym::vector_t labels =
+        cym::strongly_connected_components(sparse, &count);
+    size_t expected_count = 0;
+    for (size_t u = 0; u < v_count; ++u) {
+        bool first = true;
+        for (size_t v = 0; v < v_count; ++v) {
+            const bool strong = reach(u, v) != cym::graph::dist::infinity &&
+                                reach(v, u) != cym::graph::dist::infinity;
+            EXPECT_EQ(labels(u) == labels(v), strong)
+            first = first && !(strong && v < u);
+        }
+        expected_count += first;
+    }
+    EXPECT_EQ(count, expected_count)
+    // 编号是缩点图的拓扑序
+    for (const edge_t& e : edges) {
+        EXPECT(labels(e.from()) <= labels(e.to()))
+    }
+
+    // 其他实现给出相同的划分：a(u) == a(v)当且仅当b(u) == b(v)
+    auto same_partition = [&](const cym::vector_t& a, const cym::vector_t& b) {
+        std::vector<int> map(v_count, -1);
+        for (size_t v = 0; v < v_count; ++v) {
+            if (map[a(v)] < 0) {
+                map[a(v)] = b(v);
+            } else if (map[a(v)] != b(v)) {
+                return false;
+            }
+        }
+        return true;
+    };
+    size_t other = 0;
+    EXPECT(same_partition(labels,
+                          cym::strongly_connected_components(dense, &other)))
+    EXPECT_EQ(other, count)
+    for (const unsigned threads : {1, 4}) {
+        const cym::vector_t a =
+            cym::forward_backward_scc(sparse, threads, &other);
+        EXPECT_EQ(other, count)
+        EXPECT(same_partition(labels, a) && same_partition(a, labels))
+        const cym::vector_t b = cym::forward_backward_scc(dense, threads);
+        EXPECT(same_partition(labels, b) && same_partition(b, labels))
+    }
+
+    // 有环时返回的环由图中的边组成
+    cym::vector_t order({1});
+    cym::vector_t cycle({1});
+    EXPECT(!cym::topological_sort(sparse, order, &cycle))
+    EXPECT(!cym::topological_sort(dense, order))
+    for (size_t i = 0; i < cycle.storage_size(); ++i) {
+        const size_t u = cycle(i);
+        const size_t v = cycle((i + 1) % cycle.storage_size());
+        EXPECT(sparse.get_edge(u, v).weight() > 0)
+    }
+
+    // 只保留从小编号指向大编号的边得到无环图，拓扑序中每条边都从前指向后
+    std::vector<edge_t> acyclic;
+    for (const edge_t& e : edges) {
+        if (e.from() < e.to()) {
+            acyclic.push_back(e);
+        }
+    }
+    cym::csr_graph dag(v_count, acyclic.data(), acyclic.size());
+    EXPECT(cym::topological_sort(dag, order))
+    std::vector<size_t> position(v_count);
+    for (size_t i = 0; i < v_count; ++i) {
+        position[order(i)] = i;
+    }
+    for (const edge_t& e : acyclic) {
+        EXPECT(position[e.from()] < position[e.to()])
+    }
+
+    // 一百万个顶点的长链和大环，递归实现会栈溢出
+    const size_t long_count = 1000000;
+    std::vector<edge_t> chain;
+    for (size_t v = 0; v + 1 < long_count; ++v) {
+        chain.emplace_back(v, v + 1, 1, true);
+    }
+    cym::csr_graph path(long_count, chain.data(), chain.size());
+    cym::strongly_connected_components(path, &count);
+    EXPECT_EQ(count, long_count)
+    EXPECT(cym::topological_sort(path, order))
+    EXPECT_EQ(order(long_count - 1), static_cast<int>(long_count - 1))
+    chain.emplace_back(long_count - 1, 0, 1, true);
+    cym::csr_graph ring(long_count, chain.data(), chain.size());
+    cym::strongly_connected_components(ring, &count);
+    EXPECT_EQ(count, 1)
+    cym::forward_backward_scc(ring, 2, &count);
+    EXPECT_EQ(count, 1)
+    EXPECT(!cym::topological_sort(ring, order, &cycle))
+    EXPECT_EQ(cycle.storage_size(), long_count)
+}
+
+void test_multi_source_bfs() {
+    // 稀疏的随机图，有不少不可达的顶点对；与单源的广度优先搜索逐个比较
+    const size_t v_count = 1500;
+    const std::vector<edge_t> edges = random_edges(v_count, 2400, 97);
+    cym::csr_graph g(v_count, edges.data(), edges.size());
+    std::vector<unsigned int> sources;
+    for (size_t i = 0; i < 200; ++i) {
+        sources.push_back(static_cast<unsigned int>(i * 7 % v_count));
+    }
+    sources[5] = sources[3];
+    auto check = [&](auto& bfs, const size_t count) {
+        cym::matrix_t distances({0, 0});
+        EXPECT(bfs.run(sources.data(), count, &distances))
+        EXPECT_EQ(bfs.source_count(), count)
+        unsigned int levels = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const cym::vector_t expected = g.breadth_first_search(sources[i], 1);
+            size_t reached = 0;
+            uint64_t sum = 0;
+            for (size_t v = 0; v < v_count; ++v) {
+                EXPECT_EQ(distances(i, v), expected(v))
+                if (expected(v) != cym::graph::dist::infinity) {
+                    ++reached;
+                    sum += expected(v);
+                    levels = std::max(levels, unsigned(expected(v)));
+                }
+            }
+            EXPECT_EQ(bfs.reached(i), reached)
+            EXPECT_EQ(bfs.distance_sum(i), sum)
+            const double closeness =
+                sum == 0 ? 0.0
+                         : double(reached - 1) / (v_count - 1) *
+                               double(reached - 1) / double(sum);
+            EXPECT(std::abs(bfs.closeness(i) - closeness) < 1e-12)
+        }
+        EXPECT_EQ(bfs.levels(), levels)
+    };
+    cym::multi_source_bfs<64> narrow(g);
+    EXPECT(!narrow.run(sources.data(), 65))
+    check(narrow, 64);
+    check(narrow, 10);
+    cym::multi_source_bfs<256> wide(g);
+    check(wide, sources.size());
+    const unsigned int missing = v_count;
+    EXPECT(!wide.run(&missing, 1))
+    EXPECT(wide.run(sources.data(), 0))
+    EXPECT_EQ(wide.levels(), 0)
+
+    // 所有顶点的接近中心性，单线程与多线程的结果相同
+    cym::vector_t reached({0});
+    const auto all = cym::closeness_centrality<128>(g, 1, &reached);
+    const auto parallel = cym::closeness_centrality<512>(g, 3);
+    for (const size_t v : {0, 77, 1499}) {
+        const cym::vector_t expected = g.breadth_first_search(v, 1);
+        size_t count = 0;
+        for (size_t u = 0; u < v_count; ++u) {
+            count += expected(u) != cym::graph::dist::infinity;
+        }
+        EXPECT_EQ(reached(v), static_cast<int>(count))
+    }
+    for (size_t v = 0; v < v_count; ++v) {
+        EXPECT(std::abs(all(v) - parallel(v)) < 1e-12)
+    }
+}
+
+TEST_MAIN(test_csr_graph(); test_csr_dijkstra(); test_floyd_warshall();
+          test_delta_stepping(); test_breadth_first_search(); test_union_find();
+          test_minimum_spanning_tree(); test_path_search();
+          test_contraction_hierarchy(); test_dynamic_shortest_path();
+          test_undirected_graph(); test_strong_components();
+          test_multi_source_bfs();)
@@ -0,0 +1,353 @@
+#include "../matrix.h"
+#include "../md_expression.h"
+#include "../md_mapped.h"
+#include "../md_view.h"
+#include "../multi_dimension_array.h"
+#include "test_common.h"
+#include <climits>
+#include <cstdio>
+#include <limits>
+#include <type_traits>
+
+void test_indexing() {
+    cym::static_multi_dimension_array<int, 3> arr({2, 3, 4});
+    EXPECT_EQ(arr.size(), 24)
+    EXPECT_EQ(arr.stride(0), 12)
+    EXPECT_EQ(arr.stride(1), 4)
+    for (size_t i = 0; i < 2; ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            for (size_t k = 0; k < 4; ++k) {
+                arr(i, j, k) = static_cast<int>(i * 100 + j * 10 + k);
+            }
+        }
+    }
+    // 行优先，每个元素的位置都不同
+    for (size_t i = 0; i < arr.size(); ++i) {
+        const int val = arr.data()[i];
+        EXPECT_EQ(static_cast<size_t>(val / 100 * 12 + val / 10 % 10 * 4 +
+                                      val % 10),
+                  i)
+    }
+    EXPECT_EQ(arr.visit({1, 2, 3}), 123)
+
+    cym::static_multi_dimension_array<int, 3> copy(arr);
+    copy(0, 0, 0) = -1;
+    EXPECT_EQ(arr(0, 0, 0), 0)
+    arr = std::move(copy);
+    EXPECT_EQ(arr(0, 0, 0), -1)
+}
+
+void test_md_array() {
+    cym::md_array<int, 3, 5> arr(7);
+    static_assert(cym::md_array<int, 3, 5>::stride(0) == 5, "");
+    EXPECT_EQ(arr.size(), 15)
+    arr(2, 4) = 1;
+    EXPECT_EQ(arr.data()[14], 1)
+    EXPECT_EQ(arr(0, 0), 7)
+}
+
+template <typename Layout>
+void check_layout(const size_t rows, const size_t cols) {
+    cym::static_multi_dimension_array<int, 2> arr({rows, cols});
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t j = 0; j < cols; ++j) {
+            arr(i, j) = static_cast<int>(i * cols + j);
+        }
+    }
+    cym::static_multi_dimension_array<int, 2, Layout> converted(arr);
+    size_t count = 0;
+    const int* last = nullptr;
+    converted.for_each([&](const int& val, const size_t (&loc)[2]) {
+        EXPECT_EQ(val, static_cast<int>(loc[0] * cols + loc[1]))
+        // 按存储顺序遍历
+        EXPECT(last == nullptr || &val > last)
+        last = &val;
+        count++;
+    });
+    EXPECT_EQ(count, rows * cols)
+    EXPECT_GEQ(converted.storage_size(), converted.size())
+
+    cym::static_multi_dimension_array<int, 2, cym::column_major> back(
+        converted);
+    EXPECT_EQ(back(rows - 1, cols - 1), static_cast<int>(rows * cols - 1))
+}
+
+void test_layouts() {
+    check_layout<cym::row_major>(13, 7);
+    check_layout<cym::column_major>(13, 7);
+    check_layout<cym::tiled<4>>(13, 7);
+    check_layout<cym::morton>(13, 7);
+    check_layout<cym::morton>(5, 70);
+}
+
+void test_view() {
+    cym::static_multi_dimension_array<int, 2> arr({5, 7});
+    for (size_t i = 0; i < 5; ++i) {
+        for (size_t j = 0; j < 7; ++j) {
+            arr(i, j) = static_cast<int>(i * 10 + j);
+        }
+    }
+    cym::md_view<int, 2> view(arr);
+    EXPECT(view.is_contiguous())
+    EXPECT_EQ(view.row(3)(4), 34)
+    EXPECT_EQ(view.col(2)(4), 42)
+    EXPECT_EQ(view.transpose()(6, 1), 16)
+
+    cym::md_view<int, 2> block = view.subblock({1, 2}, {3, 4});
+    EXPECT(!block.is_contiguous())
+    int expected[] = {12, 13, 14, 15, 22, 23, 24, 25, 32, 33, 34, 35};
+    size_t count = 0;
+    for (int& val : block) {
+        EXPECT_EQ(val, expected[count])
+        val = -1;
+        count++;
+    }
+    EXPECT_EQ(count, 12)
+    // 视图不复制元素
+    EXPECT_EQ(arr(3, 5), -1)
+
+    cym::md_view<const int, 2> readonly = view.transpose();
+    int sum = 0;
+    readonly.for_each([&](const int& val, const size_t (&)[2]) { sum += val; });
+    // 原来的总和为805，子块中和为282的12个元素被改为-1
+    EXPECT_EQ(sum, 805 - 282 - 12)
+}
+
+void test_expression() {
+    const size_t rows = 100;
+    const size_t cols = 37;
+    cym::static_multi_dimension_array<int, 2> a({rows, cols});
+    cym::static_multi_dimension_array<int, 2> b({rows, cols}, 3);
+    cym::static_multi_dimension_array<int, 2> c({rows, cols});
+    for (size_t i = 0; i < a.size(); ++i) {
+        a.data()[i] = static_cast<int>(i % 50) - 20;
+    }
+    c = cym::clamp(a + 2 * b, 0, 25) - -b;
+    for (size_t i = 0; i < c.size(); ++i) {
+        int expected = a.data()[i] + 6;
+        expected = expected < 0 ? 0 : expected > 25 ? 25 : expected;
+        EXPECT_EQ(c.data()[i], expected + 3)
+    }
+    EXPECT(c.assign(cym::max(a, b), 2))
+    EXPECT_EQ(c(0, 0), 3)
+
+    EXPECT_EQ(cym::sum(b), static_cast<int64_t>(3 * rows * cols))
+    EXPECT_EQ(cym::min_value(a), -20)
+    EXPECT_EQ(cym::max_value(a - b), 26)
+    EXPECT_EQ(cym::argmin(a), 0)
+    EXPECT_EQ(cym::argmax(a * b), 49)
+
+    cym::static_multi_dimension_array<int, 2> other({rows, cols + 1});
+    EXPECT(!other.assign(a + b))
+
+    // 大小不同的操作数：赋值失败，归约视为空表达式，都不读取越界的元素
+    cym::static_multi_dimension_array<int, 1> ten({10}, 1);
+    cym::static_multi_dimension_array<int, 1> five({5}, 2);
+    cym::static_multi_dimension_array<int, 1> out({10}, 7);
+    EXPECT_EQ((ten + five).size(), cym::size_mismatch)
+    EXPECT_EQ((2 * ten + 1 - five).size(), cym::size_mismatch)
+    EXPECT_EQ((ten + 1).size(), 10)
+    EXPECT(!out.assign(ten + five))
+    EXPECT(!out.assign(five * ten, 2))
+    EXPECT_EQ(out(9), 7)
+    EXPECT_EQ(cym::sum(ten - five), 0)
+    EXPECT_EQ(cym::min_value(ten + five), INT_MAX)
+    EXPECT_EQ(cym::argmax(five + ten), cym::size_mismatch)
+
+    // 存储大小相同但各维长度不同
+    cym::static_multi_dimension_array<int, 2> wide({2, 3}, 1);
+    cym::static_multi_dimension_array<int, 2> tall({3, 2}, 1);
+    EXPECT_EQ((wide + tall).size(), cym::size_mismatch)
+    EXPECT(!wide.assign(tall * 2))
+
+    // 分块布局只计算真实的元素：除数补齐的部分为0，不参与运算
+    using tiled_t = cym::static_multi_dimension_array<int, 2, cym::tiled<64>>;
+    tiled_t num({rows, cols}, 0);
+    tiled_t den({rows, cols}, 0);
+    tiled_t quot({rows, cols}, -1);
+    num.for_each([](int& val, const size_t (&loc)[2]) {
+        val = static_cast<int>(loc[0] * 7 + loc[1]);
+    });
+    den.for_each([](int& val, const size_t (&loc)[2]) {
+        val = static_cast<int>(loc[1] % 5 + 1);
+    });
+    EXPECT(quot.assign(num / den + 1, 2))
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t j = 0; j < cols; ++j) {
+            const size_t expected = (i * 7 + j) / (j % 5 + 1) + 1;
+            EXPECT_EQ(quot(i, j), static_cast<int>(expected))
+        }
+    }
+    EXPECT_EQ(quot.data()[quot.storage_size() - 1], -1)
+    // 补齐后存储大小相同的分块数组
+    tiled_t column({64, 1}, 1);
+    tiled_t row({1, 64}, 1);
+    tiled_t small({3, 5}, 4);
+    EXPECT_EQ(column.storage_size(), small.storage_size())
+    EXPECT_EQ((column + row).size(), cym::size_mismatch)
+    EXPECT(!small.assign(column + row))
+    EXPECT(!small.assign(column * 2))
+    EXPECT_EQ(small(2, 4), 4)
+
+    // 整数标量可以用于浮点数组
+    cym::static_multi_dimension_array<double, 1> d({10}, 1.0);
+    d = d * 3 + 0.5f;
+    EXPECT_EQ(d(4), 3.5)
+}
+
+void test_matrix() {
+    const size_t m = 37;
+    const size_t n = 41;
+    const size_t k = 300;
+    cym::static_multi_dimension_array<double, 2> a({m, k});
+    cym::static_multi_dimension_array<double, 2> b({k, n});
+    cym::static_multi_dimension_array<double, 2> c({m, n});
+    for (size_t i = 0; i < a.size(); ++i) {
+        a.data()[i] = static_cast<double>(i % 7) - 3;
+    }
+    for (size_t i = 0; i < b.size(); ++i) {
+        b.data()[i] = static_cast<double>(i % 5) - 2;
+    }
+    EXPECT(cym::gemm(a, b, c, 2))
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            double expected = 0;
+            for (size_t p = 0; p < k; ++p) {
+                expected += a(i, p) * b(p, j);
+            }
+            EXPECT(c(i, j) == expected)
+        }
+    }
+    EXPECT(!cym::gemm(b, a, c))
+
+    // 0 -> 1 -> 2 -> 3 的链，平方两次得到所有最短路径
+    const int inf = INT_MAX;
+    const size_t v = 4;
+    cym::static_multi_dimension_array<int, 2> dist({v, v}, inf);
+    cym::static_multi_dimension_array<int, 2> tmp({v, v});
+    for (size_t i = 0; i < v; ++i) {
+        dist(i, i) = 0;
+    }
+    dist(0, 1) = 5;
+    dist(1, 2) = -2;
+    dist(2, 3) = 4;
+    EXPECT(cym::min_plus(dist, dist, tmp))
+    EXPECT(cym::min_plus(tmp, tmp, dist))
+    EXPECT_EQ(dist(0, 3), 7)
+    EXPECT_EQ(dist(1, 3), 2)
+    EXPECT_EQ(dist(3, 0), inf)
+
+    // int32的有限值超出±2^29时会被截断，直接拒绝
+    dist(0, 1) = 1 << 29;
+    EXPECT(!cym::min_plus(dist, dist, tmp))
+    dist(0, 1) = -(1 << 29);
+    EXPECT(!cym::min_plus(dist, tmp, tmp))
+    dist(0, 1) = (1 << 29) - 1;
+    EXPECT(cym::min_plus(dist, dist, tmp))
+}
+
+/**
+ * 与朴素实现比较int32/float的gemm和float的min_plus。m、n不是微内核的倍数，
+ * k超过一个kc块，覆盖各个方向上不完整的块。
+ */
+template <typename T>
+void check_matrix_edges() {
+    const size_t m = 37;
+    const size_t n = 45;
+    const size_t k = 513;
+    cym::static_multi_dimension_array<T, 2> a({m, k});
+    cym::static_multi_dimension_array<T, 2> b({k, n});
+    cym::static_multi_dimension_array<T, 2> c({m, n});
+    for (size_t i = 0; i < a.size(); ++i) {
+        a.data()[i] = static_cast<T>(static_cast<int>(i * 7 % 11) - 5);
+    }
+    for (size_t i = 0; i < b.size(); ++i) {
+        b.data()[i] = static_cast<T>(static_cast<int>(i * 5 % 9) - 4);
+    }
+    for (const unsigned threads : {1, 3}) {
+        EXPECT(cym::gemm(a, b, c, threads))
+        for (size_t i = 0; i < m; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                T expected = 0;
+                for (size_t p = 0; p < k; ++p) {
+                    expected += a(i, p) * b(p, j);
+                }
+                EXPECT(c(i, j) == expected)
+            }
+        }
+        if constexpr (std::is_floating_point<T>::value) {
+            a(3, 100) = std::numeric_limits<T>::infinity();
+            EXPECT(cym::min_plus(a, b, c, threads))
+            for (size_t i = 0; i < m; ++i) {
+                for (size_t j = 0; j < n; ++j) {
+                    T expected = std::numeric_limits<T>::infinity();
+                    for (size_t p = 0; p < k; ++p) {
+                        const T d = a(i, p) + b(p, j);
+                        expected = d < expected ? d : expected;
+                    }
+                    EXPECT(c(i, j) == expected)
+                }
+            }
+            a(3, 100) = 0;
+        }
+    }
+}
+
+void test_matrix_edges() {
+    check_matrix_edges<int>();
+    check_matrix_edges<float>();
+}
+
+void test_mapped() {
+    const char* path = "test_mapped_array.bin";
+    {
+        cym::mapped_multi_dimension_array<int, 2> arr;
+        EXPECT(arr.create(path, {300, 500}))
+        EXPECT_EQ(arr(299, 499), 0)
+        EXPECT(arr.advise(cym::map_advice::sequential))
+        arr.for_each([](int& val, const size_t (&loc)[2]) {
+            val = static_cast<int>(loc[0] * 1000 + loc[1]);
+        });
+        EXPECT(arr.sync())
+    }
+    cym::mapped_multi_dimension_array<int, 2> arr;
+    EXPECT(arr.open(path))
+    EXPECT_EQ(arr.extent(0), 300)
+    EXPECT_EQ(arr.extent(1), 500)
+    EXPECT_EQ(arr(123, 456), 123456)
+    EXPECT_EQ(cym::max_value(arr), 299499)
+    EXPECT(arr.advise(cym::map_advice::will_need, 500 * 100, 500))
+    cym::md_view<const int, 2> row = arr.view().subblock({7, 0}, {1, 500});
+    EXPECT_EQ(row(0, 3), 7003)
+
+    // 元素类型或布局不同的文件不能打开
+    cym::mapped_multi_dimension_array<float, 2> wrong_type;
+    EXPECT(!wrong_type.open(path))
+    cym::mapped_multi_dimension_array<int, 2, cym::column_major> wrong_layout;
+    EXPECT(!wrong_layout.open(path))
+
+    cym::mapped_multi_dimension_array<int, 2> writable;
+    EXPECT(writable.open(path, cym::map_mode::read_write))
+    EXPECT(writable.assign(arr - 1))
+    EXPECT_EQ(arr(0, 1), 0)
+    arr.close();
+    writable.close();
+
+    // 文件头中的长度为0或乘积溢出时不能打开
+    const long extents_at = sizeof(cym::mapped_detail::file_header);
+    for (const uint64_t extent : {uint64_t(0), uint64_t(1) << 32}) {
+        FILE* file = fopen(path, "r+b");
+        fseek(file, extents_at, SEEK_SET);
+        fwrite(&extent, sizeof(extent), 1, file);
+        fwrite(&extent, sizeof(extent), 1, file);
+        fclose(file);
+        cym::mapped_multi_dimension_array<int, 2> corrupt;
+        EXPECT(!corrupt.open(path))
+        EXPECT(!corrupt.is_open())
+    }
+    remove(path);
+}
+
+TEST_MAIN(test_indexing(); test_md_array(); test_layouts(); test_view();
+          test_expression(); test_matrix(); test_matrix_edges();
+          test_mapped();)
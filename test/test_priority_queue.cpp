@@ -0,0 +1,99 @@
+#include "../concurrent_priority_queue.h"
+#include "../heap.h"
+#include "test_common.h"
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+void test_heap() {
+    // 超过`vlarray`初始容量10个元素，覆盖扩容
+    std::mt19937 rng(5);
+    std::vector<int> values(1000);
+    for (int& x : values) {
+        x = static_cast<int>(rng() % 300);
+    }
+    cym::heap<int> min_heap(values.data(), values.size(), cym::heap_type::min);
+    cym::heap<int> max_heap(cym::heap_type::max);
+    for (const int x : values) {
+        max_heap.insert(x);
+    }
+    EXPECT_EQ(min_heap.size(), values.size())
+    std::vector<int> sorted = values;
+    std::sort(sorted.begin(), sorted.end());
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        EXPECT_EQ(min_heap.top(), sorted[i])
+        EXPECT_EQ(max_heap.top(), sorted[sorted.size() - 1 - i])
+        min_heap.delete_top();
+        max_heap.delete_top();
+    }
+    EXPECT(min_heap.empty())
+    EXPECT(max_heap.empty())
+    min_heap.delete_top();
+    EXPECT_EQ(min_heap.size(), 0)
+}
+
+void test_priority_queue() {
+    // 严格模式下出队顺序与排序结果相同
+    cym::concurrent_priority_queue<int> strict(cym::heap_type::min, 4);
+    strict.set_strict(true);
+    std::vector<int> values;
+    for (int i = 0; i < 500; ++i) {
+        values.push_back((i * 37) % 500);
+        strict.push(values.back());
+    }
+    EXPECT_EQ(strict.size(), values.size())
+    std::sort(values.begin(), values.end());
+    int out = -1;
+    for (const int x : values) {
+        EXPECT(strict.pop(out))
+        EXPECT_EQ(out, x)
+    }
+    EXPECT(!strict.pop(out))
+    EXPECT(strict.empty())
+
+    // 多个线程同时入队和出队，每个元素恰好出队一次
+    const int threads = 4;
+    const int per_thread = 5000;
+    cym::concurrent_priority_queue<int> queue(cym::heap_type::max, threads);
+    std::vector<std::vector<int>> popped(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            for (int i = 0; i < per_thread; ++i) {
+                queue.push(t * per_thread + i);
+                int x;
+                if (i % 2 == 1 && queue.pop(x)) {
+                    popped[t].push_back(x);
+                }
+            }
+        });
+    }
+    for (std::thread& w : workers) {
+        w.join();
+    }
+    workers.clear();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            int x;
+            while (queue.pop(x)) {
+                popped[t].push_back(x);
+            }
+        });
+    }
+    for (std::thread& w : workers) {
+        w.join();
+    }
+    EXPECT(queue.empty())
+    std::vector<int> all;
+    for (const std::vector<int>& p : popped) {
+        all.insert(all.end(), p.begin(), p.end());
+    }
+    std::sort(all.begin(), all.end());
+    EXPECT_EQ(all.size(), static_cast<size_t>(threads * per_thread))
+    for (size_t i = 0; i < all.size(); ++i) {
+        EXPECT_EQ(all[i], static_cast<int>(i))
+    }
+}
+
+TEST_MAIN(test_heap(); test_priority_queue();)
@@ -0,0 +1,257 @@
+#include "../algorithm.h"
+#include "test_common.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+template <typename T, typename Compare>
+bool is_sorted(const T arr[], const size_t size, Compare comp) {
+    for (size_t i = 1; i < size; ++i) {
+        if (comp(arr[i], arr[i - 1])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void test_pdq_sort() {
+    const size_t size = 10000;
+    int* arr = new int[size];
+    const int ranges[] = {4, 100, 1 << 30};
+    for (const int range : ranges) {
+        for (size_t i = 0; i < size; ++i) {
+            arr[i] = rand() % range;
+        }
+        cym::sort::pdq_sort(arr, arr + size);
+        EXPECT(is_sorted(arr, size, cym::less()))
+        cym::sort::pdq_sort(arr, arr + size, cym::greater());
+        EXPECT(is_sorted(arr, size, cym::greater()))
+    }
+
+    // organ pipe
+    for (size_t i = 0; i < size; ++i) {
+        arr[i] = static_cast<int>(i < size / 2 ? i : size - i);
+    }
+    cym::sort::pdq_sort(arr, arr + size);
+    EXPECT(is_sorted(arr, size, cym::less()))
+
+    int small[] = {3, 1, 2};
+    cym::sort::quick_sort(small, 0, 2);
+    EXPECT_EQ(small[0], 1)
+    EXPECT_EQ(small[2], 3)
+    delete[] arr;
+}
+
+void test_parallel_sort() {
+    const size_t size = 200000;
+    int* arr = new int[size];
+    for (size_t i = 0; i < size; ++i) {
+        arr[i] = rand();
+    }
+    cym::sort::parallel_sort(arr, size, 4);
+    EXPECT(is_sorted(arr, size, cym::less()))
+
+    // 只比较高位，低位记录原始顺序，用于检查稳定性
+    for (size_t i = 0; i < size; ++i) {
+        arr[i] = (rand() % 64) << 20 | static_cast<int>(i);
+    }
+    cym::sort::parallel_stable_sort(arr, size, 4, [](int a, int b) {
+        return (a >> 20) < (b >> 20);
+    });
+    EXPECT(is_sorted(arr, size, cym::less()))
+    delete[] arr;
+}
+
+void test_radix_sort() {
+    const size_t size = 5000;
+    int* arr = new int[size];
+    double* values = new double[size];
+    for (size_t i = 0; i < size; ++i) {
+        arr[i] = rand() - RAND_MAX / 2;
+        values[i] = arr[i] / 3.0;
+    }
+    cym::sort::radix_sort(arr, values, size);
+    EXPECT(is_sorted(arr, size, cym::less()))
+    EXPECT(is_sorted(values, size, cym::less()))
+    cym::sort::radix_sort(values, size, true);
+    EXPECT(is_sorted(values, size, cym::greater()))
+    cym::sort::radix_sort_in_place(arr, size, true);
+    EXPECT(is_sorted(arr, size, cym::greater()))
+    delete[] arr;
+    delete[] values;
+}
+
+/**
+ * 含有+0.0和-0.0的浮点数组排序后应是原数组的排列：与`std::sort`的结果逐项相等，
+ * -0.0的个数不变。
+ */
+template <typename T>
+void check_signed_zeros() {
+    const size_t size = 1000;
+    T* arr = new T[size];
+    T* expected = new T[size];
+    for (int round = 0; round < 3; ++round) {
+        size_t negative_zeros = 0;
+        for (size_t i = 0; i < size; ++i) {
+            const int r = rand() % 4;
+            arr[i] = r == 0   ? T(0.0)
+                     : r == 1 ? T(-0.0)
+                              : static_cast<T>(rand() % 100 - 50) / 4;
+            negative_zeros += arr[i] == 0 && std::signbit(arr[i]);
+            expected[i] = arr[i];
+        }
+        std::sort(expected, expected + size);
+        if (round == 0) {
+            cym::sort::pdq_sort(arr, arr + size);
+        } else if (round == 1) {
+            cym::sort::pdq_sort(arr, arr + size, cym::greater());
+            std::reverse(arr, arr + size);
+        } else if (!cym::simd_sort(arr, size)) {
+            std::sort(arr, arr + size);
+        }
+        size_t sorted_negative_zeros = 0;
+        for (size_t i = 0; i < size; ++i) {
+            EXPECT_EQ(arr[i], expected[i])
+            sorted_negative_zeros += arr[i] == 0 && std::signbit(arr[i]);
+        }
+        EXPECT_EQ(sorted_negative_zeros, negative_zeros)
+    }
+    delete[] arr;
+    delete[] expected;
+}
+
+void test_simd_sort() {
+    float arr[100];
+    for (size_t size = 0; size <= 100; size += 7) {
+        for (size_t i = 0; i < size; ++i) {
+            arr[i] = static_cast<float>(rand() % 200 - 100) / 8;
+        }
+        cym::sort::pdq_sort(arr, arr + size, cym::greater());
+        EXPECT(is_sorted(arr, size, cym::greater()))
+    }
+
+    // NaN被移到末尾，其余元素有序，结果仍是原数组的排列
+    double values[300];
+    double sum = 0;
+    for (size_t i = 0; i < 300; ++i) {
+        values[i] = i % 7 == 3 ? std::nan("") : static_cast<double>(rand() % 50);
+        sum += i % 7 == 3 ? 0 : values[i];
+    }
+    cym::sort::pdq_sort(values, values + 300);
+    const size_t nan_count = 43;
+    EXPECT(is_sorted(values, 300 - nan_count, cym::less()))
+    double sorted_sum = 0;
+    for (size_t i = 0; i < 300; ++i) {
+        EXPECT_EQ(std::isnan(values[i]), i >= 300 - nan_count)
+        sorted_sum += i < 300 - nan_count ? values[i] : 0;
+    }
+    EXPECT_EQ(sorted_sum, sum)
+    EXPECT(!cym::simd_sort(values, 300))
+
+    check_signed_zeros<float>();
+    check_signed_zeros<double>();
+}
+
+void test_external_sort() {
+    // 1.2MB的输入、256KB的内存预算：十几个有序段，每趟两路归并
+    const char* input = "test_external_sort.in";
+    const char* output = "test_external_sort.out";
+    const size_t size = 300000;
+    uint32_t* arr = new uint32_t[size];
+    uint32_t* sorted = new uint32_t[size];
+    for (size_t i = 0; i < size; ++i) {
+        arr[i] = static_cast<uint32_t>(rand());
+        sorted[i] = arr[i];
+    }
+    FILE* file = fopen(input, "wb");
+    EXPECT_EQ(fwrite(arr, sizeof(uint32_t), size, file), size)
+    fclose(file);
+    auto check = [&](const bool inverse) {
+        FILE* result = fopen(output, "rb");
+        EXPECT(result != nullptr)
+        EXPECT_EQ(fread(arr, sizeof(uint32_t), size, result), size)
+        EXPECT_EQ(fgetc(result), EOF)
+        fclose(result);
+        for (size_t i = 0; i < size; ++i) {
+            EXPECT_EQ(arr[i], sorted[inverse ? size - 1 - i : i])
+        }
+    };
+    cym::sort::radix_sort(sorted, size);
+    EXPECT(cym::sort::external_sort<uint32_t>(input, output, 1 << 18))
+    check(false);
+    EXPECT(cym::sort::external_sort<uint32_t>(input, output, 1 << 18,
+                                              cym::greater(), true))
+    check(true);
+    FILE* leftover = fopen((std::string(output) + ".run0.0").c_str(), "rb");
+    EXPECT(leftover == nullptr)
+
+    // 末尾不完整的记录是错误，出错时也不留下临时文件
+    file = fopen(input, "ab");
+    fputc(1, file);
+    fclose(file);
+    for (const bool use_mmap : {false, true}) {
+        EXPECT(!cym::sort::external_sort<uint32_t>(input, output, 1 << 18,
+                                                   cym::less(), use_mmap))
+        leftover = fopen((std::string(output) + ".run0.0").c_str(), "rb");
+        EXPECT(leftover == nullptr)
+    }
+    remove(input);
+    EXPECT(!cym::sort::external_sort<uint32_t>(input, output, 1 << 18))
+    remove(output);
+    delete[] arr;
+    delete[] sorted;
+}
+
+void test_select() {
+    const size_t size = 10000;
+    int* arr = new int[size];
+    for (size_t i = 0; i < size; ++i) {
+        arr[i] = static_cast<int>(size - i - 1);
+    }
+    cym::sort::select(arr, size, 1234);
+    EXPECT_EQ(arr[1234], 1234)
+    cym::sort::partial_sort(arr, size, 10, cym::greater());
+    EXPECT_EQ(arr[0], 9999)
+    EXPECT_EQ(arr[9], 9990)
+
+    cym::top_k<int, 3> top;
+    cym::top_k<int, 3> other;
+    top.push(arr, size / 2);
+    other.push(arr + size / 2, size - size / 2);
+    top.merge(other);
+    int result[3];
+    EXPECT_EQ(top.extract(result), 3)
+    EXPECT_EQ(result[0], 9999)
+    EXPECT_EQ(result[2], 9997)
+    delete[] arr;
+}
+
+void test_stable_sort() {
+    const size_t size = 20000;
+    int* arr = new int[size];
+    int* permuted = new int[size];
+    // 只比较高位，低位记录原始顺序，用于检查稳定性
+    for (size_t i = 0; i < size; ++i) {
+        arr[i] = (rand() % 100) << 20 | static_cast<int>(i);
+        permuted[i] = arr[i];
+    }
+    size_t* perm = cym::sort::argsort(arr, size, [](int a) { return a >> 20; });
+    cym::sort::permute_in_place(permuted, perm, size);
+    EXPECT(is_sorted(permuted, size, cym::less()))
+
+    cym::sort::stable_sort(arr, size, [](int a, int b) {
+        return (a >> 20) < (b >> 20);
+    });
+    EXPECT(is_sorted(arr, size, cym::less()))
+    cym::sort::stable_sort(arr, size, cym::greater());
+    EXPECT(is_sorted(arr, size, cym::greater()))
+    delete[] perm;
+    delete[] permuted;
+    delete[] arr;
+}
+
+TEST_MAIN(test_pdq_sort(); test_parallel_sort(); test_radix_sort();
+          test_simd_sort(); test_external_sort(); test_select();
+          test_stable_sort();)
@@ -0,0 +1,446 @@
+#pragma once
+
+#include "algorithm.h"
+#include "csr_graph.h"
+#include "parallel.h"
+#include "union_find.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace cym {
+
+    /**
+     * 无向图，以对称的CSR形式存储：每条边(u, v)在第u行和第v行各存一次，
+     * 自环只存一次。`edge_count()`是无向边的数量，`offsets()`等数组中的项数
+     * 即`arc_count()`。
+     *
+     * 构造和修改时边的`directed()`标记被忽略，所有边都按无向边处理。
+     * 由于存储是对称的，需要反向图的地方（如`breadth_first_search()`）可以直接传入自身。
+     */
+    class undirected_graph : public csr_graph {
+      private:
+        size_t _self_loops;
+
+        static constexpr unsigned int npos = UINT32_MAX;
+
+        void count_self_loops() {
+            _self_loops = 0;
+            const size_t* offsets = this->offsets();
+            const unsigned int* targets = this->targets();
+            for (size_t v = 0; v < vertex_count(); ++v) {
+                const size_t k = lower_bound(v, v);
+                _self_loops += k < offsets[v + 1] && targets[k] == v;
+            }
+        }
+
+        /**
+         * Afforest中把`u`和`v`所在的树连接起来：总是把编号较大的根挂到编号较小的
+         * 顶点下，因此每个顶点的标签只会变小，比较交换失败说明根已被别的线程改变，
+         * 重新查找后再试。
+         */
+        static void link(int* comp, unsigned int u, unsigned int v) {
+            int p1 = __atomic_load_n(&comp[u], __ATOMIC_RELAXED);
+            int p2 = __atomic_load_n(&comp[v], __ATOMIC_RELAXED);
+            while (p1 != p2) {
+                const int high = p1 > p2 ? p1 : p2;
+                const int low = p1 + p2 - high;
+                int p_high = __atomic_load_n(&comp[high], __ATOMIC_RELAXED);
+                if (p_high == low) {
+                    break;
+                }
+                if (p_high == high &&
+                    __atomic_compare_exchange_n(&comp[high], &p_high, low,
+                                                false, __ATOMIC_RELAXED,
+                                                __ATOMIC_RELAXED)) {
+                    break;
+                }
+                p1 = __atomic_load_n(
+                    &comp[__atomic_load_n(&comp[high], __ATOMIC_RELAXED)],
+                    __ATOMIC_RELAXED);
+                p2 = __atomic_load_n(&comp[low], __ATOMIC_RELAXED);
+            }
+        }
+
+        /**
+         * 把每个顶点直接挂到所在树的根下。
+         */
+        static void compress(int* comp, const size_t v_count, task_pool& pool) {
+            pool.parallel_for(0, v_count, 1 << 14, [&](size_t lo, size_t hi) {
+                for (size_t v = lo; v < hi; ++v) {
+                    int p = __atomic_load_n(&comp[v], __ATOMIC_RELAXED);
+                    int pp = __atomic_load_n(&comp[p], __ATOMIC_RELAXED);
+                    while (p != pp) {
+                        __atomic_store_n(&comp[v], pp, __ATOMIC_RELAXED);
+                        p = pp;
+                        pp = __atomic_load_n(&comp[p], __ATOMIC_RELAXED);
+                    }
+                }
+            });
+        }
+
+        /**
+         * 迭代的Hopcroft–Tarjan深度优先搜索，按边栈划分双连通分量。
+         * 各个输出为空时不计算对应的结果。
+         *
+         * @param labels 每条弧所在双连通分量的编号，自环为-1
+         * @param bridge 每条弧是否为桥
+         * @param articulation 每个顶点是否为割点
+         * @return 双连通分量的数量
+         */
+        size_t low_link(int* labels, int* bridge, int* articulation) const {
+            const size_t v_count = vertex_count();
+            const size_t* offsets = this->offsets();
+            const unsigned int* targets = this->targets();
+            unsigned int* disc = new unsigned int[v_count];
+            unsigned int* low = new unsigned int[v_count];
+            unsigned int* parent = new unsigned int[v_count];
+            size_t* parent_arc = new size_t[v_count];
+            size_t* next = new size_t[v_count];
+            unsigned int* stack = new unsigned int[v_count];
+            // 每条无向边在第一次被检查时压入一条弧，栈的大小不超过边数
+            size_t* arc_stack = new size_t[edge_count() + 1];
+            for (size_t v = 0; v < v_count; ++v) {
+                disc[v] = npos;
+            }
+            if (articulation != nullptr) {
+                memset(articulation, 0, sizeof(int) * v_count);
+            }
+            if (bridge != nullptr) {
+                memset(bridge, 0, sizeof(int) * arc_count());
+            }
+            if (labels != nullptr) {
+                for (size_t k = 0; k < arc_count(); ++k) {
+                    labels[k] = -1;
+                }
+            }
+
+            unsigned int time = 0;
+            size_t count = 0;
+            for (size_t root = 0; root < v_count; ++root) {
+                if (disc[root] != npos) {
+                    continue;
+                }
+                size_t top = 0;
+                size_t arc_top = 0;
+                size_t children = 0;
+                disc[root] = low[root] = time++;
+                parent[root] = npos;
+                next[root] = offsets[root];
+                stack[top++] = static_cast<unsigned int>(root);
+                while (top > 0) {
+                    const unsigned int u = stack[top - 1];
+                    if (next[u] < offsets[u + 1]) {
+                        const size_t k = next[u]++;
+                        const unsigned int w = targets[k];
+                        if (w == u || w == parent[u]) {
+                            continue;
+                        }
+                        if (disc[w] == npos) {
+                            disc[w] = low[w] = time++;
+                            parent[w] = u;
+                            parent_arc[w] = k;
+                            next[w] = offsets[w];
+                            stack[top++] = w;
+                            arc_stack[arc_top++] = k;
+                            children += u == root;
+                        } else if (disc[w] < disc[u]) {
+                            // 指向祖先的回边；反方向的弧在祖先一侧被跳过
+                            low[u] = low[u] < disc[w] ? low[u] : disc[w];
+                            arc_stack[arc_top++] = k;
+                        }
+                        continue;
+                    }
+                    top--;
+                    const unsigned int p = parent[u];
+                    if (p == npos) {
+                        continue;
+                    }
+                    low[p] = low[p] < low[u] ? low[p] : low[u];
+                    if (low[u] < disc[p]) {
+                        continue;
+                    }
+                    // 以树边p -> u结束的一段边栈构成一个双连通分量
+                    if (articulation != nullptr && p != root) {
+                        articulation[p] = 1;
+                    }
+                    if (bridge != nullptr && low[u] > disc[p]) {
+                        bridge[parent_arc[u]] = 1;
+                        bridge[lower_bound(u, p)] = 1;
+                    }
+                    size_t arc;
+                    do {
+                        arc = arc_stack[--arc_top];
+                        if (labels != nullptr) {
+                            labels[arc] = static_cast<int>(count);
+                        }
+                    } while (arc != parent_arc[u]);
+                    count++;
+                }
+                if (articulation != nullptr && children > 1) {
+                    articulation[root] = 1;
+                }
+            }
+
+            // 每条边只标记了一个方向，把编号复制到反方向的弧。按起点升序访问弧时，
+            // 第w行中的反向弧也按终点升序出现，所以每行只需一个前进的位置
+            if (labels != nullptr) {
+                memcpy(next, offsets, sizeof(size_t) * v_count);
+                for (size_t u = 0; u < v_count; ++u) {
+                    for (size_t k = offsets[u]; k < offsets[u + 1]; ++k) {
+                        const size_t reverse = next[targets[k]]++;
+                        if (labels[k] >= 0) {
+                            labels[reverse] = labels[k];
+                        }
+                    }
+                }
+            }
+            delete[] disc;
+            delete[] low;
+            delete[] parent;
+            delete[] parent_arc;
+            delete[] next;
+            delete[] stack;
+            delete[] arc_stack;
+            return count;
+        }
+
+      public:
+        /**
+         * 有`v_count`个顶点、没有边的图。
+         */
+        explicit undirected_graph(const size_t v_count)
+            : csr_graph(v_count), _self_loops(0) {}
+
+        /**
+         * 由边表构造图，每条边在两个端点的行中各存一次，其余与`csr_graph`的构造相同。
+         * 同一对顶点之间的多条边只保留权值最小的一条。
+         *
+         * @param threads 线程数，为0时使用硬件线程数
+         */
+        undirected_graph(const size_t v_count, const edge* edges,
+                         const size_t e_count, const unsigned threads = 1)
+            : csr_graph(v_count, edges, e_count, threads, true) {
+            count_self_loops();
+        }
+
+        undirected_graph(const undirected_graph& rhs) = default;
+
+        undirected_graph(undirected_graph&& rhs) noexcept = default;
+
+        undirected_graph& operator=(const undirected_graph&) = delete;
+
+        /**
+         * 设置边的权值，边不存在时插入这条边，两个方向同时修改。
+         */
+        void set_edge(const edge& edge) override {
+            const unsigned int u = edge.from();
+            const unsigned int v = edge.to();
+            if (u == v) {
+                const size_t k = lower_bound(u, u);
+                _self_loops += k == offsets()[u + 1] || targets()[k] != u;
+            }
+            csr_graph::set_edge(graph::edge(u, v, edge.weight(), true));
+            if (u != v) {
+                csr_graph::set_edge(graph::edge(v, u, edge.weight(), true));
+            }
+        }
+
+        void remove_edge(const edge& edge) override {
+            const unsigned int u = edge.from();
+            const unsigned int v = edge.to();
+            if (u == v) {
+                const size_t k = lower_bound(u, u);
+                _self_loops -= k < offsets()[u + 1] && targets()[k] == u;
+            }
+            csr_graph::remove_edge(graph::edge(u, v, 0, true));
+            if (u != v) {
+                csr_graph::remove_edge(graph::edge(v, u, 0, true));
+            }
+        }
+
+        /**
+         * 无向边的数量，自环计为一条。
+         */
+        size_t edge_count() const override {
+            return (arc_count() - _self_loops) / 2 + _self_loops;
+        }
+
+        /**
+         * CSR数组中的项数，每条非自环的边计两次。
+         */
+        size_t arc_count() const { return csr_graph::edge_count(); }
+
+        /**
+         * 用并查集求连通分量：每条边合并两个端点所在的集合，单线程，
+         * 总代价为O(E α(V))。
+         *
+         * @param count 不为空时写入连通分量的数量
+         * @return 每个顶点所在连通分量中编号最小的顶点
+         */
+        vector_t connected_components(size_t* count = nullptr) const {
+            const size_t v_count = vertex_count();
+            const size_t* offsets = this->offsets();
+            const unsigned int* targets = this->targets();
+            union_find sets(v_count);
+            for (size_t u = 0; u < v_count; ++u) {
+                for (size_t k = offsets[u]; k < offsets[u + 1]; ++k) {
+                    if (targets[k] > u) {
+                        sets.unite(u, targets[k]);
+                    }
+                }
+            }
+            // 按编号升序访问，每个集合中第一个被访问的顶点就是编号最小的顶点
+            vector_t labels({v_count});
+            int* first = new int[v_count];
+            for (size_t v = 0; v < v_count; ++v) {
+                first[v] = -1;
+            }
+            for (size_t v = 0; v < v_count; ++v) {
+                const size_t r = sets.find(v);
+                if (first[r] < 0) {
+                    first[r] = static_cast<int>(v);
+                }
+                labels(v) = first[r];
+            }
+            delete[] first;
+            if (count != nullptr) {
+                *count = sets.count();
+            }
+            return labels;
+        }
+
+        /**
+         * 多线程的Afforest算法（Sutton等）求连通分量，结果与`connected_components()`相同。
+         *
+         * 每个顶点的标签构成一个森林，连接两个顶点就是用比较交换把较大的根挂到
+         * 较小的标签下，随后压缩路径使每个顶点直接指向根。
+         * 先只处理每个顶点的前`neighbor_rounds`条边，此时大多数顶点已经进入同一个
+         * 大分量；再随机抽样找出最大的分量，已在其中的顶点跳过剩余的边，
+         * 因此通常只需要检查一小部分边。
+         *
+         * @param threads 线程数，为0时使用硬件线程数
+         * @param count 不为空时写入连通分量的数量
+         * @param neighbor_rounds 抽样前每个顶点处理的边数
+         * @return 每个顶点所在连通分量中编号最小的顶点
+         */
+        vector_t connected_components(unsigned threads, size_t* count = nullptr,
+                                      const size_t neighbor_rounds = 2) const {
+            threads = threads == 0 ? default_thread_count() : threads;
+            task_pool pool(threads);
+            const size_t v_count = vertex_count();
+            const size_t* offsets = this->offsets();
+            const unsigned int* targets = this->targets();
+            const size_t grain = 1 << 14;
+            vector_t labels({v_count});
+            int* comp = labels.data();
+            pool.parallel_for(0, v_count, grain, [&](size_t lo, size_t hi) {
+                for (size_t v = lo; v < hi; ++v) {
+                    comp[v] = static_cast<int>(v);
+                }
+            });
+
+            for (size_t r = 0; r < neighbor_rounds; ++r) {
+                pool.parallel_for(0, v_count, grain, [&](size_t lo, size_t hi) {
+                    for (size_t u = lo; u < hi; ++u) {
+                        if (offsets[u] + r < offsets[u + 1]) {
+                            link(comp, static_cast<unsigned int>(u),
+                                 targets[offsets[u] + r]);
+                        }
+                    }
+                });
+                compress(comp, v_count, pool);
+            }
+
+            // 抽样估计最大的分量，排序后找出最长的一段相同标签
+            const size_t samples = v_count < 1024 ? v_count : 1024;
+            int largest = -1;
+            if (samples > 0) {
+                int* sample = new int[samples];
+                uint64_t state = 0x9E3779B97F4A7C15ull;
+                for (size_t i = 0; i < samples; ++i) {
+                    state = state * 6364136223846793005ull +
+                            1442695040888963407ull;
+                    sample[i] = comp[(state >> 33) % v_count];
+                }
+                sort::pdq_sort(sample, sample + samples);
+                size_t best = 0;
+                size_t run = 0;
+                for (size_t i = 0; i < samples; ++i) {
+                    run = i > 0 && sample[i] == sample[i - 1] ? run + 1 : 1;
+                    if (run > best) {
+                        best = run;
+                        largest = sample[i];
+                    }
+                }
+                delete[] sample;
+            }
+
+            // 最大分量中的顶点跳过剩余的边；对称存储保证另一端会处理这些边
+            pool.parallel_for(0, v_count, grain, [&](size_t lo, size_t hi) {
+                for (size_t u = lo; u < hi; ++u) {
+                    if (__atomic_load_n(&comp[u], __ATOMIC_RELAXED) == largest) {
+                        continue;
+                    }
+                    for (size_t k = offsets[u] + neighbor_rounds;
+                         k < offsets[u + 1]; ++k) {
+                        link(comp, static_cast<unsigned int>(u), targets[k]);
+                    }
+                }
+            });
+            compress(comp, v_count, pool);
+
+            if (count != nullptr) {
+                size_t roots = 0;
+                for (size_t v = 0; v < v_count; ++v) {
+                    roots += comp[v] == static_cast<int>(v);
+                }
+                *count = roots;
+            }
+            return labels;
+        }
+
+        /**
+         * 双连通分量：每条边恰好属于一个分量，同一分量中的任意两条边都在某个简单环上。
+         * 使用迭代的Hopcroft–Tarjan算法，单线程，O(V + E)。
+         *
+         * @param count 不为空时写入双连通分量的数量
+         * @param articulation 不为空时写入每个顶点是否为割点（1或0）
+         * @return 每条弧（与`targets()`的下标对应）所在分量的编号，两个方向相同；
+         *         自环不属于任何分量，为-1
+         */
+        vector_t biconnected_components(size_t* count = nullptr,
+                                        vector_t* articulation = nullptr) const {
+            vector_t labels({arc_count() > 0 ? arc_count() : 1});
+            int* cut = nullptr;
+            if (articulation != nullptr) {
+                *articulation = vector_t({vertex_count()});
+                cut = articulation->data();
+            }
+            const size_t components = low_link(labels.data(), nullptr, cut);
+            if (count != nullptr) {
+                *count = components;
+            }
+            return labels;
+        }
+
+        /**
+         * 桥：删除后使连通分量增加的边。
+         *
+         * @param count 不为空时写入桥的数量（无向边的数量）
+         * @return 每条弧（与`targets()`的下标对应）是否为桥（1或0），两个方向相同
+         */
+        vector_t bridges(size_t* count = nullptr) const {
+            vector_t flags({arc_count() > 0 ? arc_count() : 1});
+            low_link(nullptr, flags.data(), nullptr);
+            if (count != nullptr) {
+                size_t arcs = 0;
+                for (size_t k = 0; k < arc_count(); ++k) {
+                    arcs += flags(k);
+                }
+                *count = arcs / 2;
+            }
+            return flags;
+        }
+    };
+} // namespace cym
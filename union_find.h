@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+namespace cym {
+
+    /**
+     * 并查集，元素为0到size-1之间的整数，初始时每个元素自成一个集合。
+     *
+     * 按秩合并使树高不超过log n，`find()`再把查找路径上的元素直接挂到根下，
+     * 一串操作的均摊代价为O(α(n))。
+     */
+    class union_find {
+      private:
+        size_t _size;
+        size_t _count;
+        size_t* _parent;
+        unsigned char* _rank;
+
+      public:
+        explicit union_find(const size_t size)
+            : _size(size), _count(size), _parent(new size_t[size]),
+              _rank(new unsigned char[size]()) {
+            for (size_t i = 0; i < size; ++i) {
+                _parent[i] = i;
+            }
+        }
+
+        union_find(const union_find& rhs)
+            : _size(rhs._size), _count(rhs._count),
+              _parent(new size_t[rhs._size]),
+              _rank(new unsigned char[rhs._size]) {
+            memcpy(_parent, rhs._parent, sizeof(size_t) * _size);
+            memcpy(_rank, rhs._rank, _size);
+        }
+
+        union_find(union_find&& rhs) noexcept
+            : _size(rhs._size), _count(rhs._count), _parent(rhs._parent),
+              _rank(rhs._rank) {
+            rhs._size = 0;
+            rhs._count = 0;
+            rhs._parent = nullptr;
+            rhs._rank = nullptr;
+        }
+
+        union_find& operator=(const union_find&) = delete;
+
+        ~union_find() {
+            delete[] _parent;
+            delete[] _rank;
+        }
+
+        /**
+         * 元素的数量。
+         */
+        size_t size() const { return _size; }
+
+        /**
+         * 集合的数量。
+         */
+        size_t count() const { return _count; }
+
+        /**
+         * `x`所在集合的代表元素，同时压缩查找路径。
+         */
+        size_t find(const size_t x) {
+            size_t r = x;
+            while (_parent[r] != r) {
+                r = _parent[r];
+            }
+            for (size_t i = x; _parent[i] != r;) {
+                const size_t next = _parent[i];
+                _parent[i] = r;
+                i = next;
+            }
+            return r;
+        }
+
+        /**
+         * 与`find()`相同，但不压缩路径。只读，多个线程可以同时调用。
+         */
+        size_t root(size_t x) const {
+            while (_parent[x] != x) {
+                x = _parent[x];
+            }
+            return x;
+        }
+
+        /**
+         * 合并`a`和`b`所在的集合，两者原本就在同一个集合中时返回false。
+         */
+        bool unite(const size_t a, const size_t b) {
+            size_t ra = find(a);
+            size_t rb = find(b);
+            if (ra == rb) {
+                return false;
+            }
+            if (_rank[ra] < _rank[rb]) {
+                const size_t t = ra;
+                ra = rb;
+                rb = t;
+            }
+            _parent[rb] = ra;
+            if (_rank[ra] == _rank[rb]) {
+                _rank[ra]++;
+            }
+            _count--;
+            return true;
+        }
+
+        bool same(const size_t a, const size_t b) { return find(a) == find(b); }
+
+        /**
+         * 恢复为每个元素自成一个集合。
+         */
+        void reset() {
+            for (size_t i = 0; i < _size; ++i) {
+                _parent[i] = i;
+            }
+            memset(_rank, 0, _size);
+            _count = _size;
+        }
+    };
+} // namespace cym
@@ -53,10 +53,17 @@ namespace cym {
 
         T& at(const int pos) { return operator[](pos); }
 
+        /**
+         * 容量翻倍。新缓冲区与构造时一样由`new T[]`分配，析构时的`delete[]`才能与之匹配。
+         */
         void resize() {
+            T* el = new T[size_ * 2];
+            for (size_t i = 0; i < size_; ++i) {
+                el[i] = el_[i];
+            }
+            delete[] el_;
+            el_ = el;
             size_ *= 2;
-            el_ = static_cast<T*>(
-                realloc(static_cast<void*>(el_), size_ * sizeof(T)));
         }
 
       private: